@@ -0,0 +1,734 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // For sched_setaffinity, sched_getcpu, syscall
+#endif
+
+#include "bench.h"
+#include "../include/memory.h"
+#include "../include/sort.h"
+#include "../include/utils.h"
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Upper bound of the calibrated iteration count.
+ */
+#define BENCH_MAX_ITERATIONS (1ull << 40)
+
+/* ============================================================================
+ *  TIMING
+ * ============================================================================
+ */
+
+/**
+ * @brief Monotonic time in nanoseconds.
+ */
+static u64 now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+/**
+ * @brief Times one call of the benchmark.
+ */
+static u64 time_run(const Bench_Case *bench, u64 iterations)
+{
+    u64 start = now_ns();
+    bench->run(bench->context, iterations);
+    return now_ns() - start;
+}
+
+/**
+ * @brief Nearest-rank percentile of sorted values.
+ */
+static f64 percentile(const f64 *sorted, usize count, f64 fraction)
+{
+    return sorted[(usize)(fraction * (f64)(count - 1) + 0.5)];
+}
+
+/* ============================================================================
+ *  HARDWARE COUNTERS
+ * ============================================================================
+ */
+
+/**
+ * @brief perf_event_attr.config of a generalized cache event.
+ */
+#define CACHE_EVENT(cache, operation, outcome)                                 \
+    (PERF_COUNT_HW_CACHE_##cache | PERF_COUNT_HW_CACHE_OP_##operation << 8 |  \
+     PERF_COUNT_HW_CACHE_RESULT_##outcome << 16)
+
+static const struct
+{
+        u32 type;
+        u64 config;
+        const char *name;
+} counter_events[BENCH_COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HW_CACHE, CACHE_EVENT(L1D, READ, MISS), "l1d_misses"},
+    {PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, READ, MISS), "llc_misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses"},
+    {PERF_TYPE_HW_CACHE, CACHE_EVENT(DTLB, READ, MISS), "dtlb_misses"},
+};
+
+/**
+ * @brief One perf event file descriptor per counter (-1: unavailable).
+ */
+typedef struct
+{
+        int fds[BENCH_COUNTER_COUNT];
+} Counter_Set;
+
+/**
+ * @brief Opens every counter on the calling thread, disabled.
+ *
+ * Events the kernel refuses (no PMU, perf_event_paranoid, unsupported
+ * event) are left out; the benchmark then runs without them.
+ */
+static void counters_open(Counter_Set *set)
+{
+    for(usize i = 0; i < BENCH_COUNTER_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counter_events[i].type;
+        attr.config = counter_events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format =
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        set->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+/**
+ * @brief Starts or stops every open counter.
+ */
+static void counters_enable(Counter_Set *set, bool enable)
+{
+    for(usize i = 0; i < BENCH_COUNTER_COUNT; i++)
+        if(set->fds[i] >= 0)
+            ioctl(set->fds[i],
+                  enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+}
+
+/**
+ * @brief Reads the counts per operation and closes the counters.
+ *
+ * A count is scaled by enabled / running time when the kernel had to
+ * multiplex more events than the PMU has counters.
+ */
+static void counters_close(Counter_Set *set, f64 operations,
+                           Bench_Counters *counters)
+{
+    *counters = (Bench_Counters){0};
+    for(usize i = 0; i < BENCH_COUNTER_COUNT; i++)
+    {
+        if(set->fds[i] < 0)
+            continue;
+        u64 reading[3] = {0}; // Value, time enabled, time running
+        if(read(set->fds[i], reading, sizeof(reading)) ==
+               (ssize_t)sizeof(reading) &&
+           reading[2] > 0)
+        {
+            f64 scale = (f64)reading[1] / (f64)reading[2];
+            counters->per_op[i] = (f64)reading[0] * scale / operations;
+            counters->available |= 1u << i;
+        }
+        close(set->fds[i]);
+    }
+}
+
+/* ============================================================================
+ *  RUNNING
+ * ============================================================================
+ */
+
+/**
+ * @brief Pins the calling thread to one CPU.
+ */
+Result bench_pin(i32 requested, i32 *cpu)
+{
+    DS_ASSERT(cpu != NULL, "CPU must not be NULL");
+
+    i32 chosen = requested >= 0 ? requested : sched_getcpu();
+    if(chosen < 0 || chosen >= CPU_SETSIZE)
+        return RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT, "Invalid CPU");
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(chosen, &set);
+    if(sched_setaffinity(0, sizeof(set), &set) != 0)
+        return RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT,
+                            "Failed to pin thread to CPU");
+    *cpu = chosen;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Calibrates, warms up and measures one benchmark.
+ */
+Result bench_run(const Bench_Case *bench, Bench_Options options,
+                 Bench_Result *result)
+{
+    DS_ASSERT(bench != NULL && bench->run != NULL && result != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(options.samples > 0, "At least one sample is needed");
+
+    // Double the iteration count until a run is long enough to time
+    // reliably, then scale it to the requested sample duration.
+    u64 target = (u64)options.sample_ms * 1000000ull;
+    u64 iterations = 1;
+    u64 elapsed = time_run(bench, iterations);
+    while(elapsed < target / 10 && iterations < BENCH_MAX_ITERATIONS)
+    {
+        iterations *= 2;
+        elapsed = time_run(bench, iterations);
+    }
+    if(elapsed > 0 && elapsed < target)
+        iterations = (u64)((f64)iterations * (f64)target / (f64)elapsed);
+
+    u64 warmup_end = now_ns() + (u64)options.warmup_ms * 1000000ull;
+    while(now_ns() < warmup_end)
+        time_run(bench, iterations);
+
+    f64 *samples = ALLOC_ARRAY(f64, options.samples);
+    if(!samples)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate samples");
+
+    Counter_Set set;
+    counters_open(&set);
+    Memory_Stats before = ds_get_memory_stats();
+    counters_enable(&set, true);
+    for(u32 i = 0; i < options.samples; i++)
+        samples[i] = (f64)time_run(bench, iterations) / (f64)iterations;
+    counters_enable(&set, false);
+    Memory_Stats after = ds_get_memory_stats();
+
+    qsort(samples, options.samples, sizeof(f64), compare_double);
+    f64 sum = 0;
+    for(u32 i = 0; i < options.samples; i++)
+        sum += samples[i];
+
+    f64 operations = (f64)iterations * (f64)options.samples;
+    *result = (Bench_Result){0};
+    counters_close(&set, operations, &result->counters);
+    result->name = bench->name;
+    result->iterations = iterations;
+    result->samples = options.samples;
+    result->mean_ns = sum / (f64)options.samples;
+    result->min_ns = samples[0];
+    result->p50_ns = percentile(samples, options.samples, 0.50);
+    result->p90_ns = percentile(samples, options.samples, 0.90);
+    result->p99_ns = percentile(samples, options.samples, 0.99);
+    result->max_ns = samples[options.samples - 1];
+    result->bytes_per_op =
+        (f64)(after.total_allocated - before.total_allocated) / operations;
+    result->allocs_per_op =
+        (f64)(after.allocation_count - before.allocation_count) / operations;
+    if(bench->bytes_per_op > 0 && result->p50_ns > 0)
+        result->mb_per_s = (f64)bench->bytes_per_op * 1e3 / result->p50_ns;
+
+    ds_free(samples);
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  REPORTS
+ * ============================================================================
+ */
+
+/**
+ * @brief Prints the column titles of the hardware counters and ends the
+ *        header line.
+ */
+static void print_counter_header(FILE *stream)
+{
+    fprintf(stream, " %9s %5s %8s %8s %8s %8s\n", "cycles/op", "IPC",
+            "L1D-miss", "LLC-miss", "br-miss", "TLB-miss");
+}
+
+/**
+ * @brief Prints the hardware counters of a row ("-" where unavailable)
+ *        and ends the line.
+ */
+static void print_counters(FILE *stream, const Bench_Counters *counters)
+{
+    static const int widths[BENCH_COUNTER_COUNT] = {9, 5, 8, 8, 8, 8};
+    const u32 ipc = 1u << BENCH_CYCLES | 1u << BENCH_INSTRUCTIONS;
+    for(usize i = 0; i < BENCH_COUNTER_COUNT; i++)
+    {
+        f64 value = counters->per_op[i];
+        bool available = counters->available & 1u << i;
+        if(i == BENCH_INSTRUCTIONS) // Shown as instructions per cycle
+        {
+            available = (counters->available & ipc) == ipc &&
+                        counters->per_op[BENCH_CYCLES] > 0;
+            if(available)
+                value /= counters->per_op[BENCH_CYCLES];
+        }
+        if(available)
+            fprintf(stream, " %*.*f", widths[i], i == BENCH_CYCLES ? 1 : 2,
+                    value);
+        else
+            fprintf(stream, " %*s", widths[i], "-");
+    }
+    fputc('\n', stream);
+}
+
+/**
+ * @brief Prints the column titles of the result table.
+ */
+void bench_print_header(FILE *stream)
+{
+    fprintf(stream, "%-32s %10s %10s %10s %10s %10s %9s %9s", "benchmark",
+            "p50 ns/op", "mean", "min", "p99", "MB/s", "B/op", "allocs/op");
+    print_counter_header(stream);
+}
+
+/**
+ * @brief Prints one row of the result table.
+ */
+void bench_print_result(FILE *stream, const Bench_Result *result)
+{
+    fprintf(stream, "%-32s %10.2f %10.2f %10.2f %10.2f %10.1f %9.1f %9.3f",
+            result->name, result->p50_ns, result->mean_ns, result->min_ns,
+            result->p99_ns, result->mb_per_s, result->bytes_per_op,
+            result->allocs_per_op);
+    print_counters(stream, &result->counters);
+}
+
+/**
+ * @brief Writes a string as a JSON string literal.
+ */
+static void write_json_string(FILE *stream, const char *text)
+{
+    fputc('"', stream);
+    for(; *text; text++)
+    {
+        if(*text == '"' || *text == '\\')
+            fputc('\\', stream);
+        if((unsigned char)*text >= 0x20)
+            fputc(*text, stream);
+    }
+    fputc('"', stream);
+}
+
+/**
+ * @brief Writes the hardware counters per operation as a JSON object
+ *        (null where unavailable).
+ */
+static void write_json_counters(FILE *stream, const Bench_Counters *counters)
+{
+    fprintf(stream, ", \"counters_per_op\": {");
+    for(usize i = 0; i < BENCH_COUNTER_COUNT; i++)
+    {
+        fprintf(stream, "%s\"%s\": ", i > 0 ? ", " : "",
+                counter_events[i].name);
+        if(counters->available & 1u << i)
+            fprintf(stream, "%.4f", counters->per_op[i]);
+        else
+            fprintf(stream, "null");
+    }
+    fprintf(stream, "}}");
+}
+
+/**
+ * @brief Opens the JSON report: the suite, the run parameters and the
+ *        start of the result list.
+ */
+static void write_json_context(FILE *stream, const char *suite,
+                               Bench_Options options, i32 cpu)
+{
+    fprintf(stream, "{\n  \"suite\": ");
+    write_json_string(stream, suite);
+    fprintf(stream,
+            ",\n  \"context\": {\"cpu\": %d, \"samples\": %u, "
+            "\"sample_ms\": %u, \"warmup_ms\": %u, \"operations\": %u},"
+            "\n  \"benchmarks\": [",
+            cpu, options.samples, options.sample_ms, options.warmup_ms,
+            options.operations);
+}
+
+/**
+ * @brief Writes every result, with the run parameters, as one JSON object.
+ */
+void bench_write_json(FILE *stream, const char *suite,
+                      const Bench_Result *results, usize count,
+                      Bench_Options options, i32 cpu)
+{
+    write_json_context(stream, suite, options, cpu);
+
+    for(usize i = 0; i < count; i++)
+    {
+        const Bench_Result *result = &results[i];
+        fprintf(stream, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        write_json_string(stream, result->name);
+        fprintf(stream,
+                ", \"iterations\": %llu, \"samples\": %u, "
+                "\"ns_per_op\": {\"mean\": %.3f, \"min\": %.3f, "
+                "\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+                "\"max\": %.3f}, \"bytes_per_op\": %.3f, "
+                "\"allocs_per_op\": %.4f, \"mb_per_s\": %.1f",
+                (unsigned long long)result->iterations, result->samples,
+                result->mean_ns, result->min_ns, result->p50_ns,
+                result->p90_ns, result->p99_ns, result->max_ns,
+                result->bytes_per_op, result->allocs_per_op,
+                result->mb_per_s);
+        write_json_counters(stream, &result->counters);
+    }
+    fprintf(stream, "\n  ]\n}\n");
+}
+
+/* ============================================================================
+ *  COMMAND LINE
+ * ============================================================================
+ */
+
+/**
+ * @brief Parses an unsigned option value.
+ */
+static bool parse_u32(const char *text, u32 *value)
+{
+    char *end = NULL;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if(*text == '\0' || *end != '\0' || parsed > 0xFFFFFFFFul)
+        return false;
+    *value = (u32)parsed;
+    return true;
+}
+
+/**
+ * @brief Matches "--name=value" and returns the value, or NULL.
+ */
+static const char *option_value(const char *argument, const char *name)
+{
+    usize length = strlen(name);
+    if(strncmp(argument, name, length) != 0 || argument[length] != '=')
+        return NULL;
+    return argument + length + 1;
+}
+
+/**
+ * @brief Reads the harness options from the command line.
+ */
+Result bench_parse_args(int argc, char **argv, Bench_Options *options)
+{
+    DS_ASSERT(options != NULL, "Options must not be NULL");
+
+    for(int i = 1; i < argc; i++)
+    {
+        const char *value = NULL;
+        u32 number = 0;
+        bool valid = true;
+        if((value = option_value(argv[i], "--samples")))
+            valid = parse_u32(value, &options->samples) && options->samples;
+        else if((value = option_value(argv[i], "--sample-ms")))
+            valid = parse_u32(value, &options->sample_ms);
+        else if((value = option_value(argv[i], "--warmup-ms")))
+            valid = parse_u32(value, &options->warmup_ms);
+        else if((value = option_value(argv[i], "--operations")))
+            valid = parse_u32(value, &options->operations) &&
+                    options->operations;
+        else if((value = option_value(argv[i], "--cpu")))
+        {
+            valid = parse_u32(value, &number) && number < CPU_SETSIZE;
+            options->cpu = (i32)number;
+        }
+        else if((value = option_value(argv[i], "--filter")))
+            options->filter = value;
+        else if((value = option_value(argv[i], "--json")))
+            options->json_path = value;
+        else
+            valid = false;
+
+        if(!valid)
+        {
+            fprintf(stderr,
+                    "usage: %s [--samples=N] [--sample-ms=N] "
+                    "[--warmup-ms=N] [--operations=N] [--cpu=N] "
+                    "[--filter=TEXT] [--json=PATH]\n",
+                    argv[0]);
+            return RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT,
+                                "Invalid benchmark option");
+        }
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Parses the command line and pins the benchmarking thread.
+ */
+static Result start_suite(int argc, char **argv, Bench_Options *options,
+                          i32 *cpu)
+{
+    CHECK_RESULT(bench_parse_args(argc, argv, options));
+    return bench_pin(options->cpu, cpu);
+}
+
+/**
+ * @brief Creates the JSON report file, if one was requested.
+ */
+static Result open_report(const char *path, FILE **stream)
+{
+    *stream = NULL;
+    if(path && !(*stream = fopen(path, "w")))
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to create JSON file");
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Closes the JSON report file, if any.
+ */
+static Result close_report(FILE *stream)
+{
+    if(stream && fclose(stream) != 0)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to write JSON");
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Reports a failed suite and converts the outcome to an exit status.
+ */
+static int finish_suite(const char *suite, Result result)
+{
+    if(result_is_success(result))
+        return 0;
+    fprintf(stderr, "%s: %s\n", suite, result_context(result).message);
+    return 1;
+}
+
+/**
+ * @brief Tells once per suite (after its first result) that some hardware
+ *        counters could not be read, since their columns only show "-".
+ */
+static void note_counters(usize ran, const Bench_Counters *counters)
+{
+    if(ran == 1 && counters->available != (1u << BENCH_COUNTER_COUNT) - 1)
+        fprintf(stderr, "note: some hardware counters are unavailable (no "
+                        "PMU, or see /proc/sys/kernel/perf_event_paranoid)\n");
+}
+
+/**
+ * @brief Runs a suite of benchmarks as a program.
+ */
+int bench_main(const char *suite, const Bench_Case *cases, usize count,
+               int argc, char **argv)
+{
+    Bench_Options options = BENCH_DEFAULT_OPTIONS;
+    i32 cpu = -1;
+    Result result = start_suite(argc, argv, &options, &cpu);
+
+    Bench_Result *results = ALLOC_ARRAY(Bench_Result, count ? count : 1);
+    if(result_is_success(result) && !results)
+        result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                              "Failed to allocate results");
+
+    usize ran = 0;
+    if(result_is_success(result))
+        bench_print_header(stdout);
+    for(usize i = 0; result_is_success(result) && i < count; i++)
+    {
+        if(options.filter && !strstr(cases[i].name, options.filter))
+            continue;
+        result = bench_run(&cases[i], options, &results[ran]);
+        if(result_is_success(result))
+        {
+            bench_print_result(stdout, &results[ran++]);
+            fflush(stdout);
+            note_counters(ran, &results[0].counters);
+        }
+    }
+
+    FILE *json = NULL;
+    if(result_is_success(result))
+        result = open_report(options.json_path, &json);
+    if(result_is_success(result) && json)
+    {
+        bench_write_json(json, suite, results, ran, options, cpu);
+        result = close_report(json);
+    }
+
+    ds_free(results);
+    return finish_suite(suite, result);
+}
+
+/* ============================================================================
+ *  WORKLOADS
+ * ============================================================================
+ */
+
+/**
+ * @brief Loads a workload, warms it up and times every operation.
+ */
+Result bench_run_workload(const Workload_Case *workload, Bench_Options options,
+                          Workload_Result *result)
+{
+    DS_ASSERT(workload != NULL && workload->run != NULL && result != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(options.operations > 0, "At least one operation is needed");
+
+    u64Array latencies = {0};
+    CHECK_RESULT(ARRAY_RESERVE(&latencies, options.operations));
+
+    Memory_Stats before = ds_get_memory_stats();
+    Result status = workload->setup ? workload->setup(workload->context)
+                                    : RESULT_SUCCESS;
+
+    u64 warmup = options.operations / 10;
+    for(u64 i = 0; result_is_success(status) && i < warmup; i++)
+        status = workload->run(workload->context, i);
+
+    Counter_Set set;
+    counters_open(&set);
+    counters_enable(&set, true);
+    u64 start = now_ns();
+    for(u64 i = 0; result_is_success(status) && i < options.operations; i++)
+    {
+        u64 begin = now_ns();
+        status = workload->run(workload->context, warmup + i);
+        latencies.data[latencies.size++] = now_ns() - begin;
+    }
+    u64 elapsed = now_ns() - start;
+    counters_enable(&set, false);
+    Memory_Stats after = ds_get_memory_stats();
+
+    Bench_Counters counters;
+    counters_close(&set, (f64)(latencies.size ? latencies.size : 1),
+                   &counters);
+
+    if(workload->teardown)
+        workload->teardown(workload->context);
+    if(result_is_success(status))
+        status = ds_parallel_sort_u64(&latencies);
+
+    if(result_is_success(status))
+    {
+        u64 total = 0;
+        for(usize i = 0; i < latencies.size; i++)
+            total += latencies.data[i];
+
+        f64 sorted_count = (f64)(latencies.size - 1);
+        const u64 *sorted = latencies.data;
+        *result = (Workload_Result){0};
+        result->name = workload->name;
+        result->operations = latencies.size;
+        result->seconds = (f64)elapsed * 1e-9;
+        result->ops_per_s = (f64)latencies.size / result->seconds;
+        result->mean_ns = (f64)total / (f64)latencies.size;
+        result->p50_ns = (f64)sorted[(usize)(0.50 * sorted_count + 0.5)];
+        result->p99_ns = (f64)sorted[(usize)(0.99 * sorted_count + 0.5)];
+        result->p999_ns = (f64)sorted[(usize)(0.999 * sorted_count + 0.5)];
+        result->max_ns = (f64)sorted[latencies.size - 1];
+        result->memory_bytes = after.current_usage > before.current_usage
+                                   ? after.current_usage - before.current_usage
+                                   : 0;
+        result->counters = counters;
+    }
+    ds_free(latencies.data);
+    return status;
+}
+
+/**
+ * @brief Prints the column titles of the workload table.
+ */
+void bench_print_workload_header(FILE *stream)
+{
+    fprintf(stream, "%-28s %11s %9s %9s %9s %10s %10s", "workload", "ops/s",
+            "mean ns", "p50", "p99", "p999", "live KiB");
+    print_counter_header(stream);
+}
+
+/**
+ * @brief Prints one row of the workload table.
+ */
+void bench_print_workload_result(FILE *stream, const Workload_Result *result)
+{
+    fprintf(stream, "%-28s %11.0f %9.1f %9.0f %9.0f %10.0f %10.1f",
+            result->name, result->ops_per_s, result->mean_ns, result->p50_ns,
+            result->p99_ns, result->p999_ns,
+            (f64)result->memory_bytes / 1024.0);
+    print_counters(stream, &result->counters);
+}
+
+/**
+ * @brief Writes every workload result as one JSON object.
+ */
+void bench_write_workload_json(FILE *stream, const char *suite,
+                               const Workload_Result *results, usize count,
+                               Bench_Options options, i32 cpu)
+{
+    write_json_context(stream, suite, options, cpu);
+    for(usize i = 0; i < count; i++)
+    {
+        const Workload_Result *result = &results[i];
+        fprintf(stream, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        write_json_string(stream, result->name);
+        fprintf(stream,
+                ", \"operations\": %llu, \"seconds\": %.6f, "
+                "\"ops_per_s\": %.1f, \"latency_ns\": {\"mean\": %.1f, "
+                "\"p50\": %.0f, \"p99\": %.0f, \"p999\": %.0f, "
+                "\"max\": %.0f}, \"memory_bytes\": %zu",
+                (unsigned long long)result->operations, result->seconds,
+                result->ops_per_s, result->mean_ns, result->p50_ns,
+                result->p99_ns, result->p999_ns, result->max_ns,
+                result->memory_bytes);
+        write_json_counters(stream, &result->counters);
+    }
+    fprintf(stream, "\n  ]\n}\n");
+}
+
+/**
+ * @brief Runs a suite of workloads as a program.
+ */
+int bench_workload_main(const char *suite, const Workload_Case *cases,
+                        usize count, int argc, char **argv)
+{
+    Bench_Options options = BENCH_DEFAULT_OPTIONS;
+    i32 cpu = -1;
+    Result result = start_suite(argc, argv, &options, &cpu);
+
+    Workload_Result *results = ALLOC_ARRAY(Workload_Result, count ? count : 1);
+    if(result_is_success(result) && !results)
+        result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                              "Failed to allocate results");
+
+    usize ran = 0;
+    if(result_is_success(result))
+        bench_print_workload_header(stdout);
+    for(usize i = 0; result_is_success(result) && i < count; i++)
+    {
+        if(options.filter && !strstr(cases[i].name, options.filter))
+            continue;
+        result = bench_run_workload(&cases[i], options, &results[ran]);
+        if(result_is_success(result))
+        {
+            bench_print_workload_result(stdout, &results[ran++]);
+            fflush(stdout);
+            note_counters(ran, &results[0].counters);
+        }
+    }
+
+    FILE *json = NULL;
+    if(result_is_success(result))
+        result = open_report(options.json_path, &json);
+    if(result_is_success(result) && json)
+    {
+        bench_write_workload_json(json, suite, results, ran, options, cpu);
+        result = close_report(json);
+    }
+
+    ds_free(results);
+    return finish_suite(suite, result);
+}
@@ -0,0 +1,239 @@
+#ifndef DATA_STRUCTURES_BENCH_H
+#define DATA_STRUCTURES_BENCH_H
+
+// ============================================================================
+// File: bench.h
+// Description:
+//     Minimal benchmark harness producing reproducible numbers.
+//
+//     Each benchmark is a function running its operation a given number of
+//     times. The harness pins the calling thread to one CPU, calibrates the
+//     iteration count so that a sample lasts about 'sample_ms', warms up
+//     (caches, branch predictors, page faults, CPU frequency), then times
+//     'samples' samples. It reports nanoseconds per operation (mean, min,
+//     percentiles over the samples) and the bytes and allocations per
+//     operation seen by Memory_Stats, as a table and optionally as JSON for
+//     regression tracking. Where the kernel allows it, hardware counters
+//     (cycles, instructions, cache, branch and TLB misses) are read around
+//     the timed samples too, so that a regression can be attributed
+//     without running perf by hand.
+//
+//     Workloads drive a container with a stream of operations instead:
+//     after an untimed load phase every operation is timed on its own,
+//     giving throughput, latency percentiles and the memory growth seen by
+//     Memory_Stats.
+//
+//     Build (from the repository root):
+//         make bench
+//     Run:
+//         ./build/ds_micro_bench --json=micro.json --filter=memcpy
+//     The workload suite is built alongside, as build/ds_workload_bench.
+// ============================================================================
+
+#include "../include/error.h" // For Result
+#include "../include/types.h" // For u64, f64, ptr
+#include <stdio.h>
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Benchmark cases.
+// ---------------------------------------------------------------------------
+// bench_fn runs the measured operation 'iterations' times. Setup work
+// belongs outside of it (in the context), since everything it does is
+// timed.
+//
+// Bench_Case fields:
+//   name         -> Unique name, used by --filter and in the reports.
+//   run          -> The benchmark.
+//   context      -> Passed to 'run'.
+//   bytes_per_op -> Bytes processed per operation, for a throughput
+//                   column (0 if meaningless).
+//
+// bench_do_not_optimize() forces a value to be computed (and memory to be
+// written) without costing more than a register move.
+//
+// bench_random() is a SplitMix64 generator, so that every run of a
+// benchmark sees the same inputs for the same seed.
+
+typedef void (*bench_fn)(ptr context, u64 iterations);
+
+typedef struct
+{
+        const char *name;
+        bench_fn run;
+        ptr context;
+        usize bytes_per_op;
+} Bench_Case;
+
+static inline void bench_do_not_optimize(cptr value)
+{
+    __asm__ volatile("" : : "r"(value) : "memory");
+}
+
+static inline u64 bench_random(u64 *state)
+{
+    u64 value = (*state += 0x9E3779B97F4A7C15ull);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Options and results.
+// ---------------------------------------------------------------------------
+// Bench_Options:
+//   samples   -> Timed samples per benchmark.
+//   sample_ms -> Target duration of a sample.
+//   warmup_ms -> Untimed run before the samples.
+//   operations -> Timed operations per workload (after as many tenths
+//                untimed to warm up).
+//   cpu       -> CPU to pin the benchmarking thread to (-1: the one it is
+//                running on when the harness starts).
+//   filter    -> Only run benchmarks whose name contains it (NULL: all).
+//   json_path -> Also write the results there as JSON (NULL: no JSON).
+//
+// Bench_Result: per-operation figures over the timed samples.
+//
+// Bench_Counters: hardware events per operation, read with
+// perf_event_open() (user space only). 'available' has bit 1 << counter
+// set for every event the kernel and CPU could count; the others are 0
+// (see /proc/sys/kernel/perf_event_paranoid, and virtual machines often
+// expose no PMU at all). Counts are scaled when the kernel had to
+// multiplex the events.
+
+typedef enum
+{
+    BENCH_CYCLES,
+    BENCH_INSTRUCTIONS,
+    BENCH_L1D_MISSES,
+    BENCH_LLC_MISSES,
+    BENCH_BRANCH_MISSES,
+    BENCH_DTLB_MISSES,
+    BENCH_COUNTER_COUNT
+} Bench_Counter;
+
+typedef struct
+{
+        f64 per_op[BENCH_COUNTER_COUNT];
+        u32 available;
+} Bench_Counters;
+
+typedef struct
+{
+        u32 samples;
+        u32 sample_ms;
+        u32 warmup_ms;
+        u32 operations;
+        i32 cpu;
+        const char *filter;
+        const char *json_path;
+} Bench_Options;
+
+#define BENCH_DEFAULT_OPTIONS                                                  \
+    ((Bench_Options){31, 10, 200, 200000, -1, NULL, NULL})
+
+typedef struct
+{
+        const char *name;
+        u64 iterations; // Per sample
+        u32 samples;
+        f64 mean_ns;
+        f64 min_ns;
+        f64 p50_ns;
+        f64 p90_ns;
+        f64 p99_ns;
+        f64 max_ns;
+        f64 bytes_per_op;  // Allocated (Memory_Stats)
+        f64 allocs_per_op; // Allocation calls (Memory_Stats)
+        f64 mb_per_s;      // From Bench_Case.bytes_per_op
+        Bench_Counters counters;
+} Bench_Result;
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Running.
+// ---------------------------------------------------------------------------
+// bench_parse_args():
+//     Reads --samples=N, --sample-ms=N, --warmup-ms=N, --operations=N,
+//     --cpu=N, --filter=TEXT and --json=PATH into 'options'. Fails with
+//     DS_ERROR_INVALID_ARGUMENT on anything else (after printing usage).
+//
+// bench_pin():
+//     Pins the calling thread to a CPU (see Bench_Options.cpu) and stores
+//     the chosen CPU in 'cpu'.
+//
+// bench_run():
+//     Measures one case.
+//
+// bench_main():
+//     Parses the arguments, pins the thread, runs every selected case and
+//     writes the reports. Returns the process exit status.
+
+Result bench_parse_args(int argc, char **argv, Bench_Options *options);
+Result bench_pin(i32 requested, i32 *cpu);
+Result bench_run(const Bench_Case *bench, Bench_Options options,
+                 Bench_Result *result);
+
+void bench_print_header(FILE *stream);
+void bench_print_result(FILE *stream, const Bench_Result *result);
+void bench_write_json(FILE *stream, const char *suite,
+                      const Bench_Result *results, usize count,
+                      Bench_Options options, i32 cpu);
+
+int bench_main(const char *suite, const Bench_Case *cases, usize count,
+               int argc, char **argv);
+
+// ---------------------------------------------------------------------------
+// SECTION 4: Workloads.
+// ---------------------------------------------------------------------------
+// Workload_Case fields:
+//   setup    -> Load phase (untimed): builds the container.
+//   run      -> Performs operation 'index' of the run phase (indices keep
+//               counting through the warm-up and the timed operations).
+//   teardown -> Releases the container (may be NULL).
+//
+// Workload_Result:
+//   ops_per_s      -> Throughput over the timed operations.
+//   p50/p99/p999   -> Latency percentiles of single operations (each one
+//                     is timed, which adds the cost of reading the clock).
+//   memory_bytes   -> Growth of Memory_Stats.current_usage over the load
+//                     and run phases: the live memory of the container
+//                     before teardown.
+//
+// bench_workload_main() is bench_main() for workloads.
+
+typedef struct
+{
+        const char *name;
+        Result (*setup)(ptr context);
+        Result (*run)(ptr context, u64 index);
+        void (*teardown)(ptr context);
+        ptr context;
+} Workload_Case;
+
+typedef struct
+{
+        const char *name;
+        u64 operations;
+        f64 seconds;
+        f64 ops_per_s;
+        f64 mean_ns;
+        f64 p50_ns;
+        f64 p99_ns;
+        f64 p999_ns;
+        f64 max_ns;
+        usize memory_bytes;
+        Bench_Counters counters; // Including the clock reads
+} Workload_Result;
+
+Result bench_run_workload(const Workload_Case *workload, Bench_Options options,
+                          Workload_Result *result);
+
+void bench_print_workload_header(FILE *stream);
+void bench_print_workload_result(FILE *stream, const Workload_Result *result);
+void bench_write_workload_json(FILE *stream, const char *suite,
+                               const Workload_Result *results, usize count,
+                               Bench_Options options, i32 cpu);
+
+int bench_workload_main(const char *suite, const Workload_Case *cases,
+                        usize count, int argc, char **argv);
+
+#endif // !DATA_STRUCTURES_BENCH_H
@@ -0,0 +1,338 @@
+#include "bench.h"
+#include "../include/memory.h"
+#include "../include/utils.h"
+#include <stdio.h>
+
+// ============================================================================
+// Microbenchmarks of the library's primitives: allocation, copying,
+// hashing, comparison and array growth. See bench.h for building and
+// options.
+// ============================================================================
+
+/**
+ * @brief Keys per hashing/comparison table (a power of two, L1-resident).
+ */
+#define KEY_COUNT 1024
+
+/**
+ * @brief Live blocks of the allocation churn benchmark.
+ */
+#define CHURN_SLOTS 64
+
+/* ============================================================================
+ *  ALLOCATION
+ * ============================================================================
+ */
+
+typedef struct
+{
+        usize size;
+        ptr slots[CHURN_SLOTS];
+        usize sizes[KEY_COUNT];
+} Alloc_Context;
+
+/**
+ * @brief One ds_malloc() immediately followed by ds_free().
+ */
+static void bench_malloc_free(ptr context, u64 iterations)
+{
+    usize size = ((Alloc_Context *)context)->size;
+    for(u64 i = 0; i < iterations; i++)
+    {
+        byte *block = (byte *)ds_malloc(size);
+        block[0] = (byte)i;
+        bench_do_not_optimize(block);
+        ds_free(block);
+    }
+}
+
+/**
+ * @brief Replaces one of CHURN_SLOTS live blocks with a block of another
+ *        size (16 B to 4 KiB), as a container with mixed lifetimes does.
+ */
+static void bench_malloc_churn(ptr context, u64 iterations)
+{
+    Alloc_Context *churn = (Alloc_Context *)context;
+    for(u64 i = 0; i < iterations; i++)
+    {
+        usize slot = (usize)(i * 37) % CHURN_SLOTS;
+        ds_free(churn->slots[slot]);
+        churn->slots[slot] = ds_malloc(churn->sizes[i % KEY_COUNT]);
+        bench_do_not_optimize(churn->slots[slot]);
+    }
+}
+
+/* ============================================================================
+ *  COPYING
+ * ============================================================================
+ */
+
+typedef struct
+{
+        usize size;
+        byte *source;
+        byte *target;
+} Copy_Context;
+
+static void bench_memcpy(ptr context, u64 iterations)
+{
+    Copy_Context *copy = (Copy_Context *)context;
+    for(u64 i = 0; i < iterations; i++)
+    {
+        ds_memcpy(copy->target, copy->source, copy->size);
+        bench_do_not_optimize(copy->target);
+    }
+}
+
+static void bench_swap_bytes(ptr context, u64 iterations)
+{
+    Copy_Context *copy = (Copy_Context *)context;
+    for(u64 i = 0; i < iterations; i++)
+    {
+        swap_bytes(copy->target, copy->source, copy->size);
+        bench_do_not_optimize(copy->target);
+    }
+}
+
+/* ============================================================================
+ *  HASHING AND COMPARISON
+ * ============================================================================
+ */
+
+typedef struct
+{
+        int ints[KEY_COUNT];
+        f64 doubles[KEY_COUNT];
+        char *strings[KEY_COUNT];
+        usize string_length;
+} Key_Context;
+
+static void bench_hash_int(ptr context, u64 iterations)
+{
+    const int *keys = ((Key_Context *)context)->ints;
+    u64 sum = 0;
+    for(u64 i = 0; i < iterations; i++)
+        sum += hash_int(&keys[i % KEY_COUNT], sizeof(int));
+    bench_do_not_optimize(&sum);
+}
+
+static void bench_hash_double(ptr context, u64 iterations)
+{
+    const f64 *keys = ((Key_Context *)context)->doubles;
+    u64 sum = 0;
+    for(u64 i = 0; i < iterations; i++)
+        sum += hash_double(&keys[i % KEY_COUNT], sizeof(f64));
+    bench_do_not_optimize(&sum);
+}
+
+static void bench_hash_string(ptr context, u64 iterations)
+{
+    Key_Context *keys = (Key_Context *)context;
+    u64 sum = 0;
+    for(u64 i = 0; i < iterations; i++)
+        sum += hash_string(keys->strings[i % KEY_COUNT], keys->string_length);
+    bench_do_not_optimize(&sum);
+}
+
+/**
+ * @brief Read through a volatile pointer so that the compiler cannot
+ *        resolve the indirect call, as in a generic container.
+ */
+static compare_fn volatile compare_int_indirect = compare_int;
+static compare_fn volatile compare_double_indirect = compare_double;
+
+static inline int compare_int_inline(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+static void bench_compare_int_pointer(ptr context, u64 iterations)
+{
+    const int *keys = ((Key_Context *)context)->ints;
+    compare_fn compare = compare_int_indirect;
+    int sum = 0;
+    for(u64 i = 0; i < iterations; i++)
+        sum += compare(&keys[i % KEY_COUNT], &keys[(i + 1) % KEY_COUNT]);
+    bench_do_not_optimize(&sum);
+}
+
+static void bench_compare_int_inline(ptr context, u64 iterations)
+{
+    const int *keys = ((Key_Context *)context)->ints;
+    int sum = 0;
+    for(u64 i = 0; i < iterations; i++)
+        sum += compare_int_inline(&keys[i % KEY_COUNT],
+                                  &keys[(i + 1) % KEY_COUNT]);
+    bench_do_not_optimize(&sum);
+}
+
+static void bench_compare_double_pointer(ptr context, u64 iterations)
+{
+    const f64 *keys = ((Key_Context *)context)->doubles;
+    compare_fn compare = compare_double_indirect;
+    int sum = 0;
+    for(u64 i = 0; i < iterations; i++)
+        sum += compare(&keys[i % KEY_COUNT], &keys[(i + 1) % KEY_COUNT]);
+    bench_do_not_optimize(&sum);
+}
+
+/* ============================================================================
+ *  ARRAY GROWTH
+ * ============================================================================
+ */
+
+/**
+ * @brief Appends 'iterations' elements to an empty array, letting
+ *        ARRAY_RESERVE() grow it through calculate_growth().
+ */
+static void bench_array_push(ptr context, u64 iterations)
+{
+    (void)context;
+    i32Array array = {0};
+    for(u64 i = 0; i < iterations; i++)
+    {
+        if(array.size == array.capacity &&
+           result_is_error(ARRAY_RESERVE(&array, array.size + 1)))
+            break;
+        array.data[array.size++] = (i32)i;
+    }
+    bench_do_not_optimize(array.data);
+    ds_free(array.data);
+}
+
+/**
+ * @brief Same appends into an array reserved up front, the lower bound.
+ */
+static void bench_array_push_reserved(ptr context, u64 iterations)
+{
+    (void)context;
+    i32Array array = {0};
+    if(result_is_error(ARRAY_RESERVE(&array, (usize)iterations)))
+        return;
+    for(u64 i = 0; i < iterations; i++)
+        array.data[array.size++] = (i32)i;
+    bench_do_not_optimize(array.data);
+    ds_free(array.data);
+}
+
+/* ============================================================================
+ *  SUITE
+ * ============================================================================
+ */
+
+/**
+ * @brief Fills a key table with strings of 'string_length' characters.
+ */
+static void setup_keys(Key_Context *keys, char *storage, usize string_length,
+                       u64 seed)
+{
+    u64 state = seed;
+    for(usize i = 0; i < KEY_COUNT; i++)
+    {
+        keys->ints[i] = (int)bench_random(&state);
+        keys->doubles[i] = (f64)(bench_random(&state) >> 11) * 0x1p-53;
+        keys->strings[i] = storage + i * (string_length + 1);
+        for(usize c = 0; c < string_length; c++)
+            keys->strings[i][c] = (char)('a' + bench_random(&state) % 26);
+        keys->strings[i][string_length] = '\0';
+    }
+    keys->string_length = string_length;
+}
+
+/**
+ * @brief Allocates the live blocks of the churn benchmark.
+ */
+static Result setup_churn(Alloc_Context *churn)
+{
+    u64 state = 7;
+    for(usize i = 0; i < KEY_COUNT; i++)
+        churn->sizes[i] = 16 + (usize)(bench_random(&state) % 4081);
+    for(usize i = 0; i < CHURN_SLOTS; i++)
+    {
+        churn->slots[i] = ds_malloc(churn->sizes[i]);
+        if(!churn->slots[i])
+            return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                "Failed to allocate churn blocks");
+    }
+    return RESULT_SUCCESS;
+}
+
+#define COPY_CASE(name, context, size)                                         \
+    {"memcpy/" name, bench_memcpy, &context, size}
+
+int main(int argc, char **argv)
+{
+    static const usize copy_sizes[] = {8, 64, 512, 4096, 65536, 1 << 20};
+    static const usize swap_sizes[] = {4, 16, 64, 256};
+    static const usize string_lengths[] = {8, 32, 128};
+    enum
+    {
+        COPIES = 6,
+        SWAPS = 4,
+        STRINGS = 3
+    };
+
+    static Alloc_Context small = {16, {0}, {0}}, medium = {256, {0}, {0}},
+                         large = {4096, {0}, {0}}, churn;
+    static Key_Context keys[STRINGS];
+    static Copy_Context copies[COPIES], swaps[SWAPS];
+    static char storage[STRINGS][KEY_COUNT * 129];
+
+    byte *source = (byte *)ds_malloc(1 << 20);
+    byte *target = (byte *)ds_malloc(1 << 20);
+    Result result = source && target
+                        ? RESULT_SUCCESS
+                        : RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                       "Failed to allocate copy buffers");
+    if(result_is_success(result))
+        ds_memset(source, 0x5A, 1 << 20);
+    if(result_is_success(result))
+        result = setup_churn(&churn);
+    if(result_is_error(result))
+    {
+        fprintf(stderr, "micro_bench: %s\n", result_context(result).message);
+        return 1;
+    }
+    for(usize i = 0; i < STRINGS; i++)
+        setup_keys(&keys[i], storage[i], string_lengths[i], 42 + i);
+    for(usize i = 0; i < COPIES; i++)
+        copies[i] = (Copy_Context){copy_sizes[i], source, target};
+    for(usize i = 0; i < SWAPS; i++)
+        swaps[i] = (Copy_Context){swap_sizes[i], source, target};
+
+    const Bench_Case cases[] = {
+        {"malloc_free/16", bench_malloc_free, &small, 0},
+        {"malloc_free/256", bench_malloc_free, &medium, 0},
+        {"malloc_free/4096", bench_malloc_free, &large, 0},
+        {"malloc_churn/16-4096", bench_malloc_churn, &churn, 0},
+        COPY_CASE("8", copies[0], 8),
+        COPY_CASE("64", copies[1], 64),
+        COPY_CASE("512", copies[2], 512),
+        COPY_CASE("4096", copies[3], 4096),
+        COPY_CASE("65536", copies[4], 65536),
+        COPY_CASE("1048576", copies[5], 1 << 20),
+        {"swap_bytes/4", bench_swap_bytes, &swaps[0], 4},
+        {"swap_bytes/16", bench_swap_bytes, &swaps[1], 16},
+        {"swap_bytes/64", bench_swap_bytes, &swaps[2], 64},
+        {"swap_bytes/256", bench_swap_bytes, &swaps[3], 256},
+        {"hash_int", bench_hash_int, &keys[0], 0},
+        {"hash_double", bench_hash_double, &keys[0], 0},
+        {"hash_string/8", bench_hash_string, &keys[0], 8},
+        {"hash_string/32", bench_hash_string, &keys[1], 32},
+        {"hash_string/128", bench_hash_string, &keys[2], 128},
+        {"compare_int/pointer", bench_compare_int_pointer, &keys[0], 0},
+        {"compare_int/inline", bench_compare_int_inline, &keys[0], 0},
+        {"compare_double/pointer", bench_compare_double_pointer, &keys[0], 0},
+        {"array_push/growth", bench_array_push, NULL, sizeof(i32)},
+        {"array_push/reserved", bench_array_push_reserved, NULL, sizeof(i32)},
+    };
+
+    int status = bench_main("micro", cases, sizeof(cases) / sizeof(cases[0]),
+                            argc, argv);
+
+    for(usize i = 0; i < CHURN_SLOTS; i++)
+        ds_free(churn.slots[i]);
+    ds_free(source);
+    ds_free(target);
+    return status;
+}
@@ -0,0 +1,518 @@
+#include "bench.h"
+#include "../include/bitset.h"
+#include "../include/dary_heap.h"
+#include "../include/dynamic_graph.h"
+#include "../include/memory.h"
+#include "../include/utils.h"
+#include <math.h>
+#include <stdio.h>
+
+// ============================================================================
+// Container workloads with realistic key distributions: YCSB-style mixes
+// on the dynamic graph used as a key-value store (key k -> its single
+// out-edge), a hold model on the d-ary heap, and read/write mixes on
+// arrays and bit sets. See bench.h for building and options.
+// ============================================================================
+
+/**
+ * @brief Records loaded before a workload starts.
+ */
+#define WORKLOAD_RECORDS 100000
+
+/**
+ * @brief Skew of the Zipfian distribution (YCSB's default).
+ */
+#define ZIPFIAN_THETA 0.99
+
+/**
+ * @brief Longest YCSB-E scan, in consecutive keys.
+ */
+#define MAX_SCAN_LENGTH 100
+
+/* ============================================================================
+ *  KEY DISTRIBUTIONS
+ * ============================================================================
+ */
+
+typedef enum
+{
+    KEYS_UNIFORM,
+    KEYS_SEQUENTIAL,
+    KEYS_ZIPFIAN, // Popular keys scattered over the key space
+    KEYS_LATEST   // Zipfian over recency: the newest keys are the hottest
+} Key_Distribution;
+
+typedef struct
+{
+        Key_Distribution distribution;
+        u64 count;
+        u64 state;
+        u64 next; // Sequential position
+        f64 zeta; // Zipfian constants (Gray et al.)
+        f64 alpha;
+        f64 eta;
+        f64 half_pow_theta;
+} Key_Generator;
+
+/**
+ * @brief Draws a uniform double in [0, 1).
+ */
+static f64 random_unit(u64 *state)
+{
+    return (f64)(bench_random(state) >> 11) * 0x1p-53;
+}
+
+/**
+ * @brief Prepares a generator of keys in [0, count).
+ */
+static void keys_init(Key_Generator *keys, Key_Distribution distribution,
+                      u64 count, u64 seed)
+{
+    *keys = (Key_Generator){distribution, count, seed, 0, 0, 0, 0, 0};
+    if(distribution != KEYS_ZIPFIAN && distribution != KEYS_LATEST)
+        return;
+
+    f64 zeta2 = 1.0 + pow(0.5, ZIPFIAN_THETA);
+    for(u64 i = 1; i <= count; i++)
+        keys->zeta += 1.0 / pow((f64)i, ZIPFIAN_THETA);
+    keys->alpha = 1.0 / (1.0 - ZIPFIAN_THETA);
+    keys->eta = (1.0 - pow(2.0 / (f64)count, 1.0 - ZIPFIAN_THETA)) /
+                (1.0 - zeta2 / keys->zeta);
+    keys->half_pow_theta = pow(0.5, ZIPFIAN_THETA);
+}
+
+/**
+ * @brief Zipfian rank in [0, count): rank 0 is the most popular.
+ */
+static u64 zipfian_rank(Key_Generator *keys)
+{
+    f64 u = random_unit(&keys->state);
+    f64 uz = u * keys->zeta;
+    if(uz < 1.0)
+        return 0;
+    if(uz < 1.0 + keys->half_pow_theta)
+        return 1;
+    u64 rank = (u64)((f64)keys->count *
+                     pow(keys->eta * u - keys->eta + 1.0, keys->alpha));
+    return rank < keys->count ? rank : keys->count - 1;
+}
+
+/**
+ * @brief Next key; 'newest' is the most recent key (KEYS_LATEST only).
+ */
+static u64 keys_next(Key_Generator *keys, u64 newest)
+{
+    switch(keys->distribution)
+    {
+        case KEYS_SEQUENTIAL:
+            return keys->next++ % keys->count;
+        case KEYS_ZIPFIAN:
+        {
+            // Scramble the ranks so that hot keys are not neighbors.
+            int rank = (int)zipfian_rank(keys);
+            return hash_int(&rank, sizeof(rank)) % keys->count;
+        }
+        case KEYS_LATEST:
+        {
+            u64 rank = zipfian_rank(keys);
+            return rank <= newest ? newest - rank : 0;
+        }
+        default:
+            return bench_random(&keys->state) % keys->count;
+    }
+}
+
+/* ============================================================================
+ *  KEY-VALUE STORE (YCSB)
+ * ============================================================================
+ */
+
+/**
+ * @brief Operation mix in percent; the rest of 100 are read-modify-writes.
+ */
+typedef struct
+{
+        u32 read;
+        u32 update;
+        u32 insert;
+        u32 scan;
+} Ycsb_Mix;
+
+typedef struct
+{
+        Ycsb_Mix mix;
+        Key_Distribution distribution;
+        bool string_keys;
+        Dynamic_Graph graph;
+        Key_Generator keys;
+        u32 next_key;
+        u64 random;
+        char **strings; // String keys, hashed to a record with hash_string()
+        u64 sink;
+} Map_Workload;
+
+/**
+ * @brief Applies a batch of at most one insertion and one deletion.
+ */
+static Result map_apply(Map_Workload *map, u32 key, const u32 *inserted,
+                        const u32 *deleted)
+{
+    u32 source = key;
+    u32 insert_target = inserted ? *inserted : 0;
+    u32 delete_target = deleted ? *deleted : 0;
+    Edge_List inserts = {{&source, 1, 1}, {&insert_target, 1, 1}, {0}};
+    Edge_List deletes = {{&source, 1, 1}, {&delete_target, 1, 1}, {0}};
+    return dynamic_graph_apply(&map->graph, inserted ? &inserts : NULL,
+                               deleted ? &deletes : NULL);
+}
+
+/**
+ * @brief Reads the value of a key (0 if it has none).
+ */
+static Result map_read(Map_Workload *map, u32 key, u32 *value)
+{
+    Dynamic_Graph_Snapshot snapshot;
+    dynamic_graph_acquire(&map->graph, &snapshot);
+    const u32 *neighbors = NULL;
+    u32 degree = 0;
+    Result result =
+        dynamic_graph_neighbors(&snapshot, key, &neighbors, &degree);
+    *value = result_is_success(result) && degree > 0 ? neighbors[0] : 0;
+    dynamic_graph_release(&map->graph, &snapshot);
+    return result;
+}
+
+/**
+ * @brief Replaces the value of a key.
+ */
+static Result map_update(Map_Workload *map, u32 key, u32 value)
+{
+    u32 old = 0;
+    CHECK_RESULT(map_read(map, key, &old));
+    return old == value ? RESULT_SUCCESS : map_apply(map, key, &value, &old);
+}
+
+/**
+ * @brief Reads 'length' consecutive keys from one snapshot.
+ */
+static Result map_scan(Map_Workload *map, u32 first, u32 length)
+{
+    Dynamic_Graph_Snapshot snapshot;
+    dynamic_graph_acquire(&map->graph, &snapshot);
+    u32 count = dynamic_graph_vertex_count(&snapshot);
+    Result result = RESULT_SUCCESS;
+    for(u32 key = first; result_is_success(result) && key < count &&
+                         key < first + length;
+        key++)
+    {
+        const u32 *neighbors = NULL;
+        u32 degree = 0;
+        result = dynamic_graph_neighbors(&snapshot, key, &neighbors, &degree);
+        if(result_is_success(result) && degree > 0)
+            map->sink += neighbors[0];
+    }
+    dynamic_graph_release(&map->graph, &snapshot);
+    return result;
+}
+
+/**
+ * @brief Load phase: one record per key, plus the string keys.
+ */
+static Result map_setup(ptr context)
+{
+    Map_Workload *map = (Map_Workload *)context;
+    map->random = 1;
+    map->next_key = WORKLOAD_RECORDS;
+    keys_init(&map->keys, map->distribution, WORKLOAD_RECORDS, 2);
+
+    Edge_List records = {0};
+    Result result = dynamic_graph_create(&map->graph, WORKLOAD_RECORDS);
+    if(result_is_success(result))
+        result = ARRAY_RESERVE(&records.sources, WORKLOAD_RECORDS);
+    if(result_is_success(result))
+        result = ARRAY_RESERVE(&records.targets, WORKLOAD_RECORDS);
+    for(u32 key = 0; result_is_success(result) && key < WORKLOAD_RECORDS;
+        key++)
+    {
+        records.sources.data[records.sources.size++] = key;
+        records.targets.data[records.targets.size++] =
+            (u32)(bench_random(&map->random) % WORKLOAD_RECORDS);
+    }
+    if(result_is_success(result))
+        result = dynamic_graph_apply(&map->graph, &records, NULL);
+    ds_free(records.sources.data);
+    ds_free(records.targets.data);
+
+    // String keys of 8 to 64 characters, like user or session ids.
+    if(result_is_success(result) && map->string_keys)
+    {
+        map->strings = ALLOC_ARRAY(char *, WORKLOAD_RECORDS);
+        if(!map->strings)
+            result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                  "Failed to allocate string keys");
+    }
+    for(u32 i = 0; result_is_success(result) && map->string_keys &&
+                   i < WORKLOAD_RECORDS;
+        i++)
+    {
+        usize length = 8 + (usize)(bench_random(&map->random) % 57);
+        map->strings[i] = (char *)ds_malloc(length + 1);
+        if(!map->strings[i])
+            result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                  "Failed to allocate string key");
+        for(usize c = 0; result_is_success(result) && c < length; c++)
+            map->strings[i][c] =
+                (char)('a' + bench_random(&map->random) % 26);
+        if(result_is_success(result))
+            map->strings[i][length] = '\0';
+    }
+    return result;
+}
+
+/**
+ * @brief One YCSB operation.
+ */
+static Result map_run(ptr context, u64 index)
+{
+    (void)index;
+    Map_Workload *map = (Map_Workload *)context;
+    u32 key = (u32)keys_next(&map->keys, map->next_key - 1);
+    if(map->string_keys)
+    {
+        const char *name = map->strings[key];
+        key = (u32)(hash_string(name, 0) % map->next_key);
+    }
+
+    Ycsb_Mix mix = map->mix;
+    u32 dice = (u32)(bench_random(&map->random) % 100);
+    u32 value = (u32)(bench_random(&map->random) % WORKLOAD_RECORDS);
+    if(dice < mix.read)
+    {
+        u32 read = 0;
+        CHECK_RESULT(map_read(map, key, &read));
+        map->sink += read;
+        return RESULT_SUCCESS;
+    }
+    dice -= mix.read;
+    if(dice < mix.update)
+        return map_update(map, key, value);
+    dice -= mix.update;
+    if(dice < mix.insert)
+        return map_apply(map, map->next_key++, &value, NULL);
+    dice -= mix.insert;
+    if(dice < mix.scan)
+        return map_scan(map, key, 1 + value % MAX_SCAN_LENGTH);
+
+    u32 old = 0;
+    CHECK_RESULT(map_read(map, key, &old));
+    value = old + 1;
+    return map_apply(map, key, &value, &old);
+}
+
+static void map_teardown(ptr context)
+{
+    Map_Workload *map = (Map_Workload *)context;
+    dynamic_graph_destroy(&map->graph);
+    for(u32 i = 0; map->strings && i < WORKLOAD_RECORDS; i++)
+        ds_free(map->strings[i]);
+    ds_free(map->strings);
+    map->strings = NULL;
+}
+
+/* ============================================================================
+ *  PRIORITY QUEUE (HOLD MODEL)
+ * ============================================================================
+ */
+
+/**
+ * @brief Each operation pops the smallest key and pushes it back further
+ *        ahead, keeping the queue size constant (the classic hold model).
+ */
+typedef struct
+{
+        Key_Distribution distribution;
+        Dary_Heap heap;
+        Key_Generator keys;
+} Queue_Workload;
+
+/**
+ * @brief Distance a popped entry is pushed ahead.
+ */
+static f64 queue_increment(Queue_Workload *queue)
+{
+    switch(queue->distribution)
+    {
+        case KEYS_SEQUENTIAL:
+            return 1.0; // Every entry goes to the back: FIFO order
+        case KEYS_ZIPFIAN:
+            return (f64)(zipfian_rank(&queue->keys) + 1);
+        default:
+            return random_unit(&queue->keys.state) * WORKLOAD_RECORDS;
+    }
+}
+
+static Result queue_setup(ptr context)
+{
+    Queue_Workload *queue = (Queue_Workload *)context;
+    keys_init(&queue->keys, queue->distribution, WORKLOAD_RECORDS, 3);
+    CHECK_RESULT(dary_heap_create(&queue->heap, WORKLOAD_RECORDS));
+    for(u32 i = 0; i < WORKLOAD_RECORDS; i++)
+        CHECK_RESULT(dary_heap_push(&queue->heap, queue_increment(queue), i));
+    return RESULT_SUCCESS;
+}
+
+static Result queue_run(ptr context, u64 index)
+{
+    (void)index;
+    Queue_Workload *queue = (Queue_Workload *)context;
+    Dary_Heap_Entry entry;
+    CHECK_RESULT(dary_heap_pop(&queue->heap, &entry));
+    return dary_heap_push(&queue->heap, entry.key + queue_increment(queue),
+                          entry.value);
+}
+
+static void queue_teardown(ptr context)
+{
+    dary_heap_destroy(&((Queue_Workload *)context)->heap);
+}
+
+/* ============================================================================
+ *  ARRAYS AND BIT SETS (90% READS, 10% WRITES)
+ * ============================================================================
+ */
+
+typedef struct
+{
+        Key_Distribution distribution;
+        i32Array array;
+        Key_Generator keys;
+        u64 random;
+        i64 sink;
+} Array_Workload;
+
+static Result array_setup(ptr context)
+{
+    Array_Workload *work = (Array_Workload *)context;
+    work->random = 4;
+    keys_init(&work->keys, work->distribution, WORKLOAD_RECORDS, 5);
+    CHECK_RESULT(ARRAY_RESERVE(&work->array, WORKLOAD_RECORDS));
+    for(u32 i = 0; i < WORKLOAD_RECORDS; i++)
+        work->array.data[work->array.size++] = (i32)i;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Reads an element, or appends one (growing the array).
+ */
+static Result array_run(ptr context, u64 index)
+{
+    (void)index;
+    Array_Workload *work = (Array_Workload *)context;
+    u64 key = keys_next(&work->keys, 0);
+    if(bench_random(&work->random) % 100 < 90)
+    {
+        work->sink += work->array.data[key];
+        return RESULT_SUCCESS;
+    }
+    CHECK_RESULT(ARRAY_RESERVE(&work->array, work->array.size + 1));
+    work->array.data[work->array.size++] = (i32)key;
+    return RESULT_SUCCESS;
+}
+
+static void array_teardown(ptr context)
+{
+    Array_Workload *work = (Array_Workload *)context;
+    ds_free(work->array.data);
+    work->array = (i32Array){0};
+}
+
+typedef struct
+{
+        Key_Distribution distribution;
+        Bitset set;
+        Key_Generator keys;
+        u64 random;
+        u64 sink;
+} Set_Workload;
+
+static Result set_setup(ptr context)
+{
+    Set_Workload *work = (Set_Workload *)context;
+    work->random = 6;
+    keys_init(&work->keys, work->distribution, WORKLOAD_RECORDS, 7);
+    CHECK_RESULT(bitset_create(&work->set, WORKLOAD_RECORDS));
+    for(u32 i = 0; i < WORKLOAD_RECORDS; i += 2)
+        bitset_set(&work->set, i);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Tests a member, or toggles it.
+ */
+static Result set_run(ptr context, u64 index)
+{
+    (void)index;
+    Set_Workload *work = (Set_Workload *)context;
+    u64 key = keys_next(&work->keys, 0);
+    if(bench_random(&work->random) % 100 < 90)
+        work->sink += bitset_test(&work->set, key);
+    else if(bitset_test(&work->set, key))
+        bitset_reset(&work->set, key);
+    else
+        bitset_set(&work->set, key);
+    return RESULT_SUCCESS;
+}
+
+static void set_teardown(ptr context)
+{
+    bitset_destroy(&((Set_Workload *)context)->set);
+}
+
+/* ============================================================================
+ *  SUITE
+ * ============================================================================
+ */
+
+#define MAP_CASE(name, ycsb, keys, strings)                                    \
+    {"map/" name, map_setup, map_run, map_teardown,                            \
+     &(Map_Workload){                                                          \
+         .mix = ycsb, .distribution = keys, .string_keys = strings}}
+#define QUEUE_CASE(name, keys)                                                 \
+    {"queue/hold/" name, queue_setup, queue_run, queue_teardown,               \
+     &(Queue_Workload){.distribution = keys}}
+#define ARRAY_CASE(name, keys)                                                 \
+    {"array/read90/" name, array_setup, array_run, array_teardown,             \
+     &(Array_Workload){.distribution = keys}}
+#define SET_CASE(name, keys)                                                   \
+    {"set/read90/" name, set_setup, set_run, set_teardown,                     \
+     &(Set_Workload){.distribution = keys}}
+
+int main(int argc, char **argv)
+{
+    // Read, update, insert, scan; the remainder is read-modify-write.
+    const Ycsb_Mix a = {50, 50, 0, 0}, b = {95, 5, 0, 0}, c = {100, 0, 0, 0},
+                   d = {95, 0, 5, 0}, e = {0, 0, 5, 95}, f = {50, 0, 0, 0};
+
+    const Workload_Case cases[] = {
+        MAP_CASE("ycsb-a/zipfian", a, KEYS_ZIPFIAN, false),
+        MAP_CASE("ycsb-a/uniform", a, KEYS_UNIFORM, false),
+        MAP_CASE("ycsb-b/zipfian", b, KEYS_ZIPFIAN, false),
+        MAP_CASE("ycsb-c/zipfian", c, KEYS_ZIPFIAN, false),
+        MAP_CASE("ycsb-c/zipfian-string", c, KEYS_ZIPFIAN, true),
+        MAP_CASE("ycsb-d/latest", d, KEYS_LATEST, false),
+        MAP_CASE("ycsb-e/zipfian", e, KEYS_ZIPFIAN, false),
+        MAP_CASE("ycsb-f/zipfian", f, KEYS_ZIPFIAN, false),
+        QUEUE_CASE("uniform", KEYS_UNIFORM),
+        QUEUE_CASE("sequential", KEYS_SEQUENTIAL),
+        QUEUE_CASE("zipfian", KEYS_ZIPFIAN),
+        ARRAY_CASE("uniform", KEYS_UNIFORM),
+        ARRAY_CASE("sequential", KEYS_SEQUENTIAL),
+        ARRAY_CASE("zipfian", KEYS_ZIPFIAN),
+        SET_CASE("uniform", KEYS_UNIFORM),
+        SET_CASE("sequential", KEYS_SEQUENTIAL),
+        SET_CASE("zipfian", KEYS_ZIPFIAN),
+    };
+
+    return bench_workload_main("workload", cases,
+                               sizeof(cases) / sizeof(cases[0]), argc, argv);
+}
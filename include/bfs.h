@@ -0,0 +1,70 @@
+#ifndef DATA_STRUCTURES_BFS_H
+#define DATA_STRUCTURES_BFS_H
+
+// ============================================================================
+// File: bfs.h
+// Description:
+//     Parallel direction-optimizing breadth-first search over CSR graphs
+//     (Beamer, Asanovic and Patterson, "Direction-Optimizing Breadth-First
+//     Search", SC 2012).
+//
+//     Small frontiers are expanded top-down: every frontier vertex scans its
+//     out-neighbors and claims unvisited ones with a compare-and-swap.
+//     Large frontiers are expanded bottom-up: every unvisited vertex scans
+//     its in-neighbors until it finds one in the frontier. The bottom-up
+//     step needs no atomics at all, since each vertex (and each 64-vertex
+//     word of the next-frontier bit set) is owned by a single thread. The
+//     search switches direction from the number of edges left to explore.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "graph.h" // For CSR_Graph
+#include "types.h" // For u32Array
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Constants and options.
+// ---------------------------------------------------------------------------
+// BFS_UNREACHED marks vertices not reachable from the source in both the
+// parent and depth arrays.
+//
+// BFS_Options tunes the direction switch:
+//   alpha -> go bottom-up once frontier edges > unexplored edges / alpha.
+//   beta  -> go back top-down once frontier vertices < vertex_count / beta.
+// BFS_DEFAULT_OPTIONS holds the values recommended by the paper.
+
+#define BFS_UNREACHED UINT32_MAX
+
+typedef struct
+{
+        u32 alpha;
+        u32 beta;
+} BFS_Options;
+
+#define BFS_DEFAULT_OPTIONS ((BFS_Options){15, 18})
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Traversal.
+// ---------------------------------------------------------------------------
+// csr_bfs():
+//     Runs a BFS from 'source'. 'incoming' is the transpose of 'graph'
+//     (see csr_graph_transpose()) and is required for bottom-up steps on
+//     directed graphs; pass NULL for symmetric graphs.
+//
+//     'parents' and 'depths' are resized to vertex_count entries. The parent
+//     of the source is the source itself. Either output may be NULL.
+//
+// csr_bfs_reachable():
+//     Answers whether 'target' is reachable from 'source', stopping as soon
+//     as the level containing 'target' has been discovered.
+//
+// Example usage:
+//     u32Array depths = {0};
+//     CHECK_RESULT(csr_bfs(&graph, NULL, 0, BFS_DEFAULT_OPTIONS, NULL,
+//                          &depths));
+
+Result csr_bfs(const CSR_Graph *graph, const CSR_Graph *incoming, u32 source,
+               BFS_Options options, u32Array *parents, u32Array *depths);
+Result csr_bfs_reachable(const CSR_Graph *graph, const CSR_Graph *incoming,
+                         u32 source, u32 target, bool *reachable);
+
+#endif // !DATA_STRUCTURES_BFS_H
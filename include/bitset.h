@@ -0,0 +1,73 @@
+#ifndef DATA_STRUCTURES_BITSET_H
+#define DATA_STRUCTURES_BITSET_H
+
+// ============================================================================
+// File: bitset.h
+// Description:
+//     Fixed-size bit sets stored as an array of 64-bit words.
+//
+//     Bit sets are used as compact vertex sets (frontiers, visited marks)
+//     by the graph algorithms. Single-bit accessors are defined inline; a
+//     thread that owns a whole word (64 consecutive bits) may update it with
+//     plain stores, otherwise bitset_set_atomic() must be used.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "types.h" // For u64, usize
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Bit set structure.
+// ---------------------------------------------------------------------------
+// Fields:
+//   words      -> Storage, word i holds bits 64 * i .. 64 * i + 63.
+//   bit_count  -> Number of usable bits.
+//   word_count -> Number of words ((bit_count + 63) / 64).
+
+typedef struct
+{
+        u64 *words;
+        usize bit_count;
+        usize word_count;
+} Bitset;
+
+#define BITSET_WORD_BITS 64
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Lifetime and bulk operations.
+// ---------------------------------------------------------------------------
+// bitset_create() allocates a bit set with every bit cleared.
+// bitset_count() returns the number of set bits.
+
+Result bitset_create(Bitset *set, usize bit_count);
+void bitset_destroy(Bitset *set);
+void bitset_clear_all(Bitset *set);
+usize bitset_count(const Bitset *set);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Single-bit access.
+// ---------------------------------------------------------------------------
+
+static inline bool bitset_test(const Bitset *set, usize bit)
+{
+    return (set->words[bit / BITSET_WORD_BITS] >> (bit % BITSET_WORD_BITS)) &
+           1u;
+}
+
+static inline void bitset_set(Bitset *set, usize bit)
+{
+    set->words[bit / BITSET_WORD_BITS] |= (u64)1 << (bit % BITSET_WORD_BITS);
+}
+
+static inline void bitset_set_atomic(Bitset *set, usize bit)
+{
+    __atomic_fetch_or(&set->words[bit / BITSET_WORD_BITS],
+                      (u64)1 << (bit % BITSET_WORD_BITS), __ATOMIC_RELAXED);
+}
+
+static inline void bitset_reset(Bitset *set, usize bit)
+{
+    set->words[bit / BITSET_WORD_BITS] &=
+        ~((u64)1 << (bit % BITSET_WORD_BITS));
+}
+
+#endif // !DATA_STRUCTURES_BITSET_H
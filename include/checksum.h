@@ -0,0 +1,64 @@
+#ifndef DATA_STRUCTURES_CHECKSUM_H
+#define DATA_STRUCTURES_CHECKSUM_H
+
+// ============================================================================
+// File: checksum.h
+// Description:
+//     Fast checksums for detecting corrupted data.
+//
+//       - CRC32C (Castagnoli polynomial), computed with the SSE4.2 crc32
+//         instruction when the processor has it (checked once at run time)
+//         and with a slicing-by-8 table otherwise. Results are identical.
+//       - xxHash64, a fast non-cryptographic 64-bit hash, in portable C.
+//
+//     Large buffers are checksummed as independent fixed-size blocks, in
+//     parallel on the shared thread pool; a verification then reports the
+//     first block that does not match.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "types.h" // For byteArray, u64Array
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Checksums of a buffer.
+// ---------------------------------------------------------------------------
+// ds_crc32c():
+//     Extends 'crc' (0 for a new checksum) with 'size' bytes, so a buffer
+//     can be checksummed piecewise: crc32c(crc32c(0, a), b) == crc32c(0, ab).
+//
+// ds_xxhash64():
+//     Hashes 'size' bytes with the given seed (the reference XXH64()).
+
+u32 ds_crc32c(u32 crc, cptr data, usize size);
+u64 ds_xxhash64(cptr data, usize size, u64 seed);
+bool ds_crc32c_hardware(void); // Whether the SSE4.2 path is used
+
+u32 ds_crc32c_bytes(const byteArray *array);
+u64 ds_xxhash64_bytes(const byteArray *array, u64 seed);
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Block checksums.
+// ---------------------------------------------------------------------------
+// ds_checksum_blocks():
+//     Splits 'array' into blocks of 'block_size' bytes (the last one may be
+//     shorter) and stores the checksum of each in 'checksums' (resized to
+//     the block count). CRC32C values are zero-extended to 64 bits.
+//
+// ds_verify_blocks():
+//     Recomputes the block checksums and compares them to 'checksums'.
+//     Fails with DS_ERROR_CORRUPTED_DATA if any differs, storing the index
+//     of the first differing block in 'bad_block' (if not NULL).
+
+typedef enum
+{
+    CHECKSUM_CRC32C = 1,
+    CHECKSUM_XXH64
+} Checksum_Kind;
+
+Result ds_checksum_blocks(const byteArray *array, usize block_size,
+                          Checksum_Kind kind, u64Array *checksums);
+Result ds_verify_blocks(const byteArray *array, usize block_size,
+                        Checksum_Kind kind, const u64Array *checksums,
+                        usize *bad_block);
+
+#endif // !DATA_STRUCTURES_CHECKSUM_H
@@ -0,0 +1,113 @@
+#ifndef DATA_STRUCTURES_CODEC_H
+#define DATA_STRUCTURES_CODEC_H
+
+// ============================================================================
+// File: codec.h
+// Description:
+//     Integer compression codecs for 32-bit columns (i32Array / u32Array).
+//
+//     Two codecs are provided, both reading and writing plain byteArray
+//     buffers so that encoded data can be persisted or shipped as-is:
+//
+//       - CODEC_BITPACK: FastPFor-style binary packing. Values are grouped
+//         into blocks of 128, each block stores a single bit width and the
+//         values are packed into four interleaved 32-bit lanes so that the
+//         decoder can unpack four integers per SSE2 instruction.
+//       - CODEC_STREAMVBYTE: byte-oriented variable length coding with the
+//         length descriptors stored in a separate control stream. Decoding
+//         uses one SSSE3 shuffle per four integers.
+//
+//     Both codecs optionally apply delta coding (for sorted data such as
+//     adjacency lists or timestamps) and zigzag coding (for signed deltas).
+//     The SIMD paths are selected at compile time (__SSE2__, __SSSE3__);
+//     every codec has a portable scalar fallback producing the same format.
+//     Build with -march=native (or at least -mssse3) to reach decode speeds
+//     above one billion integers per second.
+//
+//     Encoded streams are self-describing: a small header records the codec,
+//     the flags and the number of values. Multiple streams can be appended
+//     to the same byteArray and decoded one after another with a cursor.
+//     Multi-byte fields are stored in native (little-endian) byte order.
+// ============================================================================
+
+#include "error.h" // For Result and error codes
+#include "types.h" // For u32, i32Array, u32Array, byteArray, ...
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Codec identifiers and flags.
+// ---------------------------------------------------------------------------
+// Codec_Kind selects the physical encoding. Flags are OR-ed together:
+//
+//   CODEC_FLAG_DELTA  -> Store differences between consecutive values.
+//   CODEC_FLAG_ZIGZAG -> Map signed values (or deltas) so that small
+//                        magnitudes get small codes (0,-1,1,-2 -> 0,1,2,3).
+
+typedef enum
+{
+    CODEC_BITPACK = 1,    // Blocked, lane-interleaved binary packing
+    CODEC_STREAMVBYTE = 2 // Control-stream variable byte coding
+} Codec_Kind;
+
+typedef enum
+{
+    CODEC_FLAG_NONE = 0,
+    CODEC_FLAG_DELTA = 1 << 0,
+    CODEC_FLAG_ZIGZAG = 1 << 1
+} Codec_Flags;
+
+#define CODEC_BLOCK_SIZE 128 // Values per CODEC_BITPACK block
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Size queries.
+// ---------------------------------------------------------------------------
+// codec_max_encoded_size():
+//     Upper bound, in bytes, of an encoded stream holding 'count' values.
+//     Useful for pre-reserving output buffers.
+//
+// codec_decoded_count():
+//     Reads the header of the stream starting at 'cursor' and reports how
+//     many values it holds, without decoding anything.
+
+usize codec_max_encoded_size(Codec_Kind kind, usize count);
+Result codec_decoded_count(const byteArray *in, usize cursor, usize *count);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Raw encode / decode.
+// ---------------------------------------------------------------------------
+// codec_encode_u32():
+//     Appends an encoded stream of 'count' values to 'out', growing it as
+//     needed.
+//
+// codec_decode_u32():
+//     Decodes the stream at '*cursor' into 'values' (which must hold at
+//     least 'capacity' elements) and advances '*cursor' past the stream.
+//     Returns DS_ERROR_CORRUPTED_DATA if the stream is malformed or
+//     truncated, DS_ERROR_FULL_CONTAINER if 'capacity' is too small.
+
+Result codec_encode_u32(const u32 *values, usize count, Codec_Kind kind,
+                        u32 flags, byteArray *out);
+Result codec_decode_u32(const byteArray *in, usize *cursor, u32 *values,
+                        usize capacity);
+
+// ---------------------------------------------------------------------------
+// SECTION 4: Typed array convenience wrappers.
+// ---------------------------------------------------------------------------
+// The decoders append to the destination array, growing it as needed.
+//
+// Example usage:
+//     byteArray buf = {0};
+//     CHECK_RESULT(codec_encode_i32(&column, CODEC_BITPACK,
+//                                   CODEC_FLAG_DELTA | CODEC_FLAG_ZIGZAG,
+//                                   &buf));
+//     usize cursor = 0;
+//     CHECK_RESULT(codec_decode_i32(&buf, &cursor, &restored));
+
+Result codec_encode_i32(const i32Array *in, Codec_Kind kind, u32 flags,
+                        byteArray *out);
+Result codec_decode_i32(const byteArray *in, usize *cursor, i32Array *out);
+Result codec_encode_u32_array(const u32Array *in, Codec_Kind kind, u32 flags,
+                              byteArray *out);
+Result codec_decode_u32_array(const byteArray *in, usize *cursor,
+                              u32Array *out);
+
+#endif // !DATA_STRUCTURES_CODEC_H
@@ -0,0 +1,185 @@
+#ifndef DATA_STRUCTURES_CONTAINER_STATS_H
+#define DATA_STRUCTURES_CONTAINER_STATS_H
+
+// ============================================================================
+// File: container_stats.h
+// Description:
+//     Opt-in instrumentation of individual container instances, for seeing
+//     a container degrade in production before it shows up as latency.
+//
+//     A container records into the Container_Stats its 'stats' field
+//     points to (NULL, the default, records nothing and costs one branch
+//     per operation). Every operation adds one to a bucket of a probe
+//     length histogram - search steps, levels sifted, path length - whose
+//     total is also the operation count, with a single relaxed atomic
+//     increment. Resizes and the deepest structure seen are recorded as
+//     they happen. With CONTAINER_STATS_LATENCY every operation is also
+//     timed into a latency histogram, which costs two clock reads.
+//
+//     Histograms are log-linear: exact up to 3, then four buckets per
+//     power of two (relative error below 25%), in a fixed array, so
+//     recording never allocates.
+//
+//     Instrumented containers and what they record:
+//       Dary_Heap     -> insert/remove: levels sifted; depth: levels of
+//                        the last sift-down; resizes of the entry array.
+//       Union_Find    -> insert (unite) / lookup (find, connected): path
+//                        length walked; depth: longest path walked.
+//       Dynamic_Graph -> batch (apply); lookup (has_edge: binary search
+//                        steps, neighbors: 0); resizes of the page table
+//                        when the vertex count grows.
+// ============================================================================
+
+#include "types.h" // For u64, usize
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Histograms.
+// ---------------------------------------------------------------------------
+// container_histogram_bucket() maps a value to its bucket; values beyond
+// the last bucket's range (2^42, over an hour in nanoseconds) are
+// clamped into it. container_histogram_lower_bound() is the smallest
+// value of a bucket, and container_histogram_percentile() the lower bound
+// of the bucket holding the given fraction (0.5, 0.99, ...) of the values.
+
+#define CONTAINER_HISTOGRAM_BUCKETS 164
+
+typedef struct
+{
+        u64 counts[CONTAINER_HISTOGRAM_BUCKETS];
+} Container_Histogram;
+
+static inline usize container_histogram_bucket(u64 value)
+{
+    if(value < 4)
+        return (usize)value;
+    usize bit = 63 - (usize)__builtin_clzll(value);
+    usize bucket = (bit - 1) * 4 + (usize)((value >> (bit - 2)) & 3);
+    return bucket < CONTAINER_HISTOGRAM_BUCKETS
+               ? bucket
+               : CONTAINER_HISTOGRAM_BUCKETS - 1;
+}
+
+u64 container_histogram_lower_bound(usize bucket);
+u64 container_histogram_count(const Container_Histogram *histogram);
+u64 container_histogram_percentile(const Container_Histogram *histogram,
+                                   f64 fraction);
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Statistics of one container.
+// ---------------------------------------------------------------------------
+// Fields:
+//   name         -> Label for reports (not copied).
+//   flags        -> CONTAINER_STATS_LATENCY to time operations.
+//   probes       -> Probe length histogram per operation kind.
+//   latency_ns   -> Latency histogram per operation kind (only with
+//                   CONTAINER_STATS_LATENCY).
+//   resizes      -> Times the container grew its storage.
+//   resize_bytes -> Bytes of storage after each growth, summed.
+//   max_depth    -> Deepest structure seen (tree levels, path length).
+//
+// One Container_Stats may be shared by several containers (of one kind)
+// to aggregate them, and recorded into from several threads.
+
+typedef enum
+{
+    CONTAINER_OP_INSERT,
+    CONTAINER_OP_REMOVE,
+    CONTAINER_OP_LOOKUP,
+    CONTAINER_OP_BATCH,
+    CONTAINER_OP_COUNT
+} Container_Op;
+
+typedef enum
+{
+    CONTAINER_STATS_DEFAULT = 0,
+    CONTAINER_STATS_LATENCY = 1 << 0
+} Container_Stats_Flags;
+
+typedef struct
+{
+        const char *name;
+        u32 flags;
+        Container_Histogram probes[CONTAINER_OP_COUNT];
+        Container_Histogram latency_ns[CONTAINER_OP_COUNT];
+        u64 resizes;
+        u64 resize_bytes;
+        u64 max_depth;
+} Container_Stats;
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Setup and inspection.
+// ---------------------------------------------------------------------------
+// Example usage:
+//     static Container_Stats queue_stats;
+//     container_stats_init(&queue_stats, "frontier", CONTAINER_STATS_DEFAULT);
+//     CHECK_RESULT(dary_heap_create(&heap, 64));
+//     heap.stats = &queue_stats;
+//     ...
+//     Container_Stats stats = container_stats_snapshot(&queue_stats);
+//     u64 p99 = container_histogram_percentile(
+//         &stats.probes[CONTAINER_OP_REMOVE], 0.99);
+//
+// container_stats_snapshot() copies the counters like
+// ds_get_memory_stats(): safe while containers keep recording, each
+// counter being read atomically (but not all of them at one instant).
+// container_stats_operations() is the number of operations of a kind.
+// container_stats_reset() clears the counters, keeping name and flags.
+
+void container_stats_init(Container_Stats *stats, const char *name,
+                          u32 flags);
+Container_Stats container_stats_snapshot(const Container_Stats *stats);
+void container_stats_reset(Container_Stats *stats);
+u64 container_stats_operations(const Container_Stats *stats, Container_Op op);
+
+// ---------------------------------------------------------------------------
+// SECTION 4: Recording (used by the containers).
+// ---------------------------------------------------------------------------
+// Example, in a container operation:
+//     u64 start = container_stats_begin(list->stats);
+//     ... walk 'steps' nodes ...
+//     container_stats_record(list->stats, CONTAINER_OP_LOOKUP, steps, start);
+//
+// container_stats_begin() returns 0 unless latencies are recorded.
+// container_stats_depth() and container_stats_resize() are rare events;
+// the former only writes when the depth is a new maximum.
+
+u64 container_stats_now(void); // Monotonic nanoseconds
+void container_stats_resize(Container_Stats *stats, usize bytes);
+
+static inline u64 container_stats_begin(const Container_Stats *stats)
+{
+    return stats && (stats->flags & CONTAINER_STATS_LATENCY)
+               ? container_stats_now()
+               : 0;
+}
+
+static inline void container_stats_record(Container_Stats *stats,
+                                          Container_Op op, u64 probes,
+                                          u64 start)
+{
+    if(!stats)
+        return;
+    __atomic_fetch_add(
+        &stats->probes[op].counts[container_histogram_bucket(probes)], 1,
+        __ATOMIC_RELAXED);
+    if(start)
+        __atomic_fetch_add(
+            &stats->latency_ns[op].counts[container_histogram_bucket(
+                container_stats_now() - start)],
+            1, __ATOMIC_RELAXED);
+}
+
+static inline void container_stats_depth(Container_Stats *stats, u64 depth)
+{
+    u64 deepest;
+    if(!stats)
+        return;
+    deepest = __atomic_load_n(&stats->max_depth, __ATOMIC_RELAXED);
+    while(depth > deepest &&
+          !__atomic_compare_exchange_n(&stats->max_depth, &deepest, depth,
+                                       true, __ATOMIC_RELAXED,
+                                       __ATOMIC_RELAXED))
+        ;
+}
+
+#endif // !DATA_STRUCTURES_CONTAINER_STATS_H
@@ -0,0 +1,67 @@
+#ifndef DATA_STRUCTURES_DARY_HEAP_H
+#define DATA_STRUCTURES_DARY_HEAP_H
+
+// ============================================================================
+// File: dary_heap.h
+// Description:
+//     A d-ary min-heap of (key, value) pairs, the priority queue used by
+//     Dijkstra-style algorithms.
+//
+//     With DARY_HEAP_ARITY children per node the tree is shallower than a
+//     binary heap, so pushes touch fewer levels, and the children of a node
+//     sit next to each other in memory (four 16-byte entries fill one cache
+//     line), which makes the sift-down scan cheap.
+//
+//     Keys are f64 priorities, values are u32 payloads (typically vertex
+//     ids). Decrease-key is not supported: push the new key and skip stale
+//     entries when they are popped.
+// ============================================================================
+
+#include "container_stats.h" // For Container_Stats
+#include "error.h"           // For Result
+#include "types.h"           // For f64, u32, usize
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Heap structures.
+// ---------------------------------------------------------------------------
+// Dary_Heap follows the DECLARE_TYPE layout (data, size, capacity), so the
+// array helpers such as ARRAY_RESERVE work on it directly. 'stats' may be
+// pointed at a Container_Stats after dary_heap_create() to instrument the
+// heap (see container_stats.h).
+
+#define DARY_HEAP_ARITY 4
+
+typedef struct
+{
+        f64 key;
+        u32 value;
+} Dary_Heap_Entry;
+
+typedef struct
+{
+        Dary_Heap_Entry *data;
+        usize size;
+        usize capacity;
+        Container_Stats *stats; // Opt-in instrumentation (NULL: none)
+} Dary_Heap;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Heap operations.
+// ---------------------------------------------------------------------------
+// dary_heap_create()  -> Initializes an empty heap with room for 'capacity'
+//                        entries (it grows automatically afterwards).
+// dary_heap_push()    -> Inserts an entry, O(log_d n).
+// dary_heap_pop()     -> Removes the entry with the smallest key into 'out';
+//                        DS_ERROR_EMPTY_CONTAINER if the heap is empty.
+// dary_heap_peek()    -> Same as pop without removing the entry.
+// dary_heap_clear()   -> Removes all entries, keeping the storage.
+
+Result dary_heap_create(Dary_Heap *heap, usize capacity);
+void dary_heap_destroy(Dary_Heap *heap);
+Result dary_heap_push(Dary_Heap *heap, f64 key, u32 value);
+Result dary_heap_pop(Dary_Heap *heap, Dary_Heap_Entry *out);
+Result dary_heap_peek(const Dary_Heap *heap, Dary_Heap_Entry *out);
+void dary_heap_clear(Dary_Heap *heap);
+bool dary_heap_is_empty(const Dary_Heap *heap);
+
+#endif // !DATA_STRUCTURES_DARY_HEAP_H
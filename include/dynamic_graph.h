@@ -0,0 +1,114 @@
+#ifndef DATA_STRUCTURES_DYNAMIC_GRAPH_H
+#define DATA_STRUCTURES_DYNAMIC_GRAPH_H
+
+// ============================================================================
+// File: dynamic_graph.h
+// Description:
+//     A graph that accepts batched edge insertions and deletions while
+//     readers keep analyzing consistent snapshots.
+//
+//     Every vertex owns one contiguous, sorted adjacency block, so scanning
+//     neighbors is as cheap as in a CSR graph. Blocks are grouped into pages
+//     of DYNAMIC_GRAPH_PAGE_SIZE vertices, and a version is a table of page
+//     pointers. Applying a batch never modifies published memory: touched
+//     blocks and their pages are copied, untouched ones are shared with the
+//     previous version, and the new version is then published atomically.
+//
+//     Readers pin a version with dynamic_graph_acquire(); it stays valid
+//     (and unchanged) until released, no matter how many batches are
+//     applied meanwhile. Memory replaced by a batch is freed once no pinned
+//     version can reference it any more.
+//
+//     Writers are serialized with each other; readers never wait for a
+//     batch to be built, only for the short publication step.
+//     Link with -pthread.
+// ============================================================================
+
+#include "container_stats.h" // For Container_Stats
+#include "error.h"           // For Result
+#include "graph.h"           // For Edge_List, CSR_Graph
+#include "types.h"           // For u32, u64
+#include <pthread.h>
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Structures.
+// ---------------------------------------------------------------------------
+// Graph_Version is private to the implementation. A Dynamic_Graph_Snapshot
+// is a pinned version; it must be released on the graph it came from.
+// 'stats' may be pointed at a Container_Stats after dynamic_graph_create()
+// to instrument the graph; snapshots record into the stats of their graph
+// at the time they were acquired (see container_stats.h).
+
+#define DYNAMIC_GRAPH_PAGE_SIZE 1024
+
+typedef struct Graph_Version Graph_Version;
+
+typedef struct
+{
+        pthread_mutex_t writer_lock;  // Serializes dynamic_graph_apply()
+        pthread_mutex_t version_lock; // Guards the version list
+        Graph_Version *current;       // Newest published version
+        Graph_Version *oldest;        // Oldest version not yet reclaimed
+        Container_Stats *stats;       // Opt-in instrumentation (NULL: none)
+} Dynamic_Graph;
+
+typedef struct
+{
+        const Graph_Version *version;
+        Container_Stats *stats;
+} Dynamic_Graph_Snapshot;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Lifetime and updates.
+// ---------------------------------------------------------------------------
+// dynamic_graph_create():
+//     Creates an empty graph with 'vertex_count' isolated vertices.
+//
+// dynamic_graph_apply():
+//     Applies one batch atomically: readers see either none or all of it.
+//     Within a batch deletions are applied before insertions. Edges are
+//     directed and form a set (inserting an existing edge has no effect).
+//     Vertex ids beyond the current count grow the graph. Either list may
+//     be NULL; weights are ignored.
+//
+// dynamic_graph_destroy():
+//     Frees everything. No snapshot may still be pinned.
+
+Result dynamic_graph_create(Dynamic_Graph *graph, u32 vertex_count);
+void dynamic_graph_destroy(Dynamic_Graph *graph);
+Result dynamic_graph_apply(Dynamic_Graph *graph, const Edge_List *inserts,
+                           const Edge_List *deletes);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Snapshots.
+// ---------------------------------------------------------------------------
+// Example usage:
+//     Dynamic_Graph_Snapshot snapshot;
+//     dynamic_graph_acquire(&graph, &snapshot);
+//     const u32 *neighbors;
+//     u32 degree;
+//     dynamic_graph_neighbors(&snapshot, v, &neighbors, &degree);
+//     ...
+//     dynamic_graph_release(&graph, &snapshot);
+//
+// dynamic_graph_neighbors() returns the sorted out-neighbors of a vertex;
+// the pointer stays valid until the snapshot is released.
+// dynamic_graph_to_csr() copies the snapshot into a CSR graph for heavy
+// analytics (BFS, shortest paths, components, ...).
+
+void dynamic_graph_acquire(Dynamic_Graph *graph,
+                           Dynamic_Graph_Snapshot *snapshot);
+void dynamic_graph_release(Dynamic_Graph *graph,
+                           Dynamic_Graph_Snapshot *snapshot);
+
+u64 dynamic_graph_version(const Dynamic_Graph_Snapshot *snapshot);
+u32 dynamic_graph_vertex_count(const Dynamic_Graph_Snapshot *snapshot);
+u64 dynamic_graph_edge_count(const Dynamic_Graph_Snapshot *snapshot);
+Result dynamic_graph_neighbors(const Dynamic_Graph_Snapshot *snapshot,
+                               u32 vertex, const u32 **neighbors, u32 *degree);
+bool dynamic_graph_has_edge(const Dynamic_Graph_Snapshot *snapshot, u32 source,
+                            u32 target);
+Result dynamic_graph_to_csr(const Dynamic_Graph_Snapshot *snapshot,
+                            CSR_Graph *csr);
+
+#endif // !DATA_STRUCTURES_DYNAMIC_GRAPH_H
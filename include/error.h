@@ -20,12 +20,39 @@
 #include "types.h" // Uses bool_t and other basic type aliases defined in types.h
 
 // ---------------------------------------------------------------------------
-// SECTION 1: Enumeration of standardized error/result codes.
+// SECTION 1: Compiler hints.
+// ---------------------------------------------------------------------------
+// DS_LIKELY(x) / DS_UNLIKELY(x):
+//     Tell the compiler which way a condition usually goes, so the rare
+//     branch is laid out away from the hot path.
+//
+// DS_COLD / DS_NOINLINE:
+//     Mark a function as rarely called and keep it out of line, so error
+//     construction does not bloat the callers.
+//
+// All of them expand to nothing on compilers without GNU extensions.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DS_LIKELY(x) __builtin_expect(!!(x), 1)
+#define DS_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define DS_COLD __attribute__((cold))
+#define DS_NOINLINE __attribute__((noinline))
+#else
+#define DS_LIKELY(x) (x)
+#define DS_UNLIKELY(x) (x)
+#define DS_COLD
+#define DS_NOINLINE
+#endif
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Enumeration of standardized error/result codes.
 // ---------------------------------------------------------------------------
 // Each enumerator represents a specific type of failure or success condition.
 // These codes can be used to provide meaningful feedback to higher-level code.
 //
 // Prefix "DS_" stands for "Data Structures", ensuring naming consistency.
+// New codes are appended, so that the value of an existing code never
+// changes.
 
 typedef enum
 {
@@ -45,11 +72,12 @@ typedef enum
     DS_ERROR_NULL_POINTER,   // Null pointer passed where non-null was expected
     DS_ERROR_CORRUPTED_DATA, // Data structure integrity check failed
     DS_ERROR_NOT_IMPLEMENTED, // Functionality not yet implemented
-    DS_ERROR_UNKNOWN          // Catch-all for unexpected errors
+    DS_ERROR_UNKNOWN,         // Catch-all for unexpected errors
+    DS_ERROR_IO               // Operating system I/O call failed
 } Result_Code;
 
 // ---------------------------------------------------------------------------
-// SECTION 2: Result structure definition.
+// SECTION 3: Result structure definition.
 // ---------------------------------------------------------------------------
 // The Result type encapsulates an operation’s outcome, including both
 // the result code and additional debugging context.
@@ -62,6 +90,17 @@ typedef enum
 //
 // This structure allows detailed error tracing during development and
 // debugging without adding runtime exceptions or global state.
+//
+// Compact mode (-DDS_COMPACT_RESULT):
+//     Result is only the Result_Code, so it is returned in a register and
+//     CHECK_RESULT costs a compare. RESULT_ERROR() stores the message, file
+//     and line in a thread-local last-error slot instead; nothing is
+//     recorded on success. The whole program must be built in the same
+//     mode.
+//
+//     Code that works in both modes reads a Result only through
+//     result_code(), result_is_success() / result_is_error() and
+//     result_context(), never through its fields.
 
 typedef struct
 {
@@ -69,37 +108,74 @@ typedef struct
         const char *message;
         const char *file;
         int line;
-} Result;
+} Result_Context;
+
+#ifdef DS_COMPACT_RESULT
+typedef Result_Code Result;
+#else
+typedef Result_Context Result;
+#endif
 
 // ---------------------------------------------------------------------------
-// SECTION 3: Convenience macros for creating results.
+// SECTION 4: Convenience macros for creating results.
 // ---------------------------------------------------------------------------
 // These macros simplify creating Result values inline, automatically
 // capturing the source file and line number for traceability.
 //
+// RESULT_ERROR() goes through result_raise(), which is cold and never
+// inlined: the error path of a caller is a single call.
+//
 // Usage examples:
 //     return RESULT_SUCCESS;
 //     return RESULT_ERROR(DS_ERROR_NOT_FOUND, "Element not found in hash
 //     table");
 
+#ifdef DS_COMPACT_RESULT
+#define RESULT_SUCCESS ((Result)DS_SUCCESS)
+#else
 #define RESULT_SUCCESS ((Result){DS_SUCCESS, "Success.", __FILE__, __LINE__})
-#define RESULT_ERROR(code, msg) ((Result){code, msg, __FILE__, __LINE__})
+#endif
+#define RESULT_ERROR(code, msg) result_raise(code, msg, __FILE__, __LINE__)
 
 // ---------------------------------------------------------------------------
-// SECTION 4: Function declarations for error utilities.
+// SECTION 5: Function declarations for error utilities.
 // ---------------------------------------------------------------------------
 // Implementations (in error_handling.c) typically use switch statements
 // or static lookup tables to provide human-readable descriptions.
+//
+// result_context():
+//     Returns the full context of 'result'. In compact mode this is the
+//     calling thread's last error, provided its code matches 'result';
+//     otherwise only the code and its description are known. Read it
+//     before the thread raises another error.
 
 const char *
 result_description(Result_Code code); // Converts a code to descriptive text
+Result_Context result_context(Result result);
+DS_COLD DS_NOINLINE Result result_raise(Result_Code code, const char *message,
+                                        const char *file, int line);
+
+#ifdef DS_COMPACT_RESULT
+
+static inline Result_Code result_code(Result result) { return result; }
+static inline bool result_is_success(Result result)
+{
+    return result == DS_SUCCESS;
+}
+static inline bool result_is_error(Result result)
+{
+    return result != DS_SUCCESS;
+}
+#else
+static inline Result_Code result_code(Result result) { return result.code; }
 bool result_is_success(
     Result result); // Returns true if result.code == DS_SUCCESS
 bool result_is_error(
     Result result); // Returns true if result.code != DS_SUCCESS
+#endif
 
 // ---------------------------------------------------------------------------
-// SECTION 5: Error checking and propagation macros.
+// SECTION 6: Error checking and propagation macros.
 // ---------------------------------------------------------------------------
 // CHECK_RESULT(expr):
 //     Evaluates an expression expected to return a Result.
@@ -115,12 +191,12 @@ bool result_is_error(
     do                                                                         \
     {                                                                          \
         Result _result = (expr);                                               \
-        if(result_is_error(_result))                                           \
+        if(DS_UNLIKELY(result_code(_result) != DS_SUCCESS))                    \
             return _result;                                                    \
     } while(0)
 
 // ---------------------------------------------------------------------------
-// SECTION 6: Assertion macro for validating conditions.
+// SECTION 7: Assertion macro for validating conditions.
 // ---------------------------------------------------------------------------
 // DS_ASSERT(condition, message):
 //     Checks whether 'condition' is true. If false, returns an error Result
@@ -131,12 +207,25 @@ bool result_is_error(
 //
 // This is a safer alternative to the standard 'assert()', as it provides
 // controlled error handling rather than abruptly aborting execution.
+//
+// Building with -DDS_NO_RUNTIME_CHECKS compiles every DS_ASSERT out (the
+// condition is not evaluated), for release builds whose callers are
+// trusted to pass valid arguments. Allocation failures and other errors
+// not raised through DS_ASSERT are still reported.
 
+#ifdef DS_NO_RUNTIME_CHECKS
+#define DS_ASSERT(condition, message)                                          \
+    do                                                                         \
+    {                                                                          \
+        (void)sizeof(condition);                                               \
+    } while(0)
+#else
 #define DS_ASSERT(condition, message)                                          \
     do                                                                         \
     {                                                                          \
-        if(!(condition))                                                       \
+        if(DS_UNLIKELY(!(condition)))                                          \
             return RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT, message);           \
     } while(0)
+#endif
 
 #endif // !DATA_STRUCTURES_ERROR_H
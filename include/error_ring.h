@@ -0,0 +1,80 @@
+#ifndef DATA_STRUCTURES_ERROR_RING_H
+#define DATA_STRUCTURES_ERROR_RING_H
+
+// ============================================================================
+// File: error_ring.h
+// Description:
+//     Per-thread ring buffers of recent error events, for post-mortem
+//     diagnostics in production.
+//
+//     Once enabled, every error created through RESULT_ERROR() (and so
+//     DS_ASSERT) is recorded with its code, message, source location and a
+//     timestamp in a fixed-size ring owned by the raising thread; the
+//     oldest events are overwritten. Recording is wait-free and does no
+//     I/O: the owner is the only writer of its ring, and readers detect
+//     slots being overwritten with a per-slot sequence number. Only the
+//     first error of a thread claims a ring, which may allocate.
+//
+//     Rings of exited threads are kept, with their events, until a new
+//     thread reuses them, so a dump still shows what the workers of a
+//     finished parallel operation ran into.
+//
+//     Link with -pthread.
+// ============================================================================
+
+#include <stdio.h> // For FILE
+
+#include "error.h" // For Result_Code
+#include "types.h" // For u64, usize
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Event record.
+// ---------------------------------------------------------------------------
+// Fields:
+//   timestamp -> Time stamp counter when the error was raised (TSC ticks
+//                on x86, monotonic nanoseconds elsewhere).
+//   code      -> The error's Result_Code.
+//   line      -> Source line of the RESULT_ERROR().
+//   file      -> Source file of the RESULT_ERROR().
+//   message   -> The error message.
+
+#define ERROR_RING_CAPACITY 64 // Events kept per thread (power of two)
+
+typedef struct
+{
+        u64 timestamp;
+        Result_Code code;
+        int line;
+        const char *file;
+        const char *message;
+} Error_Event;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Recording.
+// ---------------------------------------------------------------------------
+// Recording is disabled by default; error_ring_enable(true) turns it on
+// for every thread. error_ring_record() is called by result_raise() and
+// need not be called directly.
+
+void error_ring_enable(bool enabled);
+bool error_ring_enabled(void);
+void error_ring_record(Result_Code code, const char *message,
+                       const char *file, int line);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Inspection.
+// ---------------------------------------------------------------------------
+// error_ring_snapshot():
+//     Copies up to 'capacity' of the calling thread's most recent events
+//     to 'events', oldest first, and returns how many were copied.
+//
+// error_ring_dump():
+//     Writes the events of every ring, oldest first per thread, to
+//     'stream', one line each with the code's result_description(). May
+//     run while other threads keep raising errors; events overwritten
+//     during the dump are skipped.
+
+usize error_ring_snapshot(Error_Event *events, usize capacity);
+void error_ring_dump(FILE *stream);
+
+#endif // !DATA_STRUCTURES_ERROR_RING_H
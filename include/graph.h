@@ -0,0 +1,148 @@
+#ifndef DATA_STRUCTURES_GRAPH_H
+#define DATA_STRUCTURES_GRAPH_H
+
+// ============================================================================
+// File: graph.h
+// Description:
+//     Static graphs in compressed sparse row (CSR) form.
+//
+//     A CSR graph stores all adjacency lists back to back in a single
+//     'neighbors' array; 'offsets[v]' .. 'offsets[v + 1]' delimits the
+//     neighbors of vertex v. Compared to linked adjacency lists this uses
+//     4 bytes per edge (plus 8 per vertex) and traversals stream through
+//     memory sequentially.
+//
+//     Graphs are built from an edge list by a parallel counting sort:
+//     degrees are counted with atomic increments, turned into offsets by a
+//     prefix sum and each edge is then scattered into its slot. Optional
+//     edge weights live in a separate array parallel to 'neighbors'.
+// ============================================================================
+
+#include "error.h" // For Result and error codes
+#include "types.h" // For u32Array, u64Array, f64Array
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Edge list input.
+// ---------------------------------------------------------------------------
+// Edge i goes from sources.data[i] to targets.data[i]. 'weights' is either
+// empty (unweighted graph) or holds one weight per edge.
+
+typedef struct
+{
+        u32Array sources;
+        u32Array targets;
+        f64Array weights;
+} Edge_List;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: CSR graph structure.
+// ---------------------------------------------------------------------------
+// Fields:
+//   vertex_count -> Number of vertices (ids are 0 .. vertex_count - 1).
+//   edge_count   -> Number of stored (directed) edges.
+//   offsets      -> vertex_count + 1 entries; offsets[v] is the index of
+//                   the first neighbor of v.
+//   neighbors    -> edge_count target vertex ids.
+//   weights      -> edge_count weights, or empty for unweighted graphs.
+
+typedef struct
+{
+        u32 vertex_count;
+        u64 edge_count;
+        u64Array offsets;
+        u32Array neighbors;
+        f64Array weights;
+} CSR_Graph;
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Construction options.
+// ---------------------------------------------------------------------------
+//   CSR_BUILD_SYMMETRIC -> Also insert the reverse of every edge (undirected
+//                          graphs). Self loops are stored once.
+//   CSR_BUILD_SORTED    -> Sort every adjacency list by target id. Without
+//                          it the order of neighbors is unspecified.
+
+typedef enum
+{
+    CSR_BUILD_DEFAULT = 0,
+    CSR_BUILD_SYMMETRIC = 1 << 0,
+    CSR_BUILD_SORTED = 1 << 1
+} CSR_Build_Flags;
+
+// ---------------------------------------------------------------------------
+// SECTION 4: Construction and destruction.
+// ---------------------------------------------------------------------------
+// csr_graph_build():
+//     Builds 'graph' from 'edges'. Fails with DS_ERROR_INDEX_OUT_OF_BOUNDS
+//     if an edge references a vertex >= vertex_count. On failure 'graph' is
+//     left empty.
+//
+// csr_graph_transpose():
+//     Builds the graph with every edge reversed (in-neighbors become
+//     out-neighbors), keeping weights.
+//
+// csr_graph_sort_neighbors():
+//     Sorts every adjacency list by target id (as CSR_BUILD_SORTED does).
+//
+// csr_graph_destroy():
+//     Releases the arrays owned by the graph and zeroes it.
+
+Result csr_graph_build(CSR_Graph *graph, u32 vertex_count,
+                       const Edge_List *edges, u32 flags);
+Result csr_graph_transpose(const CSR_Graph *graph, CSR_Graph *transposed);
+Result csr_graph_sort_neighbors(CSR_Graph *graph);
+void csr_graph_destroy(CSR_Graph *graph);
+
+// ---------------------------------------------------------------------------
+// SECTION 5: Neighbor iteration.
+// ---------------------------------------------------------------------------
+// These helpers are defined inline because they sit in the innermost loop
+// of every traversal.
+//
+// Example usage:
+//     CSR_Neighbors it = csr_neighbors(&graph, v);
+//     u32 target;
+//     f64 weight;
+//     while(csr_neighbors_next(&it, &target, &weight))
+//         visit(target, weight);
+//
+// Unweighted graphs report a weight of 1.0 for every edge.
+
+typedef struct
+{
+        const u32 *target;
+        const u32 *end;
+        const f64 *weight; // NULL for unweighted graphs
+} CSR_Neighbors;
+
+static inline u64 csr_graph_degree(const CSR_Graph *graph, u32 vertex)
+{
+    return graph->offsets.data[vertex + 1] - graph->offsets.data[vertex];
+}
+
+static inline CSR_Neighbors csr_neighbors(const CSR_Graph *graph, u32 vertex)
+{
+    u64 first = graph->offsets.data[vertex];
+    u64 last = graph->offsets.data[vertex + 1];
+    CSR_Neighbors it = {graph->neighbors.data + first,
+                        graph->neighbors.data + last,
+                        graph->weights.size ? graph->weights.data + first
+                                            : NULL};
+    return it;
+}
+
+static inline bool csr_neighbors_next(CSR_Neighbors *it, u32 *target,
+                                      f64 *weight)
+{
+    if(it->target == it->end)
+        return false;
+
+    *target = *it->target++;
+    if(weight)
+        *weight = it->weight ? *it->weight : 1.0;
+    if(it->weight)
+        it->weight++;
+    return true;
+}
+
+#endif // !DATA_STRUCTURES_GRAPH_H
@@ -0,0 +1,112 @@
+#ifndef DATA_STRUCTURES_LOADER_H
+#define DATA_STRUCTURES_LOADER_H
+
+// ============================================================================
+// File: loader.h
+// Description:
+//     Asynchronous bulk loading of files, overlapping reads with decoding.
+//
+//     loader_run() reads a list of files in fixed-size chunks, keeping up
+//     to 'queue_depth' reads in flight, and hands every chunk to the file's
+//     decoder on the calling thread as soon as it and the chunks before it
+//     have arrived. While one chunk is being decoded the following ones
+//     are still being read, so I/O and decoding overlap.
+//
+//     Reads are submitted through io_uring (set up with raw system calls,
+//     no liburing needed). If the kernel does not provide it, or with
+//     LOADER_NO_URING, blocking pread() calls run as tasks on the shared
+//     thread pool (parallel.h) instead.
+//
+//     Files are started in order: chunks of the next file are only read
+//     once every chunk of the previous files has been submitted, so only
+//     a few files are open at any time.
+// ============================================================================
+
+#include "error.h"  // For Result
+#include "stream.h" // For Stream_Record_Header
+#include "types.h"  // For GenericData, byteArray
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Requests and options.
+// ---------------------------------------------------------------------------
+// chunk_fn: decodes the 'size' bytes found at 'offset' in the file. Chunks
+// of a file arrive in order; a last call with size 0 (and data NULL) marks
+// the end of the file. An error stops the whole load.
+//
+// Loader_Options:
+//   chunk_size  -> Bytes per read (rounded up to 4 KiB).
+//   queue_depth -> Reads in flight (and chunk buffers allocated).
+//   flags       -> LOADER_NO_URING forces the thread pool fallback.
+
+typedef Result (*chunk_fn)(ptr context, const byte *data, usize size,
+                           u64 offset);
+
+typedef struct
+{
+        const char *path;
+        chunk_fn decode;
+        ptr context;
+} Load_Request;
+
+typedef enum
+{
+    LOADER_DEFAULT = 0,
+    LOADER_NO_URING = 1 << 0
+} Loader_Flags;
+
+typedef struct
+{
+        usize chunk_size;
+        usize queue_depth;
+        u32 flags;
+} Loader_Options;
+
+#define LOADER_DEFAULT_OPTIONS ((Loader_Options){1 << 20, 32, LOADER_DEFAULT})
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Loading.
+// ---------------------------------------------------------------------------
+// loader_run():
+//     Loads every requested file. Fails with DS_ERROR_IO if a file cannot
+//     be opened or read (or shrinks during the load), or with the first
+//     error returned by a decoder; reads in flight are waited for before
+//     returning in every case.
+//
+// Example usage:
+//     byteArray first = {0}, second = {0};
+//     Load_Request requests[] = {{"a.bin", loader_append_bytes, &first},
+//                                {"b.bin", loader_append_bytes, &second}};
+//     CHECK_RESULT(loader_run(requests, 2, LOADER_DEFAULT_OPTIONS));
+
+Result loader_run(const Load_Request *requests, usize count,
+                  Loader_Options options);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Decoders.
+// ---------------------------------------------------------------------------
+// loader_append_bytes():
+//     Appends the file to the byteArray given as context.
+//
+// loader_decode_records():
+//     Decodes the container records written by stream_write_*() (see
+//     stream.h) and appends their elements to the GenericData of a
+//     Record_Decoder given as context. Fails with DS_ERROR_CORRUPTED_DATA
+//     on a damaged header, on elements of another size than the output's,
+//     or if the file ends inside a record. The output grows with the
+//     element bytes received, not with the counts claimed by headers.
+
+typedef struct
+{
+        GenericData *output;
+        Stream_Record_Header header;
+        usize header_filled; // Bytes of 'header' received so far
+        u64 remaining;       // Element bytes left in the current record
+} Record_Decoder;
+
+Result loader_append_bytes(ptr array, const byte *data, usize size,
+                           u64 offset);
+void record_decoder_init(Record_Decoder *decoder, GenericData *output);
+Result loader_decode_records(ptr decoder, const byte *data, usize size,
+                             u64 offset);
+
+#endif // !DATA_STRUCTURES_LOADER_H
@@ -29,13 +29,21 @@
 // program. Useful for debugging memory leaks, performance issues, and tracking
 // general allocation patterns.
 //
+// Byte counts are usable block sizes (malloc_usable_size()), which may
+// exceed the sizes requested.
+//
 // Fields:
 //   total_allocated -> Cumulative total of bytes ever allocated.
 //   total_freed     -> Cumulative total of bytes ever freed.
 //   current_usage   -> Currently allocated memory (total_allocated -
-//   total_freed). peak_usage      -> Maximum memory usage recorded so far.
-//   allocation_count-> Number of allocation calls performed.
+//                      total_freed).
+//   peak_usage      -> Maximum memory usage recorded so far.
+//   allocation_count-> Number of allocation calls performed; a reallocation
+//                      counts as one allocation and, when it replaces a
+//                      block, one free.
 //   free_count      -> Number of free calls performed.
+//   pending_reclaim -> Bytes retired by concurrent containers but not freed
+//                      yet, waiting for readers to move on (see reclaim.h).
 
 typedef struct
 {
@@ -45,8 +53,27 @@ typedef struct
         usize peak_usage;
         usize allocation_count;
         usize free_count;
+        usize pending_reclaim;
 } Memory_Stats;
 
+// Allocations are also counted per size class: class 0 holds requests of
+// up to DS_SIZE_CLASS_MIN bytes, each following class requests of up to
+// twice the previous limit, and the last class everything larger.
+//
+// Fields:
+//   allocation_count -> Allocation calls per size class, reallocations
+//                       included (by their new size).
+//   allocated_bytes  -> Bytes requested per size class.
+
+#define DS_SIZE_CLASS_COUNT 24
+#define DS_SIZE_CLASS_MIN 16
+
+typedef struct
+{
+        usize allocation_count[DS_SIZE_CLASS_COUNT];
+        usize allocated_bytes[DS_SIZE_CLASS_COUNT];
+} Size_Class_Stats;
+
 // ---------------------------------------------------------------------------
 // SECTION 2: Generic memory management functions.
 // ---------------------------------------------------------------------------
@@ -60,6 +87,16 @@ typedef struct
 //   - ds_free() releases a previously allocated block.
 //
 // All these functions should internally update the global Memory_Stats data.
+// Statistics are updated atomically, so every function may be called from
+// several threads at once. Byte counts are the usable sizes reported by
+// malloc_usable_size(), so the module requires glibc (or another C library
+// providing it in <malloc.h>).
+//
+// ds_aligned_alloc() returns zero-initialized memory aligned to 'alignment'
+// (a power of two), to be released with ds_free(). Aligning data written by
+// different threads to DS_CACHE_LINE_SIZE avoids false sharing.
+
+#define DS_CACHE_LINE_SIZE 64
 
 ptr ds_malloc(usize size); // Allocates a block of memory of 'size' bytes
 ptr ds_calloc(
@@ -69,6 +106,8 @@ ptr ds_realloc(
     ptr pointer,
     usize new_size);       // Resizes memory block, preserving previous contents
 void ds_free(ptr pointer); // Frees allocated memory block
+ptr ds_aligned_alloc(usize alignment,
+                     usize size); // Allocates zeroed, aligned memory
 
 // ---------------------------------------------------------------------------
 // SECTION 3: Array-specific memory utilities.
@@ -83,6 +122,25 @@ ptr ds_alloc_array(usize count,
 ptr ds_realloc_array(ptr array, usize new_count,
                      usize element_size); // Resizes array memory block
 
+// ds_array_reserve():
+//     Grows the storage behind a (data, capacity) pair so that it can hold at
+//     least 'needed' elements, using calculate_growth() for amortized O(1)
+//     appends. Existing elements are preserved; nothing happens if the
+//     capacity is already large enough.
+//
+// ARRAY_RESERVE(array, needed):
+//     Same as above for any DECLARE_TYPE array (i32Array, byteArray, ...).
+//
+// Example:
+//     CHECK_RESULT(ARRAY_RESERVE(&bytes, bytes.size + 64));
+
+Result ds_array_reserve(ptr *data, usize *capacity, usize needed,
+                        usize element_size);
+
+#define ARRAY_RESERVE(array, needed)                                           \
+    ds_array_reserve((ptr *)&(array)->data, &(array)->capacity, (needed),      \
+                     sizeof(*(array)->data))
+
 // ---------------------------------------------------------------------------
 // SECTION 4: Memory copy and manipulation utilities.
 // ---------------------------------------------------------------------------
@@ -110,12 +168,24 @@ void ds_memset(ptr dest, byte value, usize size); // Equivalent to memset()
 //     Memory_Stats stats = ds_get_memory_stats();
 //     printf("Current usage: %zu bytes\n", stats.current_usage);
 //
-// ds_reset_memory_stats() clears all counters, useful for test isolation.
+// ds_get_size_class_stats() snapshots the per-size-class counters the same
+// way, and ds_size_class_limit() is the largest request of a class
+// (0 for the last, unbounded one). To export the statistics, see
+// metrics.h.
+//
+// ds_reset_memory_stats() clears all counters, useful for test isolation;
+// current_usage is kept (the blocks are still allocated) and becomes the
+// new peak_usage.
+// ds_adjust_pending_reclaim() is used by deferred reclamation schemes to
+// account for retired bytes (positive delta) and their release (negative).
 
 Memory_Stats
 ds_get_memory_stats(void);        // Returns a snapshot of current statistics
-void ds_reset_memory_stats(void); // Resets all counters to zero
+void ds_reset_memory_stats(void); // Resets the cumulative counters
 void ds_print_memory_stats(void); // Prints formatted statistics to stdout
+void ds_adjust_pending_reclaim(isize delta); // Updates pending_reclaim
+Size_Class_Stats ds_get_size_class_stats(void); // Per-size-class snapshot
+usize ds_size_class_limit(usize size_class);    // Largest size of a class
 
 // ---------------------------------------------------------------------------
 // SECTION 6: Helper macros for safe, type-aware allocations.
@@ -126,6 +196,7 @@ void ds_print_memory_stats(void); // Prints formatted statistics to stdout
 //     MyStruct* obj = ALLOC(MyStruct);
 //     int* arr = ALLOC_ARRAY(int, 10);
 //     arr = REALLOC_ARRAY(arr, int, 20);
+//     Worker* workers = ALLOC_ALIGNED(Worker, 8); // Cache-line aligned
 //     FREE(arr);
 //
 // They improve readability and reduce casting errors.
@@ -134,6 +205,8 @@ void ds_print_memory_stats(void); // Prints formatted statistics to stdout
 #define ALLOC_ARRAY(type, count) ((type *)ds_alloc_array(count, sizeof(type)))
 #define REALLOC_ARRAY(ptr, type, new_count)                                    \
     ((type *)ds_realloc_array(ptr, new_count, sizeof(type)))
+#define ALLOC_ALIGNED(type, count)                                             \
+    ((type *)ds_aligned_alloc(DS_CACHE_LINE_SIZE, (count) * sizeof(type)))
 #define FREE(ptr) ds_free(ptr)
 
 // ---------------------------------------------------------------------------
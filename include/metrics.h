@@ -0,0 +1,55 @@
+#ifndef DATA_STRUCTURES_METRICS_H
+#define DATA_STRUCTURES_METRICS_H
+
+// ============================================================================
+// File: metrics.h
+// Description:
+//     Export of the library's statistics for monitoring: Memory_Stats,
+//     the per-size-class allocation counters and any number of
+//     Container_Stats, formatted as Prometheus text exposition or JSON.
+//
+//     Formatting writes into a caller-supplied buffer and never allocates
+//     or locks: the statistics are read with the same relaxed atomic loads
+//     as their snapshot functions, so a scraper thread can format as often
+//     as it likes without disturbing the threads recording them. Each
+//     histogram is copied to the stack before being reduced, so that its
+//     count and quantiles agree.
+//
+//     Per container and operation kind, the probe length and (with
+//     CONTAINER_STATS_LATENCY) latency histograms are reduced to their
+//     count and p50/p90/p99/p999/max bucket lower bounds; operation kinds
+//     that never ran are left out.
+// ============================================================================
+
+#include "container_stats.h" // For Container_Stats
+#include "error.h"           // For Result
+#include "types.h"           // For usize
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Formatting.
+// ---------------------------------------------------------------------------
+// Example usage:
+//     static char page[1 << 16];
+//     const Container_Stats *containers[] = {&queue_stats, &graph_stats};
+//     usize length;
+//     CHECK_RESULT(metrics_format_prometheus(page, sizeof(page), containers,
+//                                            2, &length));
+//     write(client, page, length);
+//
+// Both functions write a NUL-terminated document and report its length
+// (without the NUL) through 'length'. When 'capacity' is too small they
+// return DS_ERROR_OVERFLOW with 'length' set to the capacity needed
+// (including the NUL); the buffer then holds a truncated document.
+// 'containers' may be NULL when 'container_count' is 0.
+//
+// Prometheus metric names start with "ds_"; containers are told apart by
+// their "container" label (their name, or "unnamed").
+
+Result metrics_format_prometheus(char *buffer, usize capacity,
+                                 const Container_Stats *const *containers,
+                                 usize container_count, usize *length);
+Result metrics_format_json(char *buffer, usize capacity,
+                           const Container_Stats *const *containers,
+                           usize container_count, usize *length);
+
+#endif // !DATA_STRUCTURES_METRICS_H
@@ -0,0 +1,140 @@
+#ifndef DATA_STRUCTURES_PARALLEL_H
+#define DATA_STRUCTURES_PARALLEL_H
+
+// ============================================================================
+// File: parallel.h
+// Description:
+//     Fork-join scheduling shared by the parallel algorithms of the library
+//     (graph construction, traversals, sorting, ...).
+//
+//     A single work-stealing pool of ds_parallel_thread_count() - 1 worker
+//     threads is started on first use; the thread waiting for parallel work
+//     always takes part in it. Every worker owns a Chase-Lev deque: it
+//     pushes and pops spawned tasks at the bottom (LIFO, cache-warm) while
+//     idle workers steal from the top of random victims (FIFO, the largest
+//     pieces of work). Threads outside the pool hand their tasks over
+//     through a shared injection queue. Idle workers sleep on a condition
+//     variable, so an unused pool costs no CPU time.
+//
+//     ds_parallel_for() splits an index range into contiguous pieces and
+//     runs a callback on each piece, possibly on several threads, returning
+//     once every piece has completed. Callbacks must only touch disjoint
+//     data or use atomic operations.
+//
+//     Link with -pthread.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "types.h" // For usize, ptr
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Callback types.
+// ---------------------------------------------------------------------------
+// range_fn: processes the half-open index range [begin, end). 'context' is
+// the pointer given to ds_parallel_for(), shared by all pieces.
+//
+// task_fn: runs one spawned task with the context given to ds_task_spawn().
+
+typedef void (*range_fn)(usize begin, usize end, ptr context);
+typedef void (*task_fn)(ptr context);
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Thread count configuration.
+// ---------------------------------------------------------------------------
+// By default the number of online processors is used. Setting the count to
+// 1 makes every parallel algorithm run serially on the calling thread,
+// which is handy for debugging. Passing 0 restores the default.
+//
+// Changing the count, like ds_parallel_shutdown(), stops the worker
+// threads; the pool is restarted with the new size on next use. Neither
+// may be called while parallel work is running.
+
+usize ds_parallel_thread_count(void);
+void ds_parallel_set_thread_count(usize count);
+void ds_parallel_shutdown(void);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Parallel loop.
+// ---------------------------------------------------------------------------
+// ds_parallel_for(begin, end, grain, body, context):
+//     Calls body() on pieces covering [begin, end). Pieces are never smaller
+//     than 'grain' elements (except the last one), so small ranges run
+//     inline without any threading overhead.
+//
+// Example usage:
+//     static void scale(usize begin, usize end, ptr context)
+//     {
+//         f64Array *values = context;
+//         for(usize i = begin; i < end; i++)
+//             values->data[i] *= 2.0;
+//     }
+//     CHECK_RESULT(ds_parallel_for(0, values.size, 4096, scale, &values));
+
+Result ds_parallel_for(usize begin, usize end, usize grain, range_fn body,
+                       ptr context);
+
+// ---------------------------------------------------------------------------
+// SECTION 4: Tasks.
+// ---------------------------------------------------------------------------
+// ds_task_spawn() makes a task available to the pool and returns at once;
+// ds_task_sync() returns once every task spawned in the group (including
+// tasks spawned after the sync started) has completed, running pending
+// tasks itself meanwhile. The Task storage is provided by the caller and
+// must stay valid until the sync returns, so fork-join code keeps it on
+// the stack and spawning never allocates. Tasks may spawn and sync nested
+// groups. When a deque is full the task simply runs inline.
+//
+// Example usage:
+//     Task_Group group = TASK_GROUP_INIT;
+//     Task left_task;
+//     ds_task_spawn(&group, &left_task, sort_half, &left);
+//     sort_half(&right);
+//     ds_task_sync(&group);
+
+typedef struct Task_Group
+{
+        usize pending; // Spawned tasks not completed yet
+} Task_Group;
+
+typedef struct Task
+{
+        task_fn run;
+        ptr context;
+        Task_Group *group;
+        struct Task *next; // Link in the injection queue
+} Task;
+
+#define TASK_GROUP_INIT ((Task_Group){0})
+
+void ds_task_spawn(Task_Group *group, Task *task, task_fn run, ptr context);
+void ds_task_sync(Task_Group *group);
+
+// ---------------------------------------------------------------------------
+// SECTION 5: Fixed blocks.
+// ---------------------------------------------------------------------------
+// Multi-pass algorithms (scans, compaction, histograms, ...) need the same
+// partition of a range in every pass, which ds_parallel_for() does not
+// guarantee. They split [0, count) into ds_parallel_block_count() blocks
+// and run ds_parallel_for() over the block indices instead:
+//
+//     usize blocks = ds_parallel_block_count(count, 4096);
+//     ds_parallel_for(0, blocks, 1, per_block, &state);
+//     ...
+//     usize first, last;
+//     ds_parallel_block_range(count, blocks, block, &first, &last);
+//
+// The count is a few blocks per thread, but never more than one per
+// 'grain' elements, and at least 1.
+
+usize ds_parallel_block_count(usize count, usize grain);
+
+static inline void ds_parallel_block_range(usize count, usize block_count,
+                                           usize block, usize *first,
+                                           usize *last)
+{
+    *first = count / block_count * block +
+             (block < count % block_count ? block : count % block_count);
+    *last = *first + count / block_count + (block < count % block_count);
+}
+
+#endif // !DATA_STRUCTURES_PARALLEL_H
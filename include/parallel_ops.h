@@ -0,0 +1,327 @@
+#ifndef DATA_STRUCTURES_PARALLEL_OPS_H
+#define DATA_STRUCTURES_PARALLEL_OPS_H
+
+// ============================================================================
+// File: parallel_ops.h
+// Description:
+//     Parallel bulk operations over arrays: map, filter (stream
+//     compaction), reduce and prefix sum (scan).
+//
+//     Two flavors are provided:
+//
+//       - Generic functions over GenericData, driven by map_fn,
+//         predicate_fn and combine_fn callbacks (see types.h).
+//       - Generator macros producing typed functions over DECLARE_TYPE
+//         arrays with the operation written as an expression, so that it
+//         is inlined into the loop instead of being called per element.
+//
+//     Reductions and scans only require the operation to be associative;
+//     blocks are always combined in index order. Filters are stable.
+//     All functions run on the shared pool (see parallel.h).
+// ============================================================================
+
+#include "error.h"    // For Result
+#include "memory.h"   // For ALLOC_ARRAY, ARRAY_RESERVE (generated code)
+#include "parallel.h" // For ds_parallel_for, blocks (generated code)
+#include "types.h"    // For GenericData, callbacks, typed arrays
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Generic operations.
+// ---------------------------------------------------------------------------
+// ds_parallel_map():
+//     output[i] = map(input[i]). 'output->element_size' must be set by the
+//     caller; the output is resized to input->size elements.
+//
+// ds_parallel_filter():
+//     Copies the elements for which keep() is true to 'output', preserving
+//     their order. The output takes the element size of the input.
+//
+// ds_parallel_reduce():
+//     Folds all elements into 'result', starting from 'identity'.
+//
+// ds_parallel_prefix_sum():
+//     Exclusive scan in place: data[i] becomes identity op data[0] op ...
+//     op data[i - 1]. The fold of all elements is stored in 'total' (may be
+//     NULL).
+//
+// Example usage:
+//     static void add_u64(ptr accumulator, cptr value)
+//     {
+//         *(u64 *)accumulator += *(const u64 *)value;
+//     }
+//     u64 zero = 0, total;
+//     CHECK_RESULT(ds_parallel_reduce(&data, &zero, add_u64, &total));
+
+Result ds_parallel_map(const GenericData *input, GenericData *output,
+                       map_fn map);
+Result ds_parallel_filter(const GenericData *input, GenericData *output,
+                          predicate_fn keep);
+Result ds_parallel_reduce(const GenericData *input, cptr identity,
+                          combine_fn combine, ptr result);
+Result ds_parallel_prefix_sum(GenericData *data, cptr identity,
+                              combine_fn combine, ptr total);
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Prebuilt typed operations.
+// ---------------------------------------------------------------------------
+// Exclusive prefix sums and sums of the common numeric arrays. Sums wrap
+// around on overflow like the underlying unsigned type.
+
+Result ds_prefix_sum_u32(u32Array *array, u32 *total);
+Result ds_prefix_sum_u64(u64Array *array, u64 *total);
+Result ds_sum_u64(const u64Array *array, u64 *result);
+Result ds_sum_f64(const f64Array *array, f64 *result);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Typed operation generators.
+// ---------------------------------------------------------------------------
+// Each macro defines a static function 'name' (plus static helpers with
+// the same prefix) in the including file. The operation is an expression:
+//
+//   DEFINE_PARALLEL_MAP(name, In, Out, expression of x)
+//       Result name(const InArray *input, OutArray *output);
+//   DEFINE_PARALLEL_FILTER(name, T, condition on x)
+//       Result name(const TArray *input, TArray *output);
+//   DEFINE_PARALLEL_REDUCE(name, T, identity, expression of a and b)
+//       Result name(const TArray *input, T *result);
+//   DEFINE_PARALLEL_SCAN(name, T, identity, expression of a and b)
+//       Result name(TArray *array, T *total);   // 'total' may be NULL
+//
+// Filter conditions are evaluated twice per element (count, then copy),
+// so they must be pure.
+//
+// Example usage:
+//     DEFINE_PARALLEL_MAP(square_all, f64, f64, x * x)
+//     DEFINE_PARALLEL_FILTER(keep_positive, i32, x > 0)
+//     DEFINE_PARALLEL_REDUCE(max_of, i32, INT32_MIN, a > b ? a : b)
+//
+//     CHECK_RESULT(square_all(&values, &squares));
+
+// Minimum number of elements per parallel piece or block.
+#define PARALLEL_OPS_GRAIN 16384
+
+#define DEFINE_PARALLEL_MAP(name, In, Out, expression)                         \
+    typedef struct                                                             \
+    {                                                                          \
+            const In *input;                                                   \
+            Out *output;                                                       \
+    } name##_Map;                                                              \
+                                                                               \
+    static inline Out name##_apply(In x) { return (expression); }              \
+                                                                               \
+    static void name##_range(usize begin, usize end, ptr context)              \
+    {                                                                          \
+        name##_Map *map = (name##_Map *)context;                               \
+        for(usize i = begin; i < end; i++)                                     \
+            map->output[i] = name##_apply(map->input[i]);                      \
+    }                                                                          \
+                                                                               \
+    static Result name(const In##Array *input, Out##Array *output)             \
+    {                                                                          \
+        DS_ASSERT(input != NULL && output != NULL,                             \
+                  "Arguments must not be NULL");                               \
+        CHECK_RESULT(ARRAY_RESERVE(output, input->size));                      \
+        name##_Map map = {input->data, output->data};                          \
+        output->size = input->size;                                            \
+        return ds_parallel_for(0, input->size, PARALLEL_OPS_GRAIN,             \
+                               name##_range, &map);                            \
+    }
+
+#define DEFINE_PARALLEL_FILTER(name, T, condition)                             \
+    typedef struct                                                             \
+    {                                                                          \
+            const T *input;                                                    \
+            T *output;                                                         \
+            usize *offsets;                                                    \
+            usize count;                                                       \
+            usize block_count;                                                 \
+    } name##_Filter;                                                           \
+                                                                               \
+    static inline bool name##_keep(T x) { return (condition); }                \
+                                                                               \
+    static void name##_count(usize begin, usize end, ptr context)              \
+    {                                                                          \
+        name##_Filter *filter = (name##_Filter *)context;                      \
+        for(usize block = begin; block < end; block++)                         \
+        {                                                                      \
+            usize first, last, kept = 0;                                       \
+            ds_parallel_block_range(filter->count, filter->block_count,        \
+                                    block, &first, &last);                     \
+            for(usize i = first; i < last; i++)                                \
+                kept += name##_keep(filter->input[i]);                         \
+            filter->offsets[block] = kept;                                     \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static void name##_copy(usize begin, usize end, ptr context)               \
+    {                                                                          \
+        name##_Filter *filter = (name##_Filter *)context;                      \
+        for(usize block = begin; block < end; block++)                         \
+        {                                                                      \
+            usize first, last;                                                 \
+            usize next = filter->offsets[block];                               \
+            ds_parallel_block_range(filter->count, filter->block_count,        \
+                                    block, &first, &last);                     \
+            for(usize i = first; i < last; i++)                                \
+                if(name##_keep(filter->input[i]))                              \
+                    filter->output[next++] = filter->input[i];                 \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static Result name(const T##Array *input, T##Array *output)                \
+    {                                                                          \
+        DS_ASSERT(input != NULL && output != NULL && input != output,          \
+                  "Arguments must not be NULL or aliased");                    \
+        name##_Filter filter = {input->data, NULL, NULL, input->size,          \
+                                ds_parallel_block_count(input->size,           \
+                                                        PARALLEL_OPS_GRAIN)};  \
+        filter.offsets = ALLOC_ARRAY(usize, filter.block_count);               \
+        if(!filter.offsets)                                                    \
+            return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,                    \
+                                "Failed to allocate filter offsets");          \
+                                                                               \
+        Result result = ds_parallel_for(0, filter.block_count, 1,              \
+                                        name##_count, &filter);                \
+        usize kept = 0;                                                        \
+        for(usize block = 0; block < filter.block_count; block++)              \
+        {                                                                      \
+            usize count = filter.offsets[block];                               \
+            filter.offsets[block] = kept;                                      \
+            kept += count;                                                     \
+        }                                                                      \
+        if(result_is_success(result))                                          \
+            result = ARRAY_RESERVE(output, kept);                              \
+        if(result_is_success(result))                                          \
+        {                                                                      \
+            filter.output = output->data;                                      \
+            output->size = kept;                                               \
+            result = ds_parallel_for(0, filter.block_count, 1, name##_copy,    \
+                                     &filter);                                 \
+        }                                                                      \
+        ds_free(filter.offsets);                                               \
+        return result;                                                         \
+    }
+
+#define DEFINE_PARALLEL_REDUCE(name, T, identity, expression)                  \
+    typedef struct                                                             \
+    {                                                                          \
+            const T *input;                                                    \
+            T *partials;                                                       \
+            usize count;                                                       \
+            usize block_count;                                                 \
+    } name##_Reduce;                                                           \
+                                                                               \
+    static inline T name##_combine(T a, T b) { return (expression); }          \
+                                                                               \
+    static void name##_blocks(usize begin, usize end, ptr context)             \
+    {                                                                          \
+        name##_Reduce *reduce = (name##_Reduce *)context;                      \
+        for(usize block = begin; block < end; block++)                         \
+        {                                                                      \
+            usize first, last;                                                 \
+            ds_parallel_block_range(reduce->count, reduce->block_count,        \
+                                    block, &first, &last);                     \
+            T partial = (identity);                                            \
+            for(usize i = first; i < last; i++)                                \
+                partial = name##_combine(partial, reduce->input[i]);           \
+            reduce->partials[block] = partial;                                 \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static Result name(const T##Array *input, T *result)                       \
+    {                                                                          \
+        DS_ASSERT(input != NULL && result != NULL,                             \
+                  "Arguments must not be NULL");                               \
+        name##_Reduce reduce = {input->data, NULL, input->size,                \
+                                ds_parallel_block_count(input->size,           \
+                                                        PARALLEL_OPS_GRAIN)};  \
+        reduce.partials = ALLOC_ARRAY(T, reduce.block_count);                  \
+        if(!reduce.partials)                                                   \
+            return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,                    \
+                                "Failed to allocate reduce partials");         \
+                                                                               \
+        Result status = ds_parallel_for(0, reduce.block_count, 1,              \
+                                        name##_blocks, &reduce);               \
+        T total = (identity);                                                  \
+        for(usize block = 0; block < reduce.block_count; block++)              \
+            total = name##_combine(total, reduce.partials[block]);             \
+        if(result_is_success(status))                                          \
+            *result = total;                                                   \
+        ds_free(reduce.partials);                                              \
+        return status;                                                         \
+    }
+
+#define DEFINE_PARALLEL_SCAN(name, T, identity, expression)                    \
+    typedef struct                                                             \
+    {                                                                          \
+            T *data;                                                           \
+            T *sums;                                                           \
+            usize count;                                                       \
+            usize block_count;                                                 \
+    } name##_Scan;                                                             \
+                                                                               \
+    static inline T name##_combine(T a, T b) { return (expression); }          \
+                                                                               \
+    static void name##_sum_blocks(usize begin, usize end, ptr context)         \
+    {                                                                          \
+        name##_Scan *scan = (name##_Scan *)context;                            \
+        for(usize block = begin; block < end; block++)                         \
+        {                                                                      \
+            usize first, last;                                                 \
+            ds_parallel_block_range(scan->count, scan->block_count, block,     \
+                                    &first, &last);                            \
+            T sum = (identity);                                                \
+            for(usize i = first; i < last; i++)                                \
+                sum = name##_combine(sum, scan->data[i]);                      \
+            scan->sums[block] = sum;                                           \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static void name##_scan_blocks(usize begin, usize end, ptr context)        \
+    {                                                                          \
+        name##_Scan *scan = (name##_Scan *)context;                            \
+        for(usize block = begin; block < end; block++)                         \
+        {                                                                      \
+            usize first, last;                                                 \
+            ds_parallel_block_range(scan->count, scan->block_count, block,     \
+                                    &first, &last);                            \
+            T running = scan->sums[block];                                     \
+            for(usize i = first; i < last; i++)                                \
+            {                                                                  \
+                T value = scan->data[i];                                       \
+                scan->data[i] = running;                                       \
+                running = name##_combine(running, value);                      \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static Result name(T##Array *array, T *total)                              \
+    {                                                                          \
+        DS_ASSERT(array != NULL, "Array must not be NULL");                    \
+        name##_Scan scan = {array->data, NULL, array->size,                    \
+                            ds_parallel_block_count(array->size,               \
+                                                    PARALLEL_OPS_GRAIN)};      \
+        scan.sums = ALLOC_ARRAY(T, scan.block_count);                          \
+        if(!scan.sums)                                                         \
+            return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,                    \
+                                "Failed to allocate scan block sums");         \
+                                                                               \
+        Result result = ds_parallel_for(0, scan.block_count, 1,                \
+                                        name##_sum_blocks, &scan);             \
+        T running = (identity);                                                \
+        for(usize block = 0; block < scan.block_count; block++)                \
+        {                                                                      \
+            T sum = scan.sums[block];                                          \
+            scan.sums[block] = running;                                        \
+            running = name##_combine(running, sum);                            \
+        }                                                                      \
+        if(result_is_success(result))                                          \
+            result = ds_parallel_for(0, scan.block_count, 1,                   \
+                                     name##_scan_blocks, &scan);               \
+        if(result_is_success(result) && total)                                 \
+            *total = running;                                                  \
+        ds_free(scan.sums);                                                    \
+        return result;                                                         \
+    }
+
+#endif // !DATA_STRUCTURES_PARALLEL_OPS_H
@@ -0,0 +1,129 @@
+#ifndef DATA_STRUCTURES_RECLAIM_H
+#define DATA_STRUCTURES_RECLAIM_H
+
+// ============================================================================
+// File: reclaim.h
+// Description:
+//     Safe memory reclamation for lock-free containers.
+//
+//     A lock-free container cannot free a node as soon as it is unlinked:
+//     other threads may still be reading it. The node is "retired" instead
+//     and freed once no thread can hold a reference any more. Two schemes
+//     are provided:
+//
+//       - Epoch-based reclamation (EBR): readers announce the global epoch
+//         when entering a critical section. The epoch only advances once
+//         every active reader has seen the current one, so memory retired
+//         in epoch e is safe to free from epoch e + 2 on. Entering and
+//         leaving cost a store each; memory is bounded only as long as
+//         readers keep leaving their critical sections.
+//       - Hazard pointers (HP): readers publish every pointer they are
+//         about to dereference in one of HAZARD_SLOTS slots, and a retired
+//         node is freed once no slot holds it. Reads cost a fence each, but
+//         the amount of unreclaimed memory stays bounded even if a reader
+//         stalls.
+//
+//     Retired memory is released in batches, through the object's
+//     destroy_fn or ds_free(). Bytes waiting for reclamation are reported
+//     as Memory_Stats.pending_reclaim.
+//
+//     Every thread using a domain registers once and passes its record to
+//     all later calls. Records of unregistered threads are reused.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "types.h" // For ptr, usize, destroy_fn
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Epoch-based reclamation.
+// ---------------------------------------------------------------------------
+// Fields:
+//   epoch   -> Global epoch, advanced by epoch_collect().
+//   records -> All thread records ever registered (lock-free list).
+//
+// epoch_enter() / epoch_exit():
+//     Delimit a read-side critical section; nodes reachable from the
+//     container may only be dereferenced in between. Sections may nest.
+//
+// epoch_retire():
+//     Schedules 'pointer' (of 'size' bytes, for the statistics) to be
+//     released with 'destroy' (ds_free() if NULL) once it is safe. The
+//     node must already be unreachable for new readers. Every
+//     EPOCH_COLLECT_INTERVAL retirements trigger epoch_collect().
+//
+// epoch_collect():
+//     Tries to advance the global epoch and frees the safe batches of the
+//     calling thread.
+//
+// epoch_domain_destroy() frees everything still pending; no thread may
+// use the domain any more.
+//
+// Example usage:
+//     epoch_enter(record);
+//     Node *node = __atomic_load_n(&list->head, __ATOMIC_ACQUIRE);
+//     ... unlink node with a CAS ...
+//     epoch_exit(record);
+//     epoch_retire(record, node, sizeof(Node), NULL);
+
+#define EPOCH_COLLECT_INTERVAL 64
+
+typedef struct Epoch_Record Epoch_Record;
+
+typedef struct
+{
+        u64 epoch;
+        Epoch_Record *records;
+} Epoch_Domain;
+
+Result epoch_domain_create(Epoch_Domain *domain);
+void epoch_domain_destroy(Epoch_Domain *domain);
+Result epoch_register(Epoch_Domain *domain, Epoch_Record **record);
+void epoch_unregister(Epoch_Record *record);
+
+void epoch_enter(Epoch_Record *record);
+void epoch_exit(Epoch_Record *record);
+Result epoch_retire(Epoch_Record *record, ptr pointer, usize size,
+                    destroy_fn destroy);
+void epoch_collect(Epoch_Record *record);
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Hazard pointers.
+// ---------------------------------------------------------------------------
+// hazard_protect():
+//     Loads '*source', publishes it in 'slot' and returns it once it is
+//     known to still be current, i.e. safe to dereference until the slot
+//     is cleared or reused.
+//
+// hazard_retire():
+//     Same contract as epoch_retire(). A scan of all hazard slots runs
+//     once a thread has HAZARD_SCAN_THRESHOLD nodes pending (or twice the
+//     total number of slots, if larger), freeing every node not protected.
+//
+// Example usage:
+//     Node *head = hazard_protect(record, 0, (ptr *)&stack->head);
+//     ... use head ...
+//     hazard_clear(record, 0);
+
+#define HAZARD_SLOTS 4
+#define HAZARD_SCAN_THRESHOLD 64
+
+typedef struct Hazard_Record Hazard_Record;
+
+typedef struct
+{
+        Hazard_Record *records;
+        usize record_count;
+} Hazard_Domain;
+
+Result hazard_domain_create(Hazard_Domain *domain);
+void hazard_domain_destroy(Hazard_Domain *domain);
+Result hazard_register(Hazard_Domain *domain, Hazard_Record **record);
+void hazard_unregister(Hazard_Record *record);
+
+ptr hazard_protect(Hazard_Record *record, usize slot, ptr const *source);
+void hazard_clear(Hazard_Record *record, usize slot);
+Result hazard_retire(Hazard_Record *record, ptr pointer, usize size,
+                     destroy_fn destroy);
+void hazard_collect(Hazard_Record *record);
+
+#endif // !DATA_STRUCTURES_RECLAIM_H
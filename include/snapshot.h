@@ -0,0 +1,180 @@
+#ifndef DATA_STRUCTURES_SNAPSHOT_H
+#define DATA_STRUCTURES_SNAPSHOT_H
+
+// ============================================================================
+// File: snapshot.h
+// Description:
+//     Position-independent snapshot files for zero-copy loading.
+//
+//     A snapshot stores a container as a header, a table of sections and
+//     the raw contents of every array, each section aligned to 64 bytes.
+//     Sections are located by file offsets, never by pointers, so a file
+//     written once can be mmap()ed and used read-only right away: opening
+//     it validates the header and section table (O(1) in the data size)
+//     and the returned views point straight into the mapping. Pages are
+//     only read from disk when first touched.
+//
+//     Supported containers: GenericData, the typed arrays of types.h and
+//     CSR graphs (graph.h).
+//
+//     Files use the byte order of the machine that wrote them; opening a
+//     snapshot written with another byte order, another format version or
+//     that is truncated fails with DS_ERROR_CORRUPTED_DATA.
+//
+//     Every section is checksummed in blocks of SNAPSHOT_BLOCK_SIZE bytes
+//     (CRC32C where the writer has the SSE4.2 instruction, xxHash64
+//     otherwise; see checksum.h), and the header, section table and
+//     checksum table are covered by one more CRC32C. Opening verifies the
+//     blocks in parallel unless the file is trusted.
+// ============================================================================
+
+#include "checksum.h" // For Checksum_Kind
+#include "error.h"    // For Result
+#include "graph.h"    // For CSR_Graph
+#include "types.h"    // For GenericData, typed arrays
+
+// ---------------------------------------------------------------------------
+// SECTION 1: File layout.
+// ---------------------------------------------------------------------------
+// [Snapshot_Header][Snapshot_Section x section_count][pad][section 0]...
+// [pad][section n - 1][pad][u64 block checksums]
+//
+// Header fields:
+//   magic         -> SNAPSHOT_MAGIC, identifies snapshot files.
+//   version       -> SNAPSHOT_VERSION.
+//   byte_order    -> SNAPSHOT_BYTE_ORDER as written by the producer.
+//   kind          -> Snapshot_Kind of the stored container.
+//   section_count -> Entries in the section table.
+//   file_size     -> Total file size in bytes (detects truncation).
+//   block_size    -> Bytes per checksummed block.
+//   checksum_offset -> File offset of the block checksums: those of
+//                   section 0, then section 1, ... (the last block of a
+//                   section may be shorter).
+//   checksum_kind -> Checksum_Kind of the block checksums.
+//   header_checksum -> CRC32C of the header (with this field zero), the
+//                   section table and the block checksums.
+//   reserved      -> Zero; room for later extensions.
+//
+// Section fields:
+//   offset       -> File offset of the first element (multiple of
+//                   SNAPSHOT_ALIGNMENT).
+//   count        -> Number of elements.
+//   element_size -> Size of one element in bytes.
+//
+// Sections per kind:
+//   SNAPSHOT_GENERIC, SNAPSHOT_I32 .. SNAPSHOT_BYTE -> the elements.
+//   SNAPSHOT_CSR_GRAPH -> offsets (u64), neighbors (u32), weights (f64,
+//                         empty for unweighted graphs).
+
+#define SNAPSHOT_MAGIC 0x31504e5353445344ull
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_ALIGNMENT 64
+#define SNAPSHOT_MAX_SECTIONS 16
+#define SNAPSHOT_BLOCK_SIZE (1 << 20)
+
+typedef enum
+{
+    SNAPSHOT_GENERIC = 1,
+    SNAPSHOT_I32,
+    SNAPSHOT_U32,
+    SNAPSHOT_U64,
+    SNAPSHOT_F64,
+    SNAPSHOT_BYTE,
+    SNAPSHOT_CSR_GRAPH
+} Snapshot_Kind;
+
+typedef struct
+{
+        u64 magic;
+        u32 version;
+        u32 byte_order;
+        u32 kind;
+        u32 section_count;
+        u64 file_size;
+        u64 block_size;
+        u64 checksum_offset;
+        u32 checksum_kind;
+        u32 header_checksum;
+        u64 reserved;
+} Snapshot_Header;
+
+typedef struct
+{
+        u64 offset;
+        u64 count;
+        u64 element_size;
+} Snapshot_Section;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Writing.
+// ---------------------------------------------------------------------------
+// Each function (re)creates the file at 'path'. A failed write may leave a
+// partial file behind, which snapshot_open() then rejects.
+
+Result snapshot_save_generic(const char *path, const GenericData *data);
+Result snapshot_save_i32(const char *path, const i32Array *array);
+Result snapshot_save_u32(const char *path, const u32Array *array);
+Result snapshot_save_u64(const char *path, const u64Array *array);
+Result snapshot_save_f64(const char *path, const f64Array *array);
+Result snapshot_save_byte(const char *path, const byteArray *array);
+Result snapshot_save_csr_graph(const char *path, const CSR_Graph *graph);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Zero-copy loading.
+// ---------------------------------------------------------------------------
+// snapshot_open():
+//     Maps the file read-only and validates its header, section table and
+//     header checksum, then verifies every block checksum in parallel
+//     unless 'flags' has SNAPSHOT_TRUSTED (reading the whole file once).
+//     Fails with DS_ERROR_IO if the file cannot be opened or mapped and with
+//     DS_ERROR_CORRUPTED_DATA if the validation fails; a corrupted block is
+//     reported in snapshot->corrupt_offset (its file offset).
+//
+// snapshot_verify():
+//     Verifies the block checksums of an open snapshot, e.g. one opened as
+//     trusted, storing the offset of the first bad block in
+//     'corrupt_offset'.
+//
+// snapshot_view_*():
+//     Fill a container whose arrays point into the mapping (capacity equals
+//     size). Fail with DS_ERROR_CORRUPTED_DATA if the snapshot holds another
+//     kind of container or its sections do not match it. Views are
+//     read-only and stay valid until snapshot_close(); they must never be
+//     resized or released with ds_free() / csr_graph_destroy().
+//
+// Example usage:
+//     Snapshot snapshot;
+//     CSR_Graph graph;
+//     CHECK_RESULT(snapshot_open(&snapshot, "web.graph", SNAPSHOT_VERIFY));
+//     CHECK_RESULT(snapshot_view_csr_graph(&snapshot, &graph));
+//     ... traverse graph ...
+//     snapshot_close(&snapshot);
+
+typedef enum
+{
+    SNAPSHOT_VERIFY = 0,
+    SNAPSHOT_TRUSTED = 1 << 0 // Skip the block checksums
+} Snapshot_Open_Flags;
+
+typedef struct
+{
+        const byte *base;   // Start of the mapping
+        usize size;         // Mapped bytes (the file size)
+        u64 corrupt_offset; // First corrupted block found by snapshot_open()
+} Snapshot;
+
+Result snapshot_open(Snapshot *snapshot, const char *path, u32 flags);
+Result snapshot_verify(const Snapshot *snapshot, u64 *corrupt_offset);
+void snapshot_close(Snapshot *snapshot);
+
+Snapshot_Kind snapshot_kind(const Snapshot *snapshot);
+Result snapshot_view_generic(const Snapshot *snapshot, GenericData *view);
+Result snapshot_view_i32(const Snapshot *snapshot, i32Array *view);
+Result snapshot_view_u32(const Snapshot *snapshot, u32Array *view);
+Result snapshot_view_u64(const Snapshot *snapshot, u64Array *view);
+Result snapshot_view_f64(const Snapshot *snapshot, f64Array *view);
+Result snapshot_view_byte(const Snapshot *snapshot, byteArray *view);
+Result snapshot_view_csr_graph(const Snapshot *snapshot, CSR_Graph *view);
+
+#endif // !DATA_STRUCTURES_SNAPSHOT_H
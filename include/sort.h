@@ -0,0 +1,58 @@
+#ifndef DATA_STRUCTURES_SORT_H
+#define DATA_STRUCTURES_SORT_H
+
+// ============================================================================
+// File: sort.h
+// Description:
+//     Parallel sorting of GenericData containers and typed arrays, running
+//     on the shared work-stealing pool (see parallel.h).
+//
+//       - GenericData is sorted with a parallel merge sort: the halves are
+//         sorted as independent tasks, and the merges are themselves split
+//         in parallel by binary search, so every level of the recursion
+//         scales. Runs ping-pong between the array and one scratch buffer
+//         of the same size.
+//       - Typed arrays of integers and doubles use a parallel LSD radix
+//         sort on 8-bit digits: per-piece digit histograms, a prefix sum
+//         over (digit, piece) and a stable scatter. Passes in which every
+//         key has the same digit are skipped, so narrow key ranges cost
+//         fewer passes. No comparison is made at all.
+//
+//     With a single thread (see ds_parallel_set_thread_count()) the same
+//     algorithms run serially on the calling thread.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "types.h" // For GenericData, compare_fn, typed arrays
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Comparison-based sort.
+// ---------------------------------------------------------------------------
+// ds_parallel_sort():
+//     Sorts the 'size' elements of 'data' in ascending order according to
+//     'compare' (same contract as qsort()). The sort is not stable.
+//     Allocates a scratch buffer of size * element_size bytes; fails with
+//     DS_ERROR_MEMORY_ALLOCATION (leaving the data untouched) if it cannot.
+//
+// Example usage:
+//     GenericData records = ...;
+//     CHECK_RESULT(ds_parallel_sort(&records, compare_record));
+
+Result ds_parallel_sort(GenericData *data, compare_fn compare);
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Radix sorts for typed arrays.
+// ---------------------------------------------------------------------------
+// Sort 'array->size' elements in ascending numeric order, using one scratch
+// buffer of the same size.
+//
+// ds_parallel_sort_f64() orders values by their IEEE-754 total order:
+// -0.0 sorts before +0.0, and NaNs sort before all other values if their
+// sign bit is set and after them otherwise.
+
+Result ds_parallel_sort_i32(i32Array *array);
+Result ds_parallel_sort_u32(u32Array *array);
+Result ds_parallel_sort_u64(u64Array *array);
+Result ds_parallel_sort_f64(f64Array *array);
+
+#endif // !DATA_STRUCTURES_SORT_H
@@ -0,0 +1,63 @@
+#ifndef DATA_STRUCTURES_SSSP_H
+#define DATA_STRUCTURES_SSSP_H
+
+// ============================================================================
+// File: sssp.h
+// Description:
+//     Single-source shortest paths over weighted CSR graphs.
+//
+//     csr_sssp() runs a parallel delta-stepping search (Meyer and Sanders)
+//     in its "near/far" form: vertices closer than the current threshold
+//     form the near frontier and are relaxed in parallel, round after round,
+//     until it empties; the threshold then advances by 'delta' and the next
+//     vertices are pulled out of the far pile. Distances are lowered with a
+//     lock-free compare-and-swap minimum.
+//
+//     Small graphs, or a single configured thread, fall back to a serial
+//     Dijkstra on a d-ary heap, which has less overhead there.
+//
+//     Edge weights must be non-negative. Unweighted graphs use weight 1.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "graph.h" // For CSR_Graph
+#include "types.h" // For f64Array, i32Array
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Constants.
+// ---------------------------------------------------------------------------
+// SSSP_NO_PREDECESSOR -> Predecessor of unreachable vertices (and of none
+//                        else: the source is its own predecessor).
+// SSSP_SERIAL_EDGES   -> Graphs with fewer edges use serial Dijkstra.
+//
+// Unreachable vertices have distance INFINITY.
+
+#define SSSP_NO_PREDECESSOR (-1)
+#define SSSP_SERIAL_EDGES 65536
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Shortest path searches.
+// ---------------------------------------------------------------------------
+// csr_sssp():
+//     Picks delta-stepping or Dijkstra as described above. 'delta' is the
+//     bucket width; pass 0 to use the mean edge weight. Larger values expose
+//     more parallelism at the cost of redundant relaxations.
+//
+// csr_dijkstra():
+//     Always runs the serial Dijkstra.
+//
+// Both resize 'distances' (and 'predecessors', which may be NULL) to
+// vertex_count entries. Vertex ids must fit in i32 when predecessors are
+// requested. A negative edge weight yields DS_ERROR_INVALID_ARGUMENT.
+//
+// Example usage:
+//     f64Array distances = {0};
+//     i32Array predecessors = {0};
+//     CHECK_RESULT(csr_sssp(&graph, source, 0.0, &distances, &predecessors));
+
+Result csr_sssp(const CSR_Graph *graph, u32 source, f64 delta,
+                f64Array *distances, i32Array *predecessors);
+Result csr_dijkstra(const CSR_Graph *graph, u32 source, f64Array *distances,
+                    i32Array *predecessors);
+
+#endif // !DATA_STRUCTURES_SSSP_H
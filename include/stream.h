@@ -0,0 +1,162 @@
+#ifndef DATA_STRUCTURES_STREAM_H
+#define DATA_STRUCTURES_STREAM_H
+
+// ============================================================================
+// File: stream.h
+// Description:
+//     Buffered binary streams over file descriptors.
+//
+//     Writers collect small writes in a large page-aligned buffer. A write
+//     that does not fit is sent together with the buffered bytes in one
+//     writev() call instead of being copied. Readers refill their buffer
+//     with large read() calls and read big requests straight into the
+//     caller's memory.
+//
+//     With STREAM_DIRECT the file is opened with O_DIRECT, bypassing the
+//     page cache (useful for datasets read or written once that would
+//     otherwise evict hot pages). All transfers then go through the
+//     aligned buffer in whole blocks; the writer pads the last block and
+//     truncates the file back to its real size on close. Filesystems that
+//     refuse O_DIRECT silently get regular buffered I/O.
+//
+//     Containers are stored as records, each a small header followed by
+//     the raw elements. Readers may pull any number of elements at a time,
+//     across record boundaries, so a dataset larger than memory can flow
+//     through a fixed-size container chunk by chunk.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "types.h" // For GenericData, typed arrays
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Stream state.
+// ---------------------------------------------------------------------------
+// Writer fields:
+//   fd       -> Underlying file descriptor.
+//   buffer   -> STREAM_BUFFER_SIZE bytes aligned to STREAM_ALIGNMENT.
+//   length   -> Bytes buffered and not yet written.
+//   position -> Bytes accepted since the stream was opened.
+//
+// Reader fields:
+//   begin, end       -> Unread bytes of the buffer.
+//   record_remaining -> Elements left in the current container record.
+//   record_width     -> Element size of the current container record.
+//
+// Stream_Record_Header precedes the elements of every container record
+// (see SECTION 4): STREAM_RECORD_MAGIC, the element size and the number
+// of elements.
+
+#define STREAM_BUFFER_SIZE (1 << 20)
+#define STREAM_ALIGNMENT 4096
+#define STREAM_RECORD_MAGIC 0x31525344u // "DSR1"
+
+typedef struct
+{
+        u32 magic;
+        u32 element_size;
+        u64 count;
+} Stream_Record_Header;
+
+typedef enum
+{
+    STREAM_DEFAULT = 0,
+    STREAM_DIRECT = 1 << 0 // Open with O_DIRECT (where supported)
+} Stream_Flags;
+
+typedef struct
+{
+        int fd;
+        bool owns_fd;
+        bool direct;
+        byte *buffer;
+        usize length;
+        u64 position;
+} Stream_Writer;
+
+typedef struct
+{
+        int fd;
+        bool owns_fd;
+        bool direct;
+        byte *buffer;
+        usize begin;
+        usize end;
+        u64 position;
+        u64 record_remaining;
+        usize record_width;
+} Stream_Reader;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Opening and closing.
+// ---------------------------------------------------------------------------
+// stream_writer_open() (re)creates the file at 'path'; stream_reader_open()
+// opens an existing one. The *_from_fd() variants use an already open
+// descriptor (pipe, socket, ...) without taking ownership; they ignore
+// STREAM_DIRECT.
+//
+// stream_writer_close() flushes the buffer and reports the first error
+// that occurred. Both close functions release the buffer and, if the
+// stream opened it, the descriptor.
+
+Result stream_writer_open(Stream_Writer *writer, const char *path, u32 flags);
+Result stream_writer_from_fd(Stream_Writer *writer, int fd);
+Result stream_writer_flush(Stream_Writer *writer);
+Result stream_writer_close(Stream_Writer *writer);
+
+Result stream_reader_open(Stream_Reader *reader, const char *path, u32 flags);
+Result stream_reader_from_fd(Stream_Reader *reader, int fd);
+void stream_reader_close(Stream_Reader *reader);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Raw bytes.
+// ---------------------------------------------------------------------------
+// stream_write() buffers or writes 'size' bytes.
+//
+// stream_read() reads exactly 'size' bytes, failing with
+// DS_ERROR_CORRUPTED_DATA if the stream ends first. stream_read_some()
+// reads up to 'capacity' bytes and stores the count in 'read' (0 only at
+// the end of the stream).
+
+Result stream_write(Stream_Writer *writer, cptr data, usize size);
+Result stream_read(Stream_Reader *reader, ptr data, usize size);
+Result stream_read_some(Stream_Reader *reader, ptr data, usize capacity,
+                        usize *read);
+
+// ---------------------------------------------------------------------------
+// SECTION 4: Containers.
+// ---------------------------------------------------------------------------
+// stream_write_*():
+//     Appends all elements of the container as one record.
+//
+// stream_read_*():
+//     Replaces the contents of the container with the next elements of the
+//     stream, at most 'max_count' of them (0 means up to the end of the
+//     stream), continuing over record boundaries. A container of size 0 on
+//     success means the stream has ended. Reading stops early before a
+//     record of another element size; fails with DS_ERROR_CORRUPTED_DATA
+//     if a record header is damaged or the next record holds elements of
+//     another size. GenericData must have its element_size set.
+//
+// Example usage (constant memory whatever the file size):
+//     f64Array chunk = {0};
+//     do
+//     {
+//         CHECK_RESULT(stream_read_f64_array(&reader, &chunk, 1 << 20));
+//         process(&chunk);
+//     } while(chunk.size > 0);
+
+Result stream_write_generic(Stream_Writer *writer, const GenericData *data);
+Result stream_write_byte_array(Stream_Writer *writer, const byteArray *array);
+Result stream_write_i32_array(Stream_Writer *writer, const i32Array *array);
+Result stream_write_f64_array(Stream_Writer *writer, const f64Array *array);
+
+Result stream_read_generic(Stream_Reader *reader, GenericData *data,
+                           usize max_count);
+Result stream_read_byte_array(Stream_Reader *reader, byteArray *array,
+                              usize max_count);
+Result stream_read_i32_array(Stream_Reader *reader, i32Array *array,
+                             usize max_count);
+Result stream_read_f64_array(Stream_Reader *reader, f64Array *array,
+                             usize max_count);
+
+#endif // !DATA_STRUCTURES_STREAM_H
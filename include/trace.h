@@ -0,0 +1,96 @@
+#ifndef DATA_STRUCTURES_TRACE_H
+#define DATA_STRUCTURES_TRACE_H
+
+// ============================================================================
+// File: trace.h
+// Description:
+//     Per-thread ring buffers of trace spans around the library's expensive
+//     internal events, so that a stalled request can be matched with the
+//     array growth, sort, bulk load, batch or snapshot write it waited on.
+//
+//     A span is a name, begin and end timestamps and one count argument
+//     (elements, bytes, files, ...). Spans are recorded when they end,
+//     into a fixed-size ring owned by the recording thread; the oldest are
+//     overwritten. As with error_ring.h, recording is wait-free and does
+//     no I/O, readers detect overwritten slots with a per-slot sequence
+//     number, and only the first span of a thread claims a ring, which may
+//     allocate. While tracing is disabled (the default) a span costs one
+//     relaxed load.
+//
+//     Timestamps are CLOCK_MONOTONIC nanoseconds: unlike the time stamp
+//     counter they need no calibration to be shown in microseconds and
+//     agree between threads, and the vDSO call is negligible next to the
+//     events traced.
+//
+//     Traced events:
+//       "array_grow"     -> ds_array_reserve() growing storage to 64 KiB
+//                           or more (bytes).
+//       "sort"           -> ds_parallel_sort() and the radix sorts
+//                           behind the typed ones (elements).
+//       "bulk_load"      -> loader_run() (files).
+//       "graph_batch"    -> dynamic_graph_apply() building and publishing
+//                           a version (updates).
+//       "snapshot_write" -> Writing a snapshot file (bytes).
+//       "wal_checkpoint" -> wal_checkpoint(), save included (last
+//                           sequence number covered).
+//
+//     Link with -pthread.
+// ============================================================================
+
+#include <stdio.h> // For FILE
+
+#include "types.h" // For u64, usize
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Span record.
+// ---------------------------------------------------------------------------
+// Fields:
+//   begin -> Monotonic nanoseconds when the event started.
+//   end   -> Monotonic nanoseconds when it finished.
+//   name  -> Static name of the event.
+//   count -> Size of the event, in the unit of its name.
+
+#define TRACE_RING_CAPACITY 1024 // Spans kept per thread (power of two)
+
+typedef struct
+{
+        u64 begin;
+        u64 end;
+        const char *name;
+        u64 count;
+} Trace_Span;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Recording.
+// ---------------------------------------------------------------------------
+// Example, around an expensive event:
+//     u64 span = trace_begin();
+//     ... rebuild the table ...
+//     trace_end("table_rebuild", span, entry_count);
+//
+// trace_begin() returns 0 while tracing is disabled, and trace_end()
+// ignores spans begun at 0, so a span enabled halfway is dropped rather
+// than stretched back to the epoch. 'name' must outlive the rings.
+
+void trace_enable(bool enabled);
+bool trace_enabled(void);
+u64 trace_begin(void);
+void trace_end(const char *name, u64 begin, u64 count);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Inspection.
+// ---------------------------------------------------------------------------
+// trace_snapshot():
+//     Copies up to 'capacity' of the calling thread's most recent spans to
+//     'spans', oldest first, and returns how many were copied.
+//
+// trace_dump_json():
+//     Writes the spans of every ring to 'stream' in Chrome trace-event
+//     format (one "X" event per span, one thread per ring), to be opened
+//     in chrome://tracing or Perfetto. May run while other threads keep
+//     recording; spans overwritten during the dump are skipped.
+
+usize trace_snapshot(Trace_Span *spans, usize capacity);
+void trace_dump_json(FILE *stream);
+
+#endif // !DATA_STRUCTURES_TRACE_H
@@ -73,11 +73,20 @@ typedef const void *cptr; // Generic pointer to read-only data
 // destroy_fn: used to release memory or resources held by an element.
 // print_fn:   used for debugging and logging of elements.
 // hash_fn:    used to generate a hash value for hash-based structures.
+//
+// The bulk operations of parallel_ops.h use three more callbacks:
+// map_fn:       writes the image of 'input' to 'output'.
+// predicate_fn: tells whether an element is kept (must be pure).
+// combine_fn:   folds 'value' into 'accumulator' (accumulator = accumulator
+//               op value), 'op' being associative.
 
 typedef int (*compare_fn)(cptr a, cptr b);
 typedef void (*destroy_fn)(ptr data);
 typedef void (*print_fn)(cptr data);
 typedef u64 (*hash_fn)(cptr data, usize size);
+typedef void (*map_fn)(cptr input, ptr output);
+typedef bool (*predicate_fn)(cptr element);
+typedef void (*combine_fn)(ptr accumulator, cptr value);
 
 // ---------------------------------------------------------------------------
 // SECTION 6: Generic data container structure.
@@ -130,6 +139,8 @@ typedef struct
 // These are predeclared typed arrays commonly used in many applications.
 
 DECLARE_TYPE(i32);  // Array of 32-bit integers
+DECLARE_TYPE(u32);  // Array of unsigned 32-bit integers (ids, codecs)
+DECLARE_TYPE(u64);  // Array of unsigned 64-bit integers (offsets)
 DECLARE_TYPE(f64);  // Array of 64-bit floating-point numbers
 DECLARE_TYPE(byte); // Array of bytes (useful for buffers or raw data)
 
@@ -0,0 +1,92 @@
+#ifndef DATA_STRUCTURES_UNION_FIND_H
+#define DATA_STRUCTURES_UNION_FIND_H
+
+// ============================================================================
+// File: union_find.h
+// Description:
+//     Disjoint-set forests (union-find) and parallel connected components.
+//
+//     Two variants are provided:
+//
+//       - Union_Find: the classic serial structure with union by size and
+//         path halving, O(alpha(n)) amortized per operation.
+//       - Atomic_Union_Find: a lock-free variant safe to use from many
+//         threads at once. Roots are linked with a compare-and-swap, always
+//         hooking the larger id under the smaller one (linking by index),
+//         and finds compress paths with benign CAS-based halving.
+//
+//     The connected-components routines run the lock-free variant over an
+//     edge list or a CSR graph in parallel. Every component is labeled with
+//     its smallest vertex id.
+// ============================================================================
+
+#include "container_stats.h" // For Container_Stats
+#include "error.h"           // For Result
+#include "graph.h"           // For CSR_Graph, Edge_List
+#include "types.h"           // For u32Array
+
+// ---------------------------------------------------------------------------
+// SECTION 1: Serial union-find.
+// ---------------------------------------------------------------------------
+// Fields:
+//   parent    -> parent[x] is the parent of x; roots point to themselves.
+//   size      -> size[r] is the number of elements in the set rooted at r
+//                (only meaningful for roots).
+//   set_count -> Current number of disjoint sets.
+//   stats     -> Opt-in instrumentation, set after union_find_create()
+//                (NULL: none; see container_stats.h).
+//
+// union_find_unite() reports through 'merged' (may be NULL) whether the two
+// elements were in different sets.
+
+typedef struct
+{
+        u32Array parent;
+        u32Array size;
+        u32 set_count;
+        Container_Stats *stats;
+} Union_Find;
+
+Result union_find_create(Union_Find *uf, u32 element_count);
+void union_find_destroy(Union_Find *uf);
+u32 union_find_find(Union_Find *uf, u32 element);
+Result union_find_unite(Union_Find *uf, u32 a, u32 b, bool *merged);
+bool union_find_connected(Union_Find *uf, u32 a, u32 b);
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Lock-free union-find.
+// ---------------------------------------------------------------------------
+// All operations may be called concurrently. The element count is fixed at
+// creation. Since roots are always the smallest id of their set,
+// atomic_union_find_find() returns a canonical label once all unions have
+// completed.
+
+typedef struct
+{
+        u32Array parent;
+} Atomic_Union_Find;
+
+Result atomic_union_find_create(Atomic_Union_Find *uf, u32 element_count);
+void atomic_union_find_destroy(Atomic_Union_Find *uf);
+u32 atomic_union_find_find(Atomic_Union_Find *uf, u32 element);
+bool atomic_union_find_unite(Atomic_Union_Find *uf, u32 a, u32 b);
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Parallel connected components.
+// ---------------------------------------------------------------------------
+// Both routines resize 'labels' to vertex_count entries, labels[v] being the
+// smallest vertex id of v's component, and store the number of components
+// in 'component_count' (may be NULL). Edge directions are ignored (weakly
+// connected components).
+//
+// connected_components_csr() uses the Afforest sampling strategy when
+// 'symmetric' is true (every edge stored in both directions): it first
+// links only two neighbors per vertex, samples the largest component and
+// then skips the remaining edges of the vertices already inside it.
+
+Result connected_components_edges(u32 vertex_count, const Edge_List *edges,
+                                  u32Array *labels, u32 *component_count);
+Result connected_components_csr(const CSR_Graph *graph, bool symmetric,
+                                u32Array *labels, u32 *component_count);
+
+#endif // !DATA_STRUCTURES_UNION_FIND_H
@@ -0,0 +1,199 @@
+#ifndef DATA_STRUCTURES_WAL_H
+#define DATA_STRUCTURES_WAL_H
+
+// ============================================================================
+// File: wal.h
+// Description:
+//     Append-only write-ahead log for making container updates durable.
+//
+//     Every mutation is appended to the log as a small typed record before
+//     (or while) it is applied in memory; after a crash the container is
+//     rebuilt from its last snapshot (snapshot.h) by replaying the records
+//     written since. Records carry a sequence number and a CRC32C, and
+//     replay stops cleanly at a torn last record, which is what a crash in
+//     the middle of an append leaves behind; a damaged record followed by
+//     more data is reported as corruption instead.
+//
+//     Group commit: wal_append() only buffers a record. wal_commit() makes
+//     it durable, and of all the threads committing at the same time one
+//     writes every buffered record and calls fdatasync() once for all of
+//     them while the others wait. Many small commits thus cost a few large
+//     synchronous writes instead of one fdatasync() each.
+//
+//     The log does not interpret records: any container can be made
+//     persistent by defining record types for its mutations.
+//     Link with -pthread.
+// ============================================================================
+
+#include "error.h" // For Result
+#include "types.h" // For byteArray
+#include <pthread.h>
+
+// ---------------------------------------------------------------------------
+// SECTION 1: File layout.
+// ---------------------------------------------------------------------------
+// [Wal_File_Header][Wal_Record_Header][payload][Wal_Record_Header]...
+//
+// File header fields:
+//   magic         -> WAL_MAGIC, identifies log files.
+//   base_sequence -> Sequence number of the first record of the file.
+//   version       -> WAL_VERSION.
+//   checksum      -> CRC32C of the previous fields.
+//
+// Record header fields:
+//   checksum -> CRC32C of the rest of the header and of the payload.
+//   type     -> Caller-defined record type.
+//   sequence -> base_sequence for the first record, then one more each.
+//   size     -> Payload bytes following the header.
+
+#define WAL_MAGIC 0x31474F4C53444C57ull // "WLDSLOG1" read little-endian
+#define WAL_VERSION 1
+
+typedef struct
+{
+        u64 magic;
+        u64 base_sequence;
+        u32 version;
+        u32 checksum;
+} Wal_File_Header;
+
+typedef struct
+{
+        u32 checksum;
+        u32 type;
+        u64 sequence;
+        u64 size;
+} Wal_Record_Header;
+
+// ---------------------------------------------------------------------------
+// SECTION 2: Log state and options.
+// ---------------------------------------------------------------------------
+// Wal_Options:
+//   commit_delay_us -> How long the thread that writes a group waits for
+//                      more commits to join it (0 writes at once). Worth a
+//                      few tens of microseconds under heavy concurrency.
+//   flags           -> WAL_NO_SYNC writes groups without fdatasync()
+//                      (records survive a process crash, not a power
+//                      loss).
+//
+// Log fields (guarded by 'lock'):
+//   pending          -> Encoded records not yet handed to the kernel.
+//   writing          -> Buffer of the group being written.
+//   next_sequence    -> Sequence number of the next appended record.
+//   durable_sequence -> Every record below it is on disk.
+//   flushing         -> A thread is writing a group.
+//   failed           -> A write or sync failed; the log refuses further
+//                       use since the state of its tail is unknown.
+//   syncs            -> Groups written so far (one fdatasync() each).
+
+typedef enum
+{
+    WAL_DEFAULT = 0,
+    WAL_NO_SYNC = 1 << 0
+} Wal_Flags;
+
+typedef struct
+{
+        u32 commit_delay_us;
+        u32 flags;
+} Wal_Options;
+
+#define WAL_DEFAULT_OPTIONS ((Wal_Options){0, WAL_DEFAULT})
+
+typedef struct
+{
+        int fd;
+        char *path;
+        Wal_Options options;
+        pthread_mutex_t lock;
+        pthread_cond_t flushed;
+        byteArray pending;
+        byteArray writing;
+        u64 next_sequence;
+        u64 durable_sequence;
+        bool flushing;
+        bool failed;
+        u64 syncs;
+} Wal;
+
+// ---------------------------------------------------------------------------
+// SECTION 3: Recovery.
+// ---------------------------------------------------------------------------
+// wal_replay_fn: applies one logged mutation to the container being
+// rebuilt. An error stops the recovery.
+//
+// wal_open():
+//     Opens (or creates) the log at 'path' and replays, in order, every
+//     record with a sequence number above 'after_sequence' - the sequence
+//     the snapshot the container was loaded from is up to date with (0
+//     without a snapshot). A torn tail - a last record that runs past the
+//     end of the file or is followed only by zeros - is cut off; later
+//     appends continue after the last intact record. Fails with
+//     DS_ERROR_CORRUPTED_DATA if the file is not a log, if a record that
+//     does not check out is followed by other data, or if the log does not
+//     cover 'after_sequence' + 1 (records between the snapshot and the log
+//     are missing, or the snapshot is newer than the log).
+
+typedef Result (*wal_replay_fn)(ptr context, u32 type, const byte *payload,
+                                usize size);
+
+Result wal_open(Wal *wal, const char *path, u64 after_sequence,
+                wal_replay_fn replay, ptr context, Wal_Options options);
+Result wal_close(Wal *wal);
+
+// ---------------------------------------------------------------------------
+// SECTION 4: Logging.
+// ---------------------------------------------------------------------------
+// wal_append():
+//     Buffers a record and stores its sequence number in 'sequence' (if
+//     not NULL). The record is not durable yet.
+//
+// wal_commit():
+//     Returns once the record 'sequence' and all before it are durable,
+//     writing them together with any other buffered records if no other
+//     thread is already doing so.
+//
+// wal_write():
+//     wal_append() followed by wal_commit().
+//
+// Example usage (several threads):
+//     CHECK_RESULT(wal_write(&wal, MAP_PUT, record, record_size));
+//     apply_put(&map, key, value);
+//
+// All functions are thread-safe. Fails with DS_ERROR_IO (and every later
+// call too) once writing the log has failed.
+
+Result wal_append(Wal *wal, u32 type, cptr payload, usize size, u64 *sequence);
+Result wal_commit(Wal *wal, u64 sequence);
+Result wal_write(Wal *wal, u32 type, cptr payload, usize size);
+
+// ---------------------------------------------------------------------------
+// SECTION 5: Checkpoints.
+// ---------------------------------------------------------------------------
+// wal_checkpoint():
+//     Makes every appended record durable, calls 'save' with the sequence
+//     of the last one, then starts an empty log whose first record will
+//     follow it. 'save' must durably store the container together with
+//     that sequence (to be passed to wal_open() on recovery), atomically:
+//     if the process dies before the log is reset, the old log is
+//     replayed on top of the new snapshot and only its records above the
+//     sequence are applied.
+//
+//     Appends block during the checkpoint, and 'save' must not use the
+//     log. The caller keeps the container unchanged meanwhile (e.g. by
+//     holding its writer lock), so that the saved state matches the
+//     sequence exactly.
+//
+// Example usage:
+//     static Result save(ptr graph, u64 sequence)
+//     {
+//         // Write "graph.<sequence>.snap" to a temporary file, fsync()
+//         // and rename() it; recovery opens the newest one.
+//     }
+//     CHECK_RESULT(wal_checkpoint(&wal, save, &graph));
+
+typedef Result (*wal_checkpoint_fn)(ptr context, u64 sequence);
+
+Result wal_checkpoint(Wal *wal, wal_checkpoint_fn save, ptr context);
+
+#endif // !DATA_STRUCTURES_WAL_H
@@ -0,0 +1,460 @@
+#include "../include/bfs.h"
+#include "../include/bitset.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+
+/**
+ * @brief Minimum frontier vertices per parallel piece (top-down).
+ */
+#define TOP_DOWN_GRAIN 256
+
+/**
+ * @brief Minimum bit set words (64 vertices each) per parallel piece.
+ */
+#define BOTTOM_UP_GRAIN 64
+
+/**
+ * @brief Vertices buffered per piece before being published to the queue.
+ */
+#define LOCAL_QUEUE_SIZE 256
+
+/**
+ * @brief Shared state of one traversal.
+ *
+ * The frontier is kept either as a queue (`frontier`, top-down) or as a bit
+ * set (`front`, bottom-up). `queued`, `scout` and `awake` are accumulated
+ * atomically by the parallel pieces of one step.
+ */
+typedef struct
+{
+        const CSR_Graph *graph;
+        const CSR_Graph *incoming;
+        u32 *parent;
+        u32 *depth; // May be NULL
+        u32 level;  // Depth of the frontier being expanded
+
+        u32 *frontier;
+        usize frontier_size;
+        u32 *next;
+        usize queued;
+
+        Bitset front;
+        Bitset next_front;
+
+        u64 scout; // Out-edges of the vertices discovered by a step
+        u64 awake; // Vertices discovered by a bottom-up step
+} BFS_State;
+
+/**
+ * @brief Per-piece output buffer flushed into the shared next queue.
+ */
+typedef struct
+{
+        u32 vertices[LOCAL_QUEUE_SIZE];
+        usize count;
+} Local_Queue;
+
+/* ============================================================================
+ *  HELPERS
+ * ============================================================================
+ */
+
+/**
+ * @brief Publishes the buffered vertices with a single atomic reservation.
+ */
+static void flush_local(BFS_State *state, Local_Queue *local)
+{
+    if(local->count == 0)
+        return;
+
+    usize position =
+        __atomic_fetch_add(&state->queued, local->count, __ATOMIC_RELAXED);
+    ds_memcpy(state->next + position, local->vertices,
+              local->count * sizeof(u32));
+    local->count = 0;
+}
+
+static inline void push_local(BFS_State *state, Local_Queue *local, u32 vertex)
+{
+    local->vertices[local->count++] = vertex;
+    if(local->count == LOCAL_QUEUE_SIZE)
+        flush_local(state, local);
+}
+
+/**
+ * @brief Records the discovery of `vertex` from `parent`.
+ */
+static inline void discover(BFS_State *state, u32 vertex, u32 parent)
+{
+    state->parent[vertex] = parent;
+    if(state->depth)
+        state->depth[vertex] = state->level + 1;
+}
+
+/* ============================================================================
+ *  TOP-DOWN AND BOTTOM-UP STEPS
+ * ============================================================================
+ */
+
+/**
+ * @brief Top-down step over frontier[begin, end).
+ *
+ * A plain (relaxed) read filters out visited vertices cheaply; only the
+ * remaining candidates pay for a compare-and-swap on their parent slot.
+ */
+static void top_down_piece(usize begin, usize end, ptr context)
+{
+    BFS_State *state = (BFS_State *)context;
+    const CSR_Graph *graph = state->graph;
+    Local_Queue local;
+    u64 scout = 0;
+
+    local.count = 0;
+    for(usize i = begin; i < end; i++)
+    {
+        u32 u = state->frontier[i];
+        for(u64 e = graph->offsets.data[u]; e < graph->offsets.data[u + 1];
+            e++)
+        {
+            u32 v = graph->neighbors.data[e];
+            u32 expected = BFS_UNREACHED;
+            if(__atomic_load_n(&state->parent[v], __ATOMIC_RELAXED) !=
+                   BFS_UNREACHED ||
+               !__atomic_compare_exchange_n(&state->parent[v], &expected, u,
+                                            false, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+                continue;
+
+            if(state->depth)
+                state->depth[v] = state->level + 1;
+            scout += csr_graph_degree(graph, v);
+            push_local(state, &local, v);
+        }
+    }
+
+    flush_local(state, &local);
+    __atomic_fetch_add(&state->scout, scout, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Bottom-up step over bit set words [begin, end).
+ *
+ * Each piece owns whole 64-vertex words, so parent/depth slots and the
+ * next-frontier words are written without any atomic operation.
+ */
+static void bottom_up_piece(usize begin, usize end, ptr context)
+{
+    BFS_State *state = (BFS_State *)context;
+    const CSR_Graph *incoming = state->incoming;
+    u32 vertex_count = incoming->vertex_count;
+    u64 awake = 0;
+    u64 scout = 0;
+
+    for(usize word = begin; word < end; word++)
+    {
+        u64 bits = 0;
+        usize first = word * BITSET_WORD_BITS;
+        usize last = first + BITSET_WORD_BITS;
+        if(last > vertex_count)
+            last = vertex_count;
+
+        for(usize v = first; v < last; v++)
+        {
+            if(state->parent[v] != BFS_UNREACHED)
+                continue;
+
+            for(u64 e = incoming->offsets.data[v];
+                e < incoming->offsets.data[v + 1]; e++)
+            {
+                u32 u = incoming->neighbors.data[e];
+                if(bitset_test(&state->front, u))
+                {
+                    discover(state, (u32)v, u);
+                    bits |= (u64)1 << (v - first);
+                    awake++;
+                    scout += csr_graph_degree(state->graph, (u32)v);
+                    break;
+                }
+            }
+        }
+        state->next_front.words[word] = bits;
+    }
+
+    __atomic_fetch_add(&state->awake, awake, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&state->scout, scout, __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ *  FRONTIER CONVERSIONS
+ * ============================================================================
+ */
+
+static void queue_to_bitset_piece(usize begin, usize end, ptr context)
+{
+    BFS_State *state = (BFS_State *)context;
+    for(usize i = begin; i < end; i++)
+        bitset_set_atomic(&state->front, state->frontier[i]);
+}
+
+static void bitset_to_queue_piece(usize begin, usize end, ptr context)
+{
+    BFS_State *state = (BFS_State *)context;
+    Local_Queue local;
+
+    local.count = 0;
+    for(usize word = begin; word < end; word++)
+    {
+        u64 bits = state->front.words[word];
+        while(bits)
+        {
+            u32 bit = (u32)__builtin_ctzll(bits);
+            push_local(state, &local, (u32)(word * BITSET_WORD_BITS + bit));
+            bits &= bits - 1;
+        }
+    }
+    flush_local(state, &local);
+}
+
+/**
+ * @brief Makes the queue filled by the last step the current frontier.
+ */
+static void swap_queues(BFS_State *state)
+{
+    u32 *swap = state->frontier;
+    state->frontier = state->next;
+    state->next = swap;
+    state->frontier_size = state->queued;
+    state->queued = 0;
+}
+
+/* ============================================================================
+ *  TRAVERSAL DRIVER
+ * ============================================================================
+ */
+
+/**
+ * @brief Checks whether the early-exit target (if any) has been reached.
+ */
+static inline bool target_found(const BFS_State *state, u32 target)
+{
+    return target != BFS_UNREACHED && state->parent[target] != BFS_UNREACHED;
+}
+
+/**
+ * @brief Runs the direction-optimizing traversal on an initialized state.
+ *
+ * @param target Stop once this vertex is discovered (BFS_UNREACHED: never).
+ */
+static Result run_bfs(BFS_State *state, u32 source, u32 target,
+                      BFS_Options options)
+{
+    const CSR_Graph *graph = state->graph;
+    u32 vertex_count = graph->vertex_count;
+    u64 edges_to_check = graph->edge_count;
+    u64 scout = csr_graph_degree(graph, source);
+
+    state->parent[source] = source;
+    if(state->depth)
+        state->depth[source] = 0;
+    state->frontier[0] = source;
+    state->frontier_size = 1;
+
+    while(state->frontier_size > 0 && !target_found(state, target))
+    {
+        if(scout > edges_to_check / options.alpha)
+        {
+            // Bottom-up phase: keep going while the frontier grows or stays
+            // large relative to the graph.
+            bitset_clear_all(&state->front);
+            CHECK_RESULT(ds_parallel_for(0, state->frontier_size,
+                                         TOP_DOWN_GRAIN, queue_to_bitset_piece,
+                                         state));
+
+            u64 awake = state->frontier_size;
+            u64 previous;
+            do
+            {
+                previous = awake;
+                state->awake = 0;
+                state->scout = 0;
+                CHECK_RESULT(ds_parallel_for(0, state->front.word_count,
+                                             BOTTOM_UP_GRAIN, bottom_up_piece,
+                                             state));
+                awake = state->awake;
+                edges_to_check -= state->scout < edges_to_check
+                                      ? state->scout
+                                      : edges_to_check;
+                state->level++;
+
+                Bitset swap = state->front;
+                state->front = state->next_front;
+                state->next_front = swap;
+            } while(!target_found(state, target) &&
+                    (awake >= previous || awake > vertex_count / options.beta));
+
+            state->queued = 0;
+            CHECK_RESULT(ds_parallel_for(0, state->front.word_count,
+                                         BOTTOM_UP_GRAIN, bitset_to_queue_piece,
+                                         state));
+            swap_queues(state);
+            scout = 1;
+        }
+        else
+        {
+            edges_to_check -= scout < edges_to_check ? scout : edges_to_check;
+            state->scout = 0;
+            CHECK_RESULT(ds_parallel_for(0, state->frontier_size,
+                                         TOP_DOWN_GRAIN, top_down_piece,
+                                         state));
+            scout = state->scout;
+            swap_queues(state);
+            state->level++;
+        }
+    }
+
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Allocates the traversal state and runs the search.
+ *
+ * `parent` and `depth` are caller-owned arrays of vertex_count entries
+ * (`depth` may be NULL); they are initialized to BFS_UNREACHED here.
+ */
+static Result bfs_search(const CSR_Graph *graph, const CSR_Graph *incoming,
+                         u32 source, u32 target, BFS_Options options,
+                         u32 *parent, u32 *depth)
+{
+    u32 vertex_count = graph->vertex_count;
+    BFS_State state = {0};
+    state.graph = graph;
+    state.incoming = incoming ? incoming : graph;
+    state.parent = parent;
+    state.depth = depth;
+
+    for(usize v = 0; v < vertex_count; v++)
+        parent[v] = BFS_UNREACHED;
+    if(depth)
+        for(usize v = 0; v < vertex_count; v++)
+            depth[v] = BFS_UNREACHED;
+
+    state.frontier = ALLOC_ARRAY(u32, vertex_count);
+    state.next = ALLOC_ARRAY(u32, vertex_count);
+    Result result = RESULT_SUCCESS;
+    if(!state.frontier || !state.next)
+        result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                              "Failed to allocate BFS queues");
+    if(result_is_success(result))
+        result = bitset_create(&state.front, vertex_count);
+    if(result_is_success(result))
+        result = bitset_create(&state.next_front, vertex_count);
+    if(result_is_success(result))
+        result = run_bfs(&state, source, target, options);
+
+    bitset_destroy(&state.front);
+    bitset_destroy(&state.next_front);
+    ds_free(state.frontier);
+    ds_free(state.next);
+    return result;
+}
+
+/**
+ * @brief Validates the arguments shared by the public entry points.
+ */
+static Result check_graphs(const CSR_Graph *graph, const CSR_Graph *incoming,
+                           u32 source)
+{
+    DS_ASSERT(graph != NULL, "Graph must not be NULL");
+    DS_ASSERT(incoming == NULL ||
+                  (incoming->vertex_count == graph->vertex_count &&
+                   incoming->edge_count == graph->edge_count),
+              "Incoming graph must be the transpose of the graph");
+    if(source >= graph->vertex_count)
+        return RESULT_ERROR(DS_ERROR_INDEX_OUT_OF_BOUNDS,
+                            "Source vertex out of range");
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  PUBLIC API
+ * ============================================================================
+ */
+
+/**
+ * @brief Direction-optimizing parallel BFS from `source`.
+ *
+ * @param graph    Graph to traverse.
+ * @param incoming Transpose of `graph`, or NULL if `graph` is symmetric.
+ * @param source   Start vertex.
+ * @param options  Direction switch thresholds (BFS_DEFAULT_OPTIONS).
+ * @param parents  Optional output: BFS tree parent of every vertex.
+ * @param depths   Optional output: hop distance of every vertex.
+ * @return RESULT_SUCCESS or an error code.
+ */
+Result csr_bfs(const CSR_Graph *graph, const CSR_Graph *incoming, u32 source,
+               BFS_Options options, u32Array *parents, u32Array *depths)
+{
+    CHECK_RESULT(check_graphs(graph, incoming, source));
+    DS_ASSERT(options.alpha > 0 && options.beta > 0,
+              "BFS options must be positive");
+
+    u32 vertex_count = graph->vertex_count;
+    u32 *parent;
+    if(parents)
+    {
+        CHECK_RESULT(ARRAY_RESERVE(parents, vertex_count));
+        parents->size = vertex_count;
+        parent = parents->data;
+    }
+    else
+    {
+        parent = ALLOC_ARRAY(u32, vertex_count);
+        if(!parent)
+            return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                "Failed to allocate BFS parents");
+    }
+
+    u32 *depth = NULL;
+    Result result = RESULT_SUCCESS;
+    if(depths)
+    {
+        result = ARRAY_RESERVE(depths, vertex_count);
+        if(result_is_success(result))
+        {
+            depths->size = vertex_count;
+            depth = depths->data;
+        }
+    }
+
+    if(result_is_success(result))
+        result = bfs_search(graph, incoming, source, BFS_UNREACHED, options,
+                            parent, depth);
+
+    if(!parents)
+        ds_free(parent);
+    return result;
+}
+
+/**
+ * @brief Reports whether `target` is reachable from `source`.
+ */
+Result csr_bfs_reachable(const CSR_Graph *graph, const CSR_Graph *incoming,
+                         u32 source, u32 target, bool *reachable)
+{
+    CHECK_RESULT(check_graphs(graph, incoming, source));
+    DS_ASSERT(reachable != NULL, "Output must not be NULL");
+    if(target >= graph->vertex_count)
+        return RESULT_ERROR(DS_ERROR_INDEX_OUT_OF_BOUNDS,
+                            "Target vertex out of range");
+
+    u32 *parent = ALLOC_ARRAY(u32, graph->vertex_count);
+    if(!parent)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate BFS parents");
+
+    Result result = bfs_search(graph, incoming, source, target,
+                               BFS_DEFAULT_OPTIONS, parent, NULL);
+    *reachable = parent[target] != BFS_UNREACHED;
+    ds_free(parent);
+    return result;
+}
@@ -0,0 +1,55 @@
+#include "../include/bitset.h"
+#include "../include/memory.h"
+
+/**
+ * @brief Allocates a bit set of `bit_count` bits, all cleared.
+ *
+ * @param set       Bit set to initialize.
+ * @param bit_count Number of bits.
+ * @return RESULT_SUCCESS or DS_ERROR_MEMORY_ALLOCATION.
+ */
+Result bitset_create(Bitset *set, usize bit_count)
+{
+    DS_ASSERT(set != NULL, "Bit set must not be NULL");
+
+    usize word_count = (bit_count + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+    set->words = ALLOC_ARRAY(u64, word_count ? word_count : 1);
+    if(!set->words)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate bit set");
+
+    set->bit_count = bit_count;
+    set->word_count = word_count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Releases the storage of a bit set.
+ */
+void bitset_destroy(Bitset *set)
+{
+    if(!set)
+        return;
+
+    ds_free(set->words);
+    *set = (Bitset){0};
+}
+
+/**
+ * @brief Clears every bit.
+ */
+void bitset_clear_all(Bitset *set)
+{
+    ds_memset(set->words, 0, set->word_count * sizeof(u64));
+}
+
+/**
+ * @brief Counts the set bits.
+ */
+usize bitset_count(const Bitset *set)
+{
+    usize count = 0;
+    for(usize i = 0; i < set->word_count; i++)
+        count += (usize)__builtin_popcountll(set->words[i]);
+    return count;
+}
@@ -0,0 +1,353 @@
+#include "../include/checksum.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+#include <pthread.h>
+#include <string.h>
+
+/**
+ * @brief Reflected CRC32C (Castagnoli) polynomial.
+ */
+#define CRC32C_POLYNOMIAL 0x82F63B78u
+
+/**
+ * @brief xxHash64 primes.
+ */
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32C_HAVE_SSE42 1
+#else
+#define CRC32C_HAVE_SSE42 0
+#endif
+
+/* ============================================================================
+ *  CRC32C
+ * ============================================================================
+ */
+
+/**
+ * @brief Slicing-by-8 tables: crc_tables[k][b] is the CRC of byte b
+ *        followed by k zero bytes.
+ */
+static u32 crc_tables[8][256];
+static pthread_once_t crc_tables_once = PTHREAD_ONCE_INIT;
+
+static void build_crc_tables(void)
+{
+    for(u32 i = 0; i < 256; i++)
+    {
+        u32 crc = i;
+        for(int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+        crc_tables[0][i] = crc;
+    }
+    for(u32 i = 0; i < 256; i++)
+        for(int k = 1; k < 8; k++)
+            crc_tables[k][i] = (crc_tables[k - 1][i] >> 8) ^
+                               crc_tables[0][crc_tables[k - 1][i] & 0xFF];
+}
+
+/**
+ * @brief Portable CRC32C over the inverted register `crc`.
+ */
+static u32 crc32c_software(u32 crc, const u8 *data, usize size)
+{
+    pthread_once(&crc_tables_once, build_crc_tables);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for(; size >= 8; data += 8, size -= 8)
+    {
+        u32 low, high;
+        memcpy(&low, data, 4);
+        memcpy(&high, data + 4, 4);
+        low ^= crc;
+        crc = crc_tables[7][low & 0xFF] ^ crc_tables[6][(low >> 8) & 0xFF] ^
+              crc_tables[5][(low >> 16) & 0xFF] ^ crc_tables[4][low >> 24] ^
+              crc_tables[3][high & 0xFF] ^ crc_tables[2][(high >> 8) & 0xFF] ^
+              crc_tables[1][(high >> 16) & 0xFF] ^ crc_tables[0][high >> 24];
+    }
+#endif
+    for(; size > 0; data++, size--)
+        crc = crc_tables[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if CRC32C_HAVE_SSE42
+/**
+ * @brief CRC32C with the SSE4.2 crc32 instruction, 8 bytes at a time.
+ */
+__attribute__((target("sse4.2"))) static u32
+crc32c_sse42(u32 crc, const u8 *data, usize size)
+{
+    for(; size > 0 && ((uintptr_t)data & 7) != 0; data++, size--)
+        crc = __builtin_ia32_crc32qi(crc, *data);
+
+    u64 wide = crc;
+    for(; size >= 8; data += 8, size -= 8)
+    {
+        u64 word;
+        memcpy(&word, data, 8);
+        wide = __builtin_ia32_crc32di(wide, word);
+    }
+    crc = (u32)wide;
+
+    for(; size > 0; data++, size--)
+        crc = __builtin_ia32_crc32qi(crc, *data);
+    return crc;
+}
+#endif
+
+/**
+ * @brief Whether CRC32C runs on the SSE4.2 instruction.
+ */
+bool ds_crc32c_hardware(void)
+{
+#if CRC32C_HAVE_SSE42
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Extends a CRC32C with `size` bytes.
+ */
+u32 ds_crc32c(u32 crc, cptr data, usize size)
+{
+    const u8 *bytes = (const u8 *)data;
+    crc = ~crc;
+#if CRC32C_HAVE_SSE42
+    if(__builtin_cpu_supports("sse4.2"))
+        return ~crc32c_sse42(crc, bytes, size);
+#endif
+    return ~crc32c_software(crc, bytes, size);
+}
+
+/**
+ * @brief CRC32C of a byteArray.
+ */
+u32 ds_crc32c_bytes(const byteArray *array)
+{
+    return array ? ds_crc32c(0, array->data, array->size) : 0;
+}
+
+/* ============================================================================
+ *  XXHASH64
+ * ============================================================================
+ */
+
+static inline u64 rotate_left(u64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline u64 read_u64(const u8 *data)
+{
+    u64 value;
+    memcpy(&value, data, 8);
+    return value;
+}
+
+static inline u32 read_u32(const u8 *data)
+{
+    u32 value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+static inline u64 xxh64_round(u64 accumulator, u64 input)
+{
+    accumulator += input * XXH_PRIME64_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * XXH_PRIME64_1;
+}
+
+static inline u64 xxh64_merge(u64 hash, u64 accumulator)
+{
+    hash ^= xxh64_round(0, accumulator);
+    return hash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+/**
+ * @brief xxHash64 of `size` bytes.
+ */
+u64 ds_xxhash64(cptr data, usize size, u64 seed)
+{
+    const u8 *bytes = (const u8 *)data;
+    const u8 *end = bytes + size;
+    u64 hash;
+
+    if(size >= 32)
+    {
+        u64 v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        u64 v2 = seed + XXH_PRIME64_2;
+        u64 v3 = seed;
+        u64 v4 = seed - XXH_PRIME64_1;
+        for(; end - bytes >= 32; bytes += 32)
+        {
+            v1 = xxh64_round(v1, read_u64(bytes));
+            v2 = xxh64_round(v2, read_u64(bytes + 8));
+            v3 = xxh64_round(v3, read_u64(bytes + 16));
+            v4 = xxh64_round(v4, read_u64(bytes + 24));
+        }
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) +
+               rotate_left(v3, 12) + rotate_left(v4, 18);
+        hash = xxh64_merge(hash, v1);
+        hash = xxh64_merge(hash, v2);
+        hash = xxh64_merge(hash, v3);
+        hash = xxh64_merge(hash, v4);
+    }
+    else
+        hash = seed + XXH_PRIME64_5;
+
+    hash += (u64)size;
+    for(; end - bytes >= 8; bytes += 8)
+    {
+        hash ^= xxh64_round(0, read_u64(bytes));
+        hash = rotate_left(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if(end - bytes >= 4)
+    {
+        hash ^= (u64)read_u32(bytes) * XXH_PRIME64_1;
+        hash = rotate_left(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        bytes += 4;
+    }
+    for(; bytes < end; bytes++)
+    {
+        hash ^= (u64)*bytes * XXH_PRIME64_5;
+        hash = rotate_left(hash, 11) * XXH_PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/**
+ * @brief xxHash64 of a byteArray.
+ */
+u64 ds_xxhash64_bytes(const byteArray *array, u64 seed)
+{
+    return array ? ds_xxhash64(array->data, array->size, seed)
+                 : ds_xxhash64(NULL, 0, seed);
+}
+
+/* ============================================================================
+ *  BLOCK CHECKSUMS
+ * ============================================================================
+ */
+
+/**
+ * @brief Shared state of a parallel block checksum or verification.
+ */
+typedef struct
+{
+        const byte *data;
+        usize size;
+        usize block_size;
+        Checksum_Kind kind;
+        u64 *checksums;       // Output (checksum)
+        const u64 *expected;  // Input (verify)
+        usize bad_block;      // First mismatching block (verify)
+} Block_Checksums;
+
+static u64 block_checksum(const Block_Checksums *state, usize block)
+{
+    usize first = block * state->block_size;
+    usize length = state->size - first < state->block_size
+                       ? state->size - first
+                       : state->block_size;
+    if(state->kind == CHECKSUM_XXH64)
+        return ds_xxhash64(state->data + first, length, 0);
+    return ds_crc32c(0, state->data + first, length);
+}
+
+static void checksum_range(usize begin, usize end, ptr context)
+{
+    Block_Checksums *state = (Block_Checksums *)context;
+    for(usize block = begin; block < end; block++)
+        state->checksums[block] = block_checksum(state, block);
+}
+
+static void verify_range(usize begin, usize end, ptr context)
+{
+    Block_Checksums *state = (Block_Checksums *)context;
+    for(usize block = begin; block < end; block++)
+    {
+        if(block_checksum(state, block) == state->expected[block])
+            continue;
+
+        usize seen = __atomic_load_n(&state->bad_block, __ATOMIC_RELAXED);
+        while(block < seen &&
+              !__atomic_compare_exchange_n(&state->bad_block, &seen, block,
+                                           true, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+            ;
+        return;
+    }
+}
+
+/**
+ * @brief Number of blocks covering `size` bytes.
+ */
+static usize block_count(usize size, usize block_size)
+{
+    return size / block_size + (size % block_size != 0);
+}
+
+/**
+ * @brief Checksums every block of `array`, in parallel.
+ */
+Result ds_checksum_blocks(const byteArray *array, usize block_size,
+                          Checksum_Kind kind, u64Array *checksums)
+{
+    DS_ASSERT(array != NULL && checksums != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(block_size != 0, "Block size must not be zero");
+    DS_ASSERT(kind == CHECKSUM_CRC32C || kind == CHECKSUM_XXH64,
+              "Unknown checksum kind");
+
+    usize count = block_count(array->size, block_size);
+    CHECK_RESULT(ARRAY_RESERVE(checksums, count));
+    checksums->size = count;
+
+    Block_Checksums state = {array->data, array->size, block_size, kind,
+                             checksums->data, NULL, SIZE_MAX};
+    return ds_parallel_for(0, count, 1, checksum_range, &state);
+}
+
+/**
+ * @brief Verifies every block of `array` against `checksums`, in parallel.
+ */
+Result ds_verify_blocks(const byteArray *array, usize block_size,
+                        Checksum_Kind kind, const u64Array *checksums,
+                        usize *bad_block)
+{
+    DS_ASSERT(array != NULL && checksums != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(block_size != 0, "Block size must not be zero");
+    DS_ASSERT(kind == CHECKSUM_CRC32C || kind == CHECKSUM_XXH64,
+              "Unknown checksum kind");
+
+    usize count = block_count(array->size, block_size);
+    if(checksums->size != count)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Block checksum count does not match the data");
+
+    Block_Checksums state = {array->data, array->size, block_size, kind,
+                             NULL, checksums->data, SIZE_MAX};
+    CHECK_RESULT(ds_parallel_for(0, count, 1, verify_range, &state));
+    if(state.bad_block == SIZE_MAX)
+        return RESULT_SUCCESS;
+
+    if(bad_block)
+        *bad_block = state.bad_block;
+    return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA, "Block checksum mismatch");
+}
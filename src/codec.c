@@ -0,0 +1,920 @@
+#include "../include/codec.h"
+#include "../include/memory.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/* ============================================================================
+ *  STREAM HEADER
+ * ============================================================================
+ */
+
+/**
+ * @brief On-disk header written in front of every encoded stream.
+ *
+ * Layout (20 bytes, native byte order):
+ *   [0]      kind           (Codec_Kind)
+ *   [1]      flags          (Codec_Flags)
+ *   [2..3]   reserved, zero
+ *   [4..11]  value count
+ *   [12..19] payload size in bytes (everything after the header)
+ */
+#define CODEC_HEADER_SIZE 20
+#define CODEC_KNOWN_FLAGS (CODEC_FLAG_DELTA | CODEC_FLAG_ZIGZAG)
+
+typedef struct
+{
+        u8 kind;
+        u8 flags;
+        u64 count;
+        u64 payload;
+} Codec_Header;
+
+static void write_header(byte *dst, const Codec_Header *header)
+{
+    dst[0] = (byte)header->kind;
+    dst[1] = (byte)header->flags;
+    dst[2] = 0;
+    dst[3] = 0;
+    ds_memcpy(dst + 4, &header->count, sizeof(u64));
+    ds_memcpy(dst + 12, &header->payload, sizeof(u64));
+}
+
+/**
+ * @brief Parses and validates the header of the stream starting at `cursor`.
+ *
+ * Checks that the codec and flags are known and that the whole payload lies
+ * inside the buffer, so decoders never read past `in->size`.
+ */
+static Result read_header(const byteArray *in, usize cursor,
+                          Codec_Header *header)
+{
+    DS_ASSERT(in != NULL, "Input buffer must not be NULL");
+    if(cursor > in->size || in->size - cursor < CODEC_HEADER_SIZE)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Truncated codec stream header");
+
+    const byte *src = in->data + cursor;
+    header->kind = (u8)src[0];
+    header->flags = (u8)src[1];
+    ds_memcpy(&header->count, src + 4, sizeof(u64));
+    ds_memcpy(&header->payload, src + 12, sizeof(u64));
+
+    if((header->kind != CODEC_BITPACK && header->kind != CODEC_STREAMVBYTE) ||
+       (header->flags & ~CODEC_KNOWN_FLAGS) != 0 || src[2] != 0 ||
+       src[3] != 0)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Unknown codec stream header");
+
+    if(header->payload > in->size - cursor - CODEC_HEADER_SIZE)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Truncated codec stream payload");
+
+    // The count is checked against the smallest payload able to hold it
+    // (a width byte per bitpack block; a control byte per four values
+    // plus one data byte per value for StreamVByte), so that a corrupted
+    // count cannot make the caller reserve more than the input implies.
+    u64 count = header->count;
+    u64 payload = header->payload;
+    bool fits;
+    if(header->kind == CODEC_BITPACK)
+    {
+        u64 blocks =
+            count / CODEC_BLOCK_SIZE + (count % CODEC_BLOCK_SIZE != 0);
+        fits = blocks <= payload;
+    }
+    else
+        fits = count <= payload && (count + 3) / 4 <= payload - count;
+    if(!fits)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Codec stream count exceeds its payload");
+
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  VALUE TRANSFORMS
+ * ============================================================================
+ */
+
+/** @brief Maps signed integers to unsigned ones: 0,-1,1,-2 -> 0,1,2,3. */
+static inline u32 zigzag_encode(u32 value)
+{
+    return (value << 1) ^ (u32)((i32)value >> 31);
+}
+
+/** @brief Inverse of zigzag_encode(). */
+static inline u32 zigzag_decode(u32 value)
+{
+    return (value >> 1) ^ (0u - (value & 1u));
+}
+
+/** @brief Number of bits needed to represent `value` (0 for 0). */
+static inline u32 bit_width(u32 value)
+{
+    return value == 0 ? 0 : 32 - (u32)__builtin_clz(value);
+}
+
+/* ============================================================================
+ *  BINARY PACKING (CODEC_BITPACK)
+ * ============================================================================
+ *
+ * A block of 128 values is split into four lanes: value i belongs to lane
+ * i % 4. Each lane packs its 32 values LSB-first into `width` 32-bit words,
+ * and the words of the four lanes are interleaved (word w of lane l is
+ * stored at index w * 4 + l). One 128-bit load therefore yields the same
+ * word of all four lanes, which is what the SSE2 decoder consumes.
+ *
+ * Delta coding uses a stride of four (x[i] - x[i - 4]) so that decoding is
+ * a vertical vector addition instead of a serial prefix sum.
+ */
+
+#define LANES 4
+#define LANE_VALUES (CODEC_BLOCK_SIZE / LANES)
+
+/**
+ * @brief Packs one 128-value block into `4 * width` words.
+ */
+static void bitpack_block(const u32 *in, u32 width, u32 *out)
+{
+    if(width == 0)
+        return;
+
+    for(usize lane = 0; lane < LANES; lane++)
+    {
+        u64 accumulator = 0;
+        u32 filled = 0;
+        usize word = 0;
+
+        for(usize j = 0; j < LANE_VALUES; j++)
+        {
+            accumulator |= (u64)in[j * LANES + lane] << filled;
+            filled += width;
+            if(filled >= 32)
+            {
+                out[word * LANES + lane] = (u32)accumulator;
+                word++;
+                accumulator >>= 32;
+                filled -= 32;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Unpacks one block and undoes the zigzag / stride-4 delta transform.
+ *
+ * @param in      Packed words (may be unaligned).
+ * @param width   Bit width of the block (0..32).
+ * @param flags   Codec flags of the stream.
+ * @param carry   Last four decoded values of the previous block (in/out).
+ * @param out     Destination for 128 values.
+ */
+static void bitunpack_block(const byte *in, u32 width, u32 flags, u32 *carry,
+                            u32 *out)
+{
+#if defined(__SSE2__)
+    const __m128i mask =
+        _mm_set1_epi32(width >= 32 ? -1 : (int)((1u << width) - 1));
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i previous = _mm_loadu_si128((const __m128i *)carry);
+    __m128i current = width ? _mm_loadu_si128((const __m128i *)in) : zero;
+    u32 shift = 0;
+
+    for(usize j = 0; j < LANE_VALUES; j++)
+    {
+        __m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128((int)shift));
+        shift += width;
+        if(shift > 32)
+        {
+            in += sizeof(__m128i);
+            current = _mm_loadu_si128((const __m128i *)in);
+            shift -= 32;
+            value = _mm_or_si128(
+                value, _mm_sll_epi32(current,
+                                     _mm_cvtsi32_si128((int)(width - shift))));
+        }
+        else if(shift == 32 && j + 1 < LANE_VALUES)
+        {
+            in += sizeof(__m128i);
+            current = _mm_loadu_si128((const __m128i *)in);
+            shift = 0;
+        }
+        value = _mm_and_si128(value, mask);
+
+        if(flags & CODEC_FLAG_ZIGZAG)
+            value = _mm_xor_si128(_mm_srli_epi32(value, 1),
+                                  _mm_sub_epi32(zero, _mm_and_si128(value, one)));
+        if(flags & CODEC_FLAG_DELTA)
+        {
+            value = _mm_add_epi32(value, previous);
+            previous = value;
+        }
+        _mm_storeu_si128((__m128i *)(out + j * LANES), value);
+    }
+    _mm_storeu_si128((__m128i *)carry, previous);
+#else
+    const u32 mask = width >= 32 ? 0xFFFFFFFFu : (1u << width) - 1;
+
+    for(usize lane = 0; lane < LANES; lane++)
+    {
+        u64 accumulator = 0;
+        u32 available = 0;
+        usize word = 0;
+
+        for(usize j = 0; j < LANE_VALUES; j++)
+        {
+            if(available < width)
+            {
+                u32 next;
+                ds_memcpy(&next, in + (word * LANES + lane) * sizeof(u32),
+                          sizeof(u32));
+                accumulator |= (u64)next << available;
+                available += 32;
+                word++;
+            }
+            u32 value = (u32)accumulator & mask;
+            accumulator >>= width;
+            available -= width;
+
+            if(flags & CODEC_FLAG_ZIGZAG)
+                value = zigzag_decode(value);
+            if(flags & CODEC_FLAG_DELTA)
+            {
+                value += carry[lane];
+                carry[lane] = value;
+            }
+            out[j * LANES + lane] = value;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Encodes `count` values as a sequence of packed 128-value blocks.
+ *
+ * The last, partial block is padded with zero codes; the decoder discards
+ * the padding.
+ */
+static void bitpack_encode(const u32 *values, usize count, u32 flags,
+                           byte *out, usize *written)
+{
+    u32 block[CODEC_BLOCK_SIZE];
+    u32 packed[LANES * 32];
+    u32 previous[LANES] = {0, 0, 0, 0};
+    usize position = 0;
+
+    for(usize start = 0; start < count; start += CODEC_BLOCK_SIZE)
+    {
+        usize n = count - start < CODEC_BLOCK_SIZE ? count - start
+                                                   : CODEC_BLOCK_SIZE;
+        u32 all_bits = 0;
+
+        for(usize i = 0; i < CODEC_BLOCK_SIZE; i++)
+        {
+            u32 value = 0;
+            if(i < n)
+            {
+                value = values[start + i];
+                if(flags & CODEC_FLAG_DELTA)
+                {
+                    u32 current = value;
+                    value -= previous[i % LANES];
+                    previous[i % LANES] = current;
+                }
+                if(flags & CODEC_FLAG_ZIGZAG)
+                    value = zigzag_encode(value);
+            }
+            block[i] = value;
+            all_bits |= value;
+        }
+
+        u32 width = bit_width(all_bits);
+        out[position++] = (byte)width;
+        bitpack_block(block, width, packed);
+        ds_memcpy(out + position, packed, width * LANES * sizeof(u32));
+        position += width * LANES * sizeof(u32);
+    }
+
+    *written = position;
+}
+
+/**
+ * @brief Decodes a CODEC_BITPACK payload of `payload` bytes.
+ */
+static Result bitpack_decode(const byte *in, usize payload, usize count,
+                             u32 flags, u32 *values)
+{
+    u32 carry[LANES] = {0, 0, 0, 0};
+    u32 tail[CODEC_BLOCK_SIZE];
+    usize position = 0;
+
+    for(usize start = 0; start < count; start += CODEC_BLOCK_SIZE)
+    {
+        if(position >= payload)
+            return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                "Truncated bitpack block");
+
+        u32 width = (u8)in[position++];
+        usize block_bytes = (usize)width * LANES * sizeof(u32);
+        if(width > 32 || payload - position < block_bytes)
+            return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                "Invalid bitpack block");
+
+        if(count - start >= CODEC_BLOCK_SIZE)
+            bitunpack_block(in + position, width, flags, carry,
+                            values + start);
+        else
+        {
+            bitunpack_block(in + position, width, flags, carry, tail);
+            ds_memcpy(values + start, tail, (count - start) * sizeof(u32));
+        }
+        position += block_bytes;
+    }
+
+    if(position != payload)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Bitpack payload size mismatch");
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  STREAMVBYTE (CODEC_STREAMVBYTE)
+ * ============================================================================
+ *
+ * Every value is stored in 1-4 bytes. The byte lengths are kept apart from
+ * the data in a control stream of 2 bits per value (four values per control
+ * byte), so the decoder can fetch four lengths at once and expand 16 data
+ * bytes with a single shuffle. Delta coding is the classic x[i] - x[i - 1].
+ */
+
+#if defined(__SSSE3__)
+/**
+ * @brief Shuffle masks for _mm_shuffle_epi8, indexed by control byte.
+ *
+ * Entry c moves the variable-length values described by c into four
+ * 32-bit slots; -1 entries zero the unused high bytes.
+ */
+static const i8 svb_shuffle[256][16] = {
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3, -1, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, -1, -1, -1, 4, -1, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, -1, -1, -1, 5, -1, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, -1, -1, -1, 6, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, -1, -1, -1, 4, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, -1, -1, -1, 5, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, -1, -1, -1, 6, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, -1, -1, -1, 7, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, -1, -1, -1, 5, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, -1, -1, -1, 6, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, -1, -1, -1, 7, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, -1, -1, -1, 8, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, -1, -1, -1, 6, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, -1, -1, -1, 7, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, -1, -1, -1, 8, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, -1, -1, -1, 9, -1, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, -1, -1, 4, -1, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, -1, -1, 5, -1, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, -1, -1, 6, -1, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, -1, -1, 7, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, -1, -1, 5, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1, 6, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, -1, -1, 7, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, -1, -1, 8, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, -1, -1, 6, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, -1, -1, 7, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, -1, -1, 8, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, -1, -1, 9, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, -1, -1, 7, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, -1, -1, 8, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, -1, -1, 9, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, 10, -1, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, -1, 5, -1, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, -1, 6, -1, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, -1, 7, -1, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, -1, 8, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, -1, 6, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, -1, 7, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, -1, 8, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, -1, 9, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, -1, 7, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, -1, 8, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, -1, 10, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, -1, 8, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, -1, 9, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, -1, 10, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1, 11, -1, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, 5, 6, -1, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, 6, 7, -1, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, 7, 8, -1, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, 8, 9, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, 6, 7, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, 7, 8, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, 8, 9, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, 7, 8, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, 8, 9, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, 9, 10, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, 10, 11, -1, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, 10, 11, -1, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, -1, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3, 4, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, -1, -1, -1, 4, 5, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, -1, -1, -1, 5, 6, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, -1, -1, -1, 6, 7, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, -1, -1, -1, 4, 5, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, -1, -1, -1, 5, 6, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, -1, -1, -1, 6, 7, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, -1, -1, -1, 7, 8, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, -1, -1, -1, 5, 6, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, -1, -1, -1, 6, 7, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, -1, -1, -1, 7, 8, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, -1, -1, -1, 8, 9, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, -1, -1, -1, 6, 7, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, -1, -1, -1, 7, 8, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, -1, -1, -1, 8, 9, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, -1, -1, -1, 9, 10, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, -1, -1, 5, 6, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, -1, -1, 6, 7, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, -1, -1, 7, 8, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, -1, -1, 5, 6, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1, 6, 7, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, -1, -1, 7, 8, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, -1, -1, 8, 9, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, -1, -1, 6, 7, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, -1, -1, 7, 8, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, -1, -1, 8, 9, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, -1, -1, 9, 10, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, -1, -1, 7, 8, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, -1, -1, 8, 9, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, -1, -1, 9, 10, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, 10, 11, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, -1, 5, 6, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, -1, 6, 7, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, -1, 7, 8, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, -1, 8, 9, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, -1, 6, 7, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, -1, 7, 8, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, -1, 8, 9, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, -1, 9, 10, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, -1, 7, 8, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, -1, 8, 9, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, -1, 8, 9, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, -1, 9, 10, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, -1, 10, 11, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1, 11, 12, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, 5, 6, 7, -1, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, 6, 7, 8, -1, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, 7, 8, 9, -1, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, 8, 9, 10, -1, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, 6, 7, 8, -1, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, 7, 8, 9, -1, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, 8, 9, 10, -1, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, 7, 8, 9, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, 8, 9, 10, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, 9, 10, 11, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, 10, 11, 12, -1, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, -1, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, -1, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, -1, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3, 4, 5, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, -1, -1, -1, 4, 5, 6, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, -1, -1, -1, 5, 6, 7, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, -1, -1, -1, 6, 7, 8, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, -1, -1, -1, 4, 5, 6, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, -1, -1, -1, 5, 6, 7, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, -1, -1, -1, 6, 7, 8, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, -1, -1, -1, 7, 8, 9, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, -1, -1, -1, 5, 6, 7, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, -1, -1, -1, 6, 7, 8, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, -1, -1, -1, 7, 8, 9, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, -1, -1, -1, 8, 9, 10, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, -1, -1, -1, 6, 7, 8, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, -1, -1, -1, 7, 8, 9, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, -1, -1, -1, 8, 9, 10, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, -1, -1, -1, 9, 10, 11, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, -1, -1, 4, 5, 6, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, -1, -1, 5, 6, 7, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, -1, -1, 6, 7, 8, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, -1, -1, 7, 8, 9, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, -1, -1, 5, 6, 7, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1, 6, 7, 8, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, -1, -1, 7, 8, 9, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, -1, -1, 8, 9, 10, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, -1, -1, 6, 7, 8, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, -1, -1, 7, 8, 9, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, -1, -1, 8, 9, 10, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, -1, -1, 9, 10, 11, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, -1, -1, 7, 8, 9, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, -1, -1, 8, 9, 10, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, -1, -1, 9, 10, 11, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, 10, 11, 12, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, -1, 5, 6, 7, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, -1, 6, 7, 8, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, -1, 7, 8, 9, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, -1, 8, 9, 10, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, -1, 6, 7, 8, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, -1, 7, 8, 9, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, -1, 8, 9, 10, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, -1, 9, 10, 11, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, -1, 7, 8, 9, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, -1, 8, 9, 10, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, -1, 8, 9, 10, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, -1, 9, 10, 11, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, -1, 10, 11, 12, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1, 11, 12, 13, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, 5, 6, 7, 8, -1},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, 6, 7, 8, 9, -1},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, 7, 8, 9, 10, -1},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, 8, 9, 10, 11, -1},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, 6, 7, 8, 9, -1},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, 7, 8, 9, 10, -1},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, 8, 9, 10, 11, -1},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, 12, -1},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, 7, 8, 9, 10, -1},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, 8, 9, 10, 11, -1},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, 9, 10, 11, 12, -1},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, 10, 11, 12, 13, -1},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, -1},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, -1},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, -1},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, -1},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3, 4, 5, 6},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, -1, -1, -1, 4, 5, 6, 7},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, -1, -1, -1, 5, 6, 7, 8},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, -1, -1, -1, 6, 7, 8, 9},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, -1, -1, -1, 4, 5, 6, 7},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, -1, -1, -1, 5, 6, 7, 8},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, -1, -1, -1, 6, 7, 8, 9},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, -1, -1, -1, 7, 8, 9, 10},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, -1, -1, -1, 5, 6, 7, 8},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, -1, -1, -1, 6, 7, 8, 9},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, -1, -1, -1, 7, 8, 9, 10},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, -1, -1, -1, 8, 9, 10, 11},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, -1, -1, -1, 6, 7, 8, 9},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, -1, -1, -1, 7, 8, 9, 10},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, -1, -1, -1, 8, 9, 10, 11},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, -1, -1, -1, 9, 10, 11, 12},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, -1, -1, 4, 5, 6, 7},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, -1, -1, 5, 6, 7, 8},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, -1, -1, 6, 7, 8, 9},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, -1, -1, 7, 8, 9, 10},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, -1, -1, 5, 6, 7, 8},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1, 6, 7, 8, 9},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, -1, -1, 7, 8, 9, 10},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, -1, -1, 8, 9, 10, 11},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, -1, -1, 6, 7, 8, 9},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, -1, -1, 7, 8, 9, 10},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, -1, -1, 8, 9, 10, 11},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, -1, -1, 9, 10, 11, 12},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, -1, -1, 7, 8, 9, 10},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, -1, -1, 8, 9, 10, 11},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, -1, -1, 9, 10, 11, 12},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, 10, 11, 12, 13},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, -1, 5, 6, 7, 8},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, -1, 6, 7, 8, 9},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, -1, 7, 8, 9, 10},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, -1, 8, 9, 10, 11},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, -1, 6, 7, 8, 9},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, -1, 7, 8, 9, 10},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, -1, 8, 9, 10, 11},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, -1, 9, 10, 11, 12},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, -1, 7, 8, 9, 10},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, -1, 8, 9, 10, 11},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, 12},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, 13},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, -1, 8, 9, 10, 11},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, -1, 9, 10, 11, 12},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, -1, 10, 11, 12, 13},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, -1, 11, 12, 13, 14},
+    {0, -1, -1, -1, 1, -1, -1, -1, 2, 3, 4, 5, 6, 7, 8, 9},
+    {0, 1, -1, -1, 2, -1, -1, -1, 3, 4, 5, 6, 7, 8, 9, 10},
+    {0, 1, 2, -1, 3, -1, -1, -1, 4, 5, 6, 7, 8, 9, 10, 11},
+    {0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, 8, 9, 10, 11, 12},
+    {0, -1, -1, -1, 1, 2, -1, -1, 3, 4, 5, 6, 7, 8, 9, 10},
+    {0, 1, -1, -1, 2, 3, -1, -1, 4, 5, 6, 7, 8, 9, 10, 11},
+    {0, 1, 2, -1, 3, 4, -1, -1, 5, 6, 7, 8, 9, 10, 11, 12},
+    {0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, 12, 13},
+    {0, -1, -1, -1, 1, 2, 3, -1, 4, 5, 6, 7, 8, 9, 10, 11},
+    {0, 1, -1, -1, 2, 3, 4, -1, 5, 6, 7, 8, 9, 10, 11, 12},
+    {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, 9, 10, 11, 12, 13},
+    {0, 1, 2, 3, 4, 5, 6, -1, 7, 8, 9, 10, 11, 12, 13, 14},
+    {0, -1, -1, -1, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12},
+    {0, 1, -1, -1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13},
+    {0, 1, 2, -1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+};
+#endif
+
+/** @brief Total data bytes described by one control byte (4..16). */
+static inline usize svb_group_length(u8 control)
+{
+    return (usize)(control & 3) + ((control >> 2) & 3) + ((control >> 4) & 3) +
+           ((control >> 6) & 3) + 4;
+}
+
+/**
+ * @brief Encodes `count` values; returns the number of bytes written.
+ *
+ * The output must have room for codec_max_encoded_size() bytes minus the
+ * header: values are written with 4-byte stores and then truncated.
+ */
+static void svb_encode(const u32 *values, usize count, u32 flags, byte *out,
+                       usize *written)
+{
+    usize control_bytes = (count + 3) / 4;
+    u8 *control = (u8 *)out;
+    byte *data = out + control_bytes;
+    u32 previous = 0;
+
+    ds_memset(control, 0, control_bytes);
+    for(usize i = 0; i < count; i++)
+    {
+        u32 value = values[i];
+        if(flags & CODEC_FLAG_DELTA)
+        {
+            u32 current = value;
+            value -= previous;
+            previous = current;
+        }
+        if(flags & CODEC_FLAG_ZIGZAG)
+            value = zigzag_encode(value);
+
+        u32 code = value < (1u << 8) ? 0 : value < (1u << 16) ? 1
+                                       : value < (1u << 24)   ? 2
+                                                              : 3;
+        control[i / 4] |= (u8)(code << ((i % 4) * 2));
+        ds_memcpy(data, &value, sizeof(u32));
+        data += code + 1;
+    }
+
+    *written = (usize)(data - out);
+}
+
+/**
+ * @brief Decodes a CODEC_STREAMVBYTE payload.
+ *
+ * @param in        Start of the payload (control stream).
+ * @param payload   Payload size in bytes.
+ * @param limit     End of the readable buffer; the SIMD loop may read up to
+ *                  16 bytes ahead but never past this pointer.
+ */
+static Result svb_decode(const byte *in, usize payload, const byte *limit,
+                         usize count, u32 flags, u32 *values)
+{
+    usize control_bytes = (count + 3) / 4;
+    if(payload < control_bytes)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Truncated streamvbyte control stream");
+
+    const u8 *control = (const u8 *)in;
+    const byte *data = in + control_bytes;
+    const byte *data_end = in + payload;
+    u32 previous = 0;
+    usize i = 0;
+
+#if defined(__SSSE3__)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi32(1);
+        __m128i carry = _mm_setzero_si128();
+
+        for(; i + 4 <= count && limit - data >= 16; i += 4)
+        {
+            u8 code = control[i / 4];
+            usize length = svb_group_length(code);
+            if((usize)(data_end - data) < length)
+                return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                    "Truncated streamvbyte data");
+
+            __m128i raw = _mm_loadu_si128((const __m128i *)data);
+            __m128i value = _mm_shuffle_epi8(
+                raw, _mm_loadu_si128((const __m128i *)svb_shuffle[code]));
+            data += length;
+
+            if(flags & CODEC_FLAG_ZIGZAG)
+                value = _mm_xor_si128(
+                    _mm_srli_epi32(value, 1),
+                    _mm_sub_epi32(zero, _mm_and_si128(value, one)));
+            if(flags & CODEC_FLAG_DELTA)
+            {
+                value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+                value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+                value = _mm_add_epi32(value, carry);
+                carry = _mm_shuffle_epi32(value, 0xFF);
+            }
+            _mm_storeu_si128((__m128i *)(values + i), value);
+        }
+        previous = (u32)_mm_cvtsi128_si32(carry);
+    }
+#else
+    (void)limit;
+#endif
+
+    for(; i < count; i++)
+    {
+        u32 code = (control[i / 4] >> ((i % 4) * 2)) & 3;
+        if((usize)(data_end - data) < code + 1)
+            return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                "Truncated streamvbyte data");
+
+        u32 value = 0;
+        for(u32 b = 0; b <= code; b++)
+            value |= (u32)(u8)data[b] << (8 * b);
+        data += code + 1;
+
+        if(flags & CODEC_FLAG_ZIGZAG)
+            value = zigzag_decode(value);
+        if(flags & CODEC_FLAG_DELTA)
+        {
+            value += previous;
+            previous = value;
+        }
+        values[i] = value;
+    }
+
+    if(data != data_end)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Streamvbyte payload size mismatch");
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  PUBLIC API
+ * ============================================================================
+ */
+
+/**
+ * @brief Returns an upper bound on the encoded size of `count` values.
+ *
+ * @param kind  Codec used for encoding.
+ * @param count Number of values.
+ * @return Size in bytes, including the stream header.
+ */
+usize codec_max_encoded_size(Codec_Kind kind, usize count)
+{
+    if(kind == CODEC_BITPACK)
+    {
+        usize blocks = (count + CODEC_BLOCK_SIZE - 1) / CODEC_BLOCK_SIZE;
+        return CODEC_HEADER_SIZE + blocks * (1 + CODEC_BLOCK_SIZE * sizeof(u32));
+    }
+    return CODEC_HEADER_SIZE + (count + 3) / 4 + count * sizeof(u32);
+}
+
+/**
+ * @brief Reports the number of values stored in the stream at `cursor`.
+ */
+Result codec_decoded_count(const byteArray *in, usize cursor, usize *count)
+{
+    DS_ASSERT(count != NULL, "Count output must not be NULL");
+
+    Codec_Header header;
+    CHECK_RESULT(read_header(in, cursor, &header));
+    *count = (usize)header.count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Appends an encoded stream of `count` values to `out`.
+ *
+ * @param values Values to encode (may be NULL when count is 0).
+ * @param count  Number of values.
+ * @param kind   CODEC_BITPACK or CODEC_STREAMVBYTE.
+ * @param flags  Combination of Codec_Flags.
+ * @param out    Destination buffer; grown as needed.
+ * @return RESULT_SUCCESS or an error if arguments are invalid or the buffer
+ *         cannot grow.
+ */
+Result codec_encode_u32(const u32 *values, usize count, Codec_Kind kind,
+                        u32 flags, byteArray *out)
+{
+    DS_ASSERT(out != NULL, "Output buffer must not be NULL");
+    DS_ASSERT(values != NULL || count == 0, "Values must not be NULL");
+    DS_ASSERT(kind == CODEC_BITPACK || kind == CODEC_STREAMVBYTE,
+              "Unknown codec kind");
+    DS_ASSERT((flags & ~CODEC_KNOWN_FLAGS) == 0, "Unknown codec flags");
+
+    CHECK_RESULT(
+        ARRAY_RESERVE(out, out->size + codec_max_encoded_size(kind, count)));
+
+    byte *base = out->data + out->size;
+    usize payload = 0;
+    if(kind == CODEC_BITPACK)
+        bitpack_encode(values, count, flags, base + CODEC_HEADER_SIZE,
+                       &payload);
+    else
+        svb_encode(values, count, flags, base + CODEC_HEADER_SIZE, &payload);
+
+    Codec_Header header = {(u8)kind, (u8)flags, (u64)count, (u64)payload};
+    write_header(base, &header);
+    out->size += CODEC_HEADER_SIZE + payload;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Decodes the stream at `*cursor` into a caller-provided buffer.
+ *
+ * @param in       Buffer holding one or more encoded streams.
+ * @param cursor   Byte offset of the stream; advanced past it on success.
+ * @param values   Destination buffer.
+ * @param capacity Number of elements `values` can hold.
+ * @return RESULT_SUCCESS, DS_ERROR_FULL_CONTAINER if `capacity` is too
+ *         small, or DS_ERROR_CORRUPTED_DATA for malformed input.
+ */
+Result codec_decode_u32(const byteArray *in, usize *cursor, u32 *values,
+                        usize capacity)
+{
+    DS_ASSERT(cursor != NULL, "Cursor must not be NULL");
+
+    Codec_Header header;
+    CHECK_RESULT(read_header(in, *cursor, &header));
+    if(header.count > capacity)
+        return RESULT_ERROR(DS_ERROR_FULL_CONTAINER,
+                            "Decode buffer too small for codec stream");
+    DS_ASSERT(values != NULL || header.count == 0, "Values must not be NULL");
+
+    const byte *payload = in->data + *cursor + CODEC_HEADER_SIZE;
+    usize count = (usize)header.count;
+    if(header.kind == CODEC_BITPACK)
+        CHECK_RESULT(bitpack_decode(payload, (usize)header.payload, count,
+                                    header.flags, values));
+    else
+        CHECK_RESULT(svb_decode(payload, (usize)header.payload,
+                                in->data + in->size, count, header.flags,
+                                values));
+
+    *cursor += CODEC_HEADER_SIZE + (usize)header.payload;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Encodes an i32Array. Values are reinterpreted as u32, so use
+ *        CODEC_FLAG_ZIGZAG for columns holding negative numbers.
+ */
+Result codec_encode_i32(const i32Array *in, Codec_Kind kind, u32 flags,
+                        byteArray *out)
+{
+    DS_ASSERT(in != NULL, "Input array must not be NULL");
+    return codec_encode_u32((const u32 *)in->data, in->size, kind, flags, out);
+}
+
+/**
+ * @brief Decodes the stream at `*cursor`, appending the values to `out`.
+ */
+Result codec_decode_i32(const byteArray *in, usize *cursor, i32Array *out)
+{
+    DS_ASSERT(out != NULL, "Output array must not be NULL");
+
+    usize count;
+    CHECK_RESULT(codec_decoded_count(in, *cursor, &count));
+    if(count > (usize)-1 - out->size)
+        return RESULT_ERROR(DS_ERROR_OVERFLOW, "Decoded array too large");
+    CHECK_RESULT(ARRAY_RESERVE(out, out->size + count));
+    CHECK_RESULT(
+        codec_decode_u32(in, cursor, (u32 *)(out->data + out->size), count));
+    out->size += count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Encodes a u32Array.
+ */
+Result codec_encode_u32_array(const u32Array *in, Codec_Kind kind, u32 flags,
+                              byteArray *out)
+{
+    DS_ASSERT(in != NULL, "Input array must not be NULL");
+    return codec_encode_u32(in->data, in->size, kind, flags, out);
+}
+
+/**
+ * @brief Decodes the stream at `*cursor`, appending the values to `out`.
+ */
+Result codec_decode_u32_array(const byteArray *in, usize *cursor,
+                              u32Array *out)
+{
+    DS_ASSERT(out != NULL, "Output array must not be NULL");
+
+    usize count;
+    CHECK_RESULT(codec_decoded_count(in, *cursor, &count));
+    if(count > (usize)-1 - out->size)
+        return RESULT_ERROR(DS_ERROR_OVERFLOW, "Decoded array too large");
+    CHECK_RESULT(ARRAY_RESERVE(out, out->size + count));
+    CHECK_RESULT(codec_decode_u32(in, cursor, out->data + out->size, count));
+    out->size += count;
+    return RESULT_SUCCESS;
+}
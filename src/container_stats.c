@@ -0,0 +1,163 @@
+#include "../include/container_stats.h"
+#include "../include/memory.h"
+#include <time.h>
+
+/* ============================================================================
+ *  HISTOGRAMS
+ * ============================================================================
+ */
+
+/**
+ * @brief Smallest value falling into `bucket` (inverse of
+ *        container_histogram_bucket()).
+ */
+u64 container_histogram_lower_bound(usize bucket)
+{
+    if(bucket < 4)
+        return (u64)bucket;
+    usize bit = bucket / 4 + 1;
+    return (u64)(4 + bucket % 4) << (bit - 2);
+}
+
+/**
+ * @brief Number of values recorded in a histogram.
+ */
+u64 container_histogram_count(const Container_Histogram *histogram)
+{
+    u64 count = 0;
+    for(usize i = 0; i < CONTAINER_HISTOGRAM_BUCKETS; i++)
+        count += histogram->counts[i];
+    return count;
+}
+
+/**
+ * @brief Lower bound of the bucket holding the `fraction` quantile, or 0
+ *        for an empty histogram.
+ */
+u64 container_histogram_percentile(const Container_Histogram *histogram,
+                                   f64 fraction)
+{
+    u64 count = container_histogram_count(histogram);
+    if(count == 0)
+        return 0;
+
+    // Rank of the value sought, 1-based (nearest rank).
+    u64 rank = (u64)(fraction * (f64)count + 0.5);
+    if(rank < 1)
+        rank = 1;
+    u64 seen = 0;
+    for(usize i = 0; i < CONTAINER_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += histogram->counts[i];
+        if(seen >= rank)
+            return container_histogram_lower_bound(i);
+    }
+    return container_histogram_lower_bound(CONTAINER_HISTOGRAM_BUCKETS - 1);
+}
+
+/* ============================================================================
+ *  STATISTICS
+ * ============================================================================
+ */
+
+/**
+ * @brief Clears `stats` and labels it.
+ *
+ * @param name  Label for reports; must outlive the statistics.
+ * @param flags Container_Stats_Flags.
+ */
+void container_stats_init(Container_Stats *stats, const char *name,
+                          u32 flags)
+{
+    ds_memset(stats, 0, sizeof(*stats));
+    stats->name = name;
+    stats->flags = flags;
+}
+
+/**
+ * @brief Copies histogram counters one atomic load at a time.
+ */
+static void load_histogram(Container_Histogram *copy,
+                           const Container_Histogram *histogram)
+{
+    for(usize i = 0; i < CONTAINER_HISTOGRAM_BUCKETS; i++)
+        copy->counts[i] =
+            __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Returns a copy of the counters, safe to take while containers
+ *        keep recording.
+ */
+Container_Stats container_stats_snapshot(const Container_Stats *stats)
+{
+    Container_Stats copy;
+    copy.name = stats->name;
+    copy.flags = stats->flags;
+    for(usize op = 0; op < CONTAINER_OP_COUNT; op++)
+    {
+        load_histogram(&copy.probes[op], &stats->probes[op]);
+        load_histogram(&copy.latency_ns[op], &stats->latency_ns[op]);
+    }
+    copy.resizes = __atomic_load_n(&stats->resizes, __ATOMIC_RELAXED);
+    copy.resize_bytes =
+        __atomic_load_n(&stats->resize_bytes, __ATOMIC_RELAXED);
+    copy.max_depth = __atomic_load_n(&stats->max_depth, __ATOMIC_RELAXED);
+    return copy;
+}
+
+/**
+ * @brief Clears every counter, keeping the name and flags.
+ *
+ * Operations recorded concurrently may be lost or kept.
+ */
+void container_stats_reset(Container_Stats *stats)
+{
+    for(usize op = 0; op < CONTAINER_OP_COUNT; op++)
+    {
+        for(usize i = 0; i < CONTAINER_HISTOGRAM_BUCKETS; i++)
+        {
+            __atomic_store_n(&stats->probes[op].counts[i], 0,
+                             __ATOMIC_RELAXED);
+            __atomic_store_n(&stats->latency_ns[op].counts[i], 0,
+                             __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_store_n(&stats->resizes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->resize_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->max_depth, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Number of operations of kind `op` (the probe histogram total).
+ */
+u64 container_stats_operations(const Container_Stats *stats, Container_Op op)
+{
+    return container_histogram_count(&stats->probes[op]);
+}
+
+/* ============================================================================
+ *  RECORDING
+ * ============================================================================
+ */
+
+/**
+ * @brief Monotonic time in nanoseconds.
+ */
+u64 container_stats_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+/**
+ * @brief Records that a container grew its storage to `bytes`.
+ */
+void container_stats_resize(Container_Stats *stats, usize bytes)
+{
+    if(!stats)
+        return;
+    __atomic_fetch_add(&stats->resizes, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->resize_bytes, (u64)bytes, __ATOMIC_RELAXED);
+}
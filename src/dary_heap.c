@@ -0,0 +1,147 @@
+#include "../include/dary_heap.h"
+#include "../include/memory.h"
+
+/* ============================================================================
+ *  LIFETIME
+ * ============================================================================
+ */
+
+/**
+ * @brief Initializes an empty heap.
+ *
+ * @param heap     Heap to initialize.
+ * @param capacity Initial number of entries to reserve (may be 0).
+ * @return RESULT_SUCCESS or DS_ERROR_MEMORY_ALLOCATION.
+ */
+Result dary_heap_create(Dary_Heap *heap, usize capacity)
+{
+    DS_ASSERT(heap != NULL, "Heap must not be NULL");
+
+    *heap = (Dary_Heap){0};
+    return ARRAY_RESERVE(heap, capacity);
+}
+
+/**
+ * @brief Frees the heap storage and resets it to an empty state.
+ */
+void dary_heap_destroy(Dary_Heap *heap)
+{
+    if(!heap)
+        return;
+
+    ds_free(heap->data);
+    *heap = (Dary_Heap){0};
+}
+
+/* ============================================================================
+ *  HEAP OPERATIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief Inserts an entry and sifts it up to its position.
+ *
+ * The hole is moved up instead of swapping at every level, so each level
+ * costs a single entry copy.
+ */
+Result dary_heap_push(Dary_Heap *heap, f64 key, u32 value)
+{
+    DS_ASSERT(heap != NULL, "Heap must not be NULL");
+    u64 start = container_stats_begin(heap->stats);
+    usize capacity = heap->capacity;
+    CHECK_RESULT(ARRAY_RESERVE(heap, heap->size + 1));
+    if(heap->stats && heap->capacity != capacity)
+        container_stats_resize(heap->stats,
+                               heap->capacity * sizeof(Dary_Heap_Entry));
+
+    Dary_Heap_Entry *data = heap->data;
+    usize hole = heap->size++;
+    u64 levels = 0;
+    while(hole > 0)
+    {
+        usize parent = (hole - 1) / DARY_HEAP_ARITY;
+        if(data[parent].key <= key)
+            break;
+        data[hole] = data[parent];
+        hole = parent;
+        levels++;
+    }
+    data[hole].key = key;
+    data[hole].value = value;
+    container_stats_record(heap->stats, CONTAINER_OP_INSERT, levels, start);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Removes the smallest entry.
+ *
+ * The last entry is sifted down from the root, picking the smallest of
+ * up to DARY_HEAP_ARITY children at every level.
+ */
+Result dary_heap_pop(Dary_Heap *heap, Dary_Heap_Entry *out)
+{
+    DS_ASSERT(heap != NULL, "Heap must not be NULL");
+    if(heap->size == 0)
+        return RESULT_ERROR(DS_ERROR_EMPTY_CONTAINER, "Heap is empty");
+
+    u64 start = container_stats_begin(heap->stats);
+    Dary_Heap_Entry *data = heap->data;
+    if(out)
+        *out = data[0];
+
+    Dary_Heap_Entry last = data[--heap->size];
+    usize size = heap->size;
+    usize hole = 0;
+    u64 levels = 0;
+    for(;;)
+    {
+        usize first = hole * DARY_HEAP_ARITY + 1;
+        if(first >= size)
+            break;
+
+        usize last_child = first + DARY_HEAP_ARITY;
+        if(last_child > size)
+            last_child = size;
+
+        usize best = first;
+        for(usize child = first + 1; child < last_child; child++)
+        {
+            if(data[child].key < data[best].key)
+                best = child;
+        }
+        if(data[best].key >= last.key)
+            break;
+
+        data[hole] = data[best];
+        hole = best;
+        levels++;
+    }
+    if(size > 0)
+        data[hole] = last;
+    container_stats_record(heap->stats, CONTAINER_OP_REMOVE, levels, start);
+    container_stats_depth(heap->stats, levels);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Reads the smallest entry without removing it.
+ */
+Result dary_heap_peek(const Dary_Heap *heap, Dary_Heap_Entry *out)
+{
+    DS_ASSERT(heap != NULL && out != NULL, "Arguments must not be NULL");
+    if(heap->size == 0)
+        return RESULT_ERROR(DS_ERROR_EMPTY_CONTAINER, "Heap is empty");
+
+    *out = heap->data[0];
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Removes every entry while keeping the allocated storage.
+ */
+void dary_heap_clear(Dary_Heap *heap) { heap->size = 0; }
+
+/**
+ * @brief Returns true if the heap holds no entries.
+ */
+bool dary_heap_is_empty(const Dary_Heap *heap) { return heap->size == 0; }
@@ -0,0 +1,606 @@
+#include "../include/dynamic_graph.h"
+#include "../include/memory.h"
+#include "../include/trace.h"
+#include <stdlib.h>
+
+DECLARE_TYPE(ptr); // ptrArray: list of blocks waiting to be freed
+
+/**
+ * @brief Sorted, immutable adjacency list of one vertex.
+ */
+typedef struct
+{
+        u32 degree;
+        u32 neighbors[];
+} Adjacency_Block;
+
+/**
+ * @brief Adjacency blocks of DYNAMIC_GRAPH_PAGE_SIZE consecutive vertices.
+ *
+ * NULL blocks denote vertices without out-edges.
+ */
+typedef struct
+{
+        Adjacency_Block *blocks[DYNAMIC_GRAPH_PAGE_SIZE];
+} Adjacency_Page;
+
+/**
+ * @brief One published state of the graph.
+ *
+ * `garbage` lists the pages and blocks this version references but its
+ * successor replaced; they are freed together with this version, after
+ * every older version is gone and no reader pins it.
+ */
+struct Graph_Version
+{
+        u64 number;
+        u32 vertex_count;
+        u64 edge_count;
+        usize page_count;
+        Adjacency_Page **pages; // NULL pages hold only empty vertices
+        usize readers;
+        ptrArray garbage;
+        Graph_Version *next; // Newer version
+};
+
+/**
+ * @brief One edge update of a batch.
+ */
+typedef struct
+{
+        u32 source;
+        u32 target;
+        u32 insert; // 0 = delete, 1 = insert
+} Edge_Update;
+
+/* ============================================================================
+ *  VERSION HELPERS
+ * ============================================================================
+ */
+
+static inline const Adjacency_Block *find_block(const Graph_Version *version,
+                                                u32 vertex)
+{
+    const Adjacency_Page *page =
+        version->pages[vertex / DYNAMIC_GRAPH_PAGE_SIZE];
+    return page ? page->blocks[vertex % DYNAMIC_GRAPH_PAGE_SIZE] : NULL;
+}
+
+/**
+ * @brief Frees a version, its garbage and its page table (not the pages).
+ */
+static void free_version(Graph_Version *version)
+{
+    for(usize i = 0; i < version->garbage.size; i++)
+        ds_free(version->garbage.data[i]);
+    ds_free(version->garbage.data);
+    ds_free(version->pages);
+    ds_free(version);
+}
+
+/**
+ * @brief Frees every old version that can no longer be observed.
+ *
+ * Must be called with `version_lock` held.
+ */
+static void reclaim_versions(Dynamic_Graph *graph)
+{
+    while(graph->oldest != graph->current && graph->oldest->readers == 0)
+    {
+        Graph_Version *version = graph->oldest;
+        graph->oldest = version->next;
+        free_version(version);
+    }
+}
+
+/* ============================================================================
+ *  BATCH CONSTRUCTION
+ * ============================================================================
+ */
+
+static int compare_updates(cptr a, cptr b)
+{
+    const Edge_Update *x = (const Edge_Update *)a;
+    const Edge_Update *y = (const Edge_Update *)b;
+    if(x->source != y->source)
+        return x->source < y->source ? -1 : 1;
+    if(x->target != y->target)
+        return x->target < y->target ? -1 : 1;
+    return (int)x->insert - (int)y->insert;
+}
+
+/**
+ * @brief Collects the updates of both lists into one array.
+ */
+static Result gather_updates(const Edge_List *inserts,
+                             const Edge_List *deletes, Edge_Update **updates,
+                             usize *count, u32 *max_vertex)
+{
+    usize insert_count = inserts ? inserts->sources.size : 0;
+    usize delete_count = deletes ? deletes->sources.size : 0;
+    DS_ASSERT(!inserts || inserts->targets.size == insert_count,
+              "Insert list sources and targets differ in length");
+    DS_ASSERT(!deletes || deletes->targets.size == delete_count,
+              "Delete list sources and targets differ in length");
+
+    *count = insert_count + delete_count;
+    *updates = ALLOC_ARRAY(Edge_Update, *count ? *count : 1);
+    if(!*updates)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate edge updates");
+
+    u32 highest = 0;
+    for(usize i = 0; i < *count; i++)
+    {
+        const Edge_List *list = i < insert_count ? inserts : deletes;
+        usize index = i < insert_count ? i : i - insert_count;
+        Edge_Update *update = &(*updates)[i];
+        update->source = list->sources.data[index];
+        update->target = list->targets.data[index];
+        update->insert = i < insert_count;
+
+        if(update->source > highest)
+            highest = update->source;
+        if(update->target > highest)
+            highest = update->target;
+    }
+    *max_vertex = highest;
+    if(highest == UINT32_MAX)
+    {
+        ds_free(*updates);
+        return RESULT_ERROR(DS_ERROR_OVERFLOW, "Vertex id out of range");
+    }
+
+    qsort(*updates, *count, sizeof(Edge_Update), compare_updates);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Merges a block with the sorted updates of its vertex.
+ *
+ * The result holds (old \ deleted) ∪ inserted, sorted and without
+ * duplicates. A NULL block is returned through `merged` when the vertex
+ * ends up with no neighbors.
+ */
+static Result merge_block(const Adjacency_Block *old,
+                          const Edge_Update *updates, usize count,
+                          Adjacency_Block **merged)
+{
+    u32 old_degree = old ? old->degree : 0;
+    usize upper = (usize)old_degree + count;
+    Adjacency_Block *block = (Adjacency_Block *)ds_malloc(
+        sizeof(Adjacency_Block) + upper * sizeof(u32));
+    if(!block)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate adjacency block");
+
+    usize i = 0, j = 0, degree = 0;
+    while(i < old_degree || j < count)
+    {
+        if(j == count ||
+           (i < old_degree && old->neighbors[i] < updates[j].target))
+        {
+            block->neighbors[degree++] = old->neighbors[i++];
+            continue;
+        }
+
+        // Updates are sorted with deletions first, so the last update of a
+        // target decides whether the edge survives.
+        u32 target = updates[j].target;
+        bool present = false;
+        while(j < count && updates[j].target == target)
+            present = updates[j++].insert;
+        if(i < old_degree && old->neighbors[i] == target)
+            i++;
+        if(present)
+            block->neighbors[degree++] = target;
+    }
+
+    if(degree == 0)
+    {
+        ds_free(block);
+        block = NULL;
+    }
+    else
+        block->degree = (u32)degree;
+    *merged = block;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Builds the successor of `base` from sorted updates.
+ *
+ * Replaced pages and blocks are appended to `garbage` (owned by `base`);
+ * on failure everything allocated for the new version is released.
+ */
+static Result build_version(const Graph_Version *base,
+                            const Edge_Update *updates, usize count,
+                            u32 vertex_count, ptrArray *garbage,
+                            Graph_Version **out)
+{
+    Graph_Version *version = ALLOC(Graph_Version);
+    if(!version)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate graph version");
+    *version = (Graph_Version){0};
+    version->number = base->number + 1;
+    version->vertex_count = vertex_count;
+    version->edge_count = base->edge_count;
+    version->page_count =
+        (vertex_count + DYNAMIC_GRAPH_PAGE_SIZE - 1) / DYNAMIC_GRAPH_PAGE_SIZE;
+    version->pages = ALLOC_ARRAY(Adjacency_Page *,
+                                 version->page_count ? version->page_count : 1);
+    if(!version->pages)
+    {
+        ds_free(version);
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate page table");
+    }
+    ds_memcpy(version->pages, base->pages,
+              base->page_count * sizeof(Adjacency_Page *));
+
+    // Objects created for the new version, released again on failure.
+    ptrArray created = {0};
+    usize garbage_mark = garbage->size;
+    Result result = RESULT_SUCCESS;
+    usize copied_page = (usize)-1;
+
+    for(usize first = 0; first < count && result_is_success(result);)
+    {
+        u32 vertex = updates[first].source;
+        usize last = first;
+        while(last < count && updates[last].source == vertex)
+            last++;
+
+        usize page_index = vertex / DYNAMIC_GRAPH_PAGE_SIZE;
+        usize slot = vertex % DYNAMIC_GRAPH_PAGE_SIZE;
+
+        // Updates are sorted by vertex, so a page is copied at most once.
+        if(page_index != copied_page)
+        {
+            Adjacency_Page *page = ALLOC(Adjacency_Page);
+            result = page ? ARRAY_RESERVE(&created, created.size + 1)
+                          : RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                         "Failed to allocate adjacency page");
+            if(result_is_success(result) && version->pages[page_index])
+                result = ARRAY_RESERVE(garbage, garbage->size + 1);
+            if(result_is_error(result))
+            {
+                ds_free(page);
+                break;
+            }
+
+            Adjacency_Page *old_page = version->pages[page_index];
+            if(old_page)
+            {
+                *page = *old_page;
+                garbage->data[garbage->size++] = old_page;
+            }
+            else
+                ds_memset(page, 0, sizeof(Adjacency_Page));
+            created.data[created.size++] = page;
+            version->pages[page_index] = page;
+            copied_page = page_index;
+        }
+
+        Adjacency_Page *page = version->pages[page_index];
+        Adjacency_Block *old = page->blocks[slot];
+        Adjacency_Block *merged = NULL;
+        result = ARRAY_RESERVE(&created, created.size + 1);
+        if(result_is_success(result) && old)
+            result = ARRAY_RESERVE(garbage, garbage->size + 1);
+        if(result_is_success(result))
+            result = merge_block(old, updates + first, last - first, &merged);
+        if(result_is_error(result))
+            break;
+
+        if(merged)
+            created.data[created.size++] = merged;
+        if(old)
+            garbage->data[garbage->size++] = old;
+        version->edge_count -= old ? old->degree : 0;
+        version->edge_count += merged ? merged->degree : 0;
+        page->blocks[slot] = merged;
+        first = last;
+    }
+
+    if(result_is_error(result))
+    {
+        for(usize i = 0; i < created.size; i++)
+            ds_free(created.data[i]);
+        garbage->size = garbage_mark;
+        ds_free(created.data);
+        ds_free(version->pages);
+        ds_free(version);
+        return result;
+    }
+
+    ds_free(created.data);
+    *out = version;
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  LIFETIME AND UPDATES
+ * ============================================================================
+ */
+
+/**
+ * @brief Creates a graph with `vertex_count` isolated vertices.
+ */
+Result dynamic_graph_create(Dynamic_Graph *graph, u32 vertex_count)
+{
+    DS_ASSERT(graph != NULL, "Graph must not be NULL");
+
+    Graph_Version *version = ALLOC(Graph_Version);
+    if(!version)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate graph version");
+    *version = (Graph_Version){0};
+    version->vertex_count = vertex_count;
+    version->page_count =
+        (vertex_count + DYNAMIC_GRAPH_PAGE_SIZE - 1) / DYNAMIC_GRAPH_PAGE_SIZE;
+    version->pages = ALLOC_ARRAY(Adjacency_Page *,
+                                 version->page_count ? version->page_count : 1);
+    if(!version->pages)
+    {
+        ds_free(version);
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate page table");
+    }
+
+    pthread_mutex_init(&graph->writer_lock, NULL);
+    pthread_mutex_init(&graph->version_lock, NULL);
+    graph->current = graph->oldest = version;
+    graph->stats = NULL;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Frees all versions, pages and blocks of the graph.
+ */
+void dynamic_graph_destroy(Dynamic_Graph *graph)
+{
+    if(!graph || !graph->current)
+        return;
+
+    Graph_Version *current = graph->current;
+    while(graph->oldest != current)
+    {
+        Graph_Version *version = graph->oldest;
+        graph->oldest = version->next;
+        free_version(version);
+    }
+
+    for(usize p = 0; p < current->page_count; p++)
+    {
+        Adjacency_Page *page = current->pages[p];
+        if(!page)
+            continue;
+        for(usize slot = 0; slot < DYNAMIC_GRAPH_PAGE_SIZE; slot++)
+            ds_free(page->blocks[slot]);
+        ds_free(page);
+    }
+    free_version(current);
+
+    pthread_mutex_destroy(&graph->writer_lock);
+    pthread_mutex_destroy(&graph->version_lock);
+    graph->current = graph->oldest = NULL;
+}
+
+/**
+ * @brief Applies a batch of deletions and insertions atomically.
+ *
+ * @param graph   Graph to update.
+ * @param inserts Edges to insert (may be NULL).
+ * @param deletes Edges to delete (may be NULL).
+ * @return RESULT_SUCCESS or DS_ERROR_MEMORY_ALLOCATION; on failure the
+ *         graph is unchanged.
+ */
+Result dynamic_graph_apply(Dynamic_Graph *graph, const Edge_List *inserts,
+                           const Edge_List *deletes)
+{
+    DS_ASSERT(graph != NULL && graph->current != NULL,
+              "Graph must be initialized");
+
+    Edge_Update *updates = NULL;
+    usize count = 0;
+    u32 max_vertex = 0;
+    CHECK_RESULT(
+        gather_updates(inserts, deletes, &updates, &count, &max_vertex));
+    if(count == 0)
+    {
+        ds_free(updates);
+        return RESULT_SUCCESS;
+    }
+
+    u64 start = container_stats_begin(graph->stats);
+    u64 span = trace_begin();
+    pthread_mutex_lock(&graph->writer_lock);
+
+    // Only writers replace `current`, so it can be read without the
+    // version lock while the writer lock is held.
+    Graph_Version *base = graph->current;
+    u32 vertex_count = base->vertex_count;
+    if(max_vertex >= vertex_count)
+        vertex_count = max_vertex + 1;
+    usize page_count =
+        (vertex_count + DYNAMIC_GRAPH_PAGE_SIZE - 1) / DYNAMIC_GRAPH_PAGE_SIZE;
+    bool grown = page_count > base->page_count;
+
+    ptrArray garbage = base->garbage;
+    Graph_Version *version = NULL;
+    Result result =
+        build_version(base, updates, count, vertex_count, &garbage, &version);
+
+    pthread_mutex_lock(&graph->version_lock);
+    base->garbage = garbage;
+    if(result_is_success(result))
+    {
+        base->next = version;
+        graph->current = version;
+        reclaim_versions(graph);
+    }
+    pthread_mutex_unlock(&graph->version_lock);
+
+    pthread_mutex_unlock(&graph->writer_lock);
+    trace_end("graph_batch", span, count);
+    ds_free(updates);
+    if(result_is_success(result))
+    {
+        if(grown)
+            container_stats_resize(graph->stats,
+                                   page_count * sizeof(Adjacency_Page *));
+        container_stats_record(graph->stats, CONTAINER_OP_BATCH, count,
+                               start);
+    }
+    return result;
+}
+
+/* ============================================================================
+ *  SNAPSHOTS
+ * ============================================================================
+ */
+
+/**
+ * @brief Pins the newest version for reading.
+ */
+void dynamic_graph_acquire(Dynamic_Graph *graph,
+                           Dynamic_Graph_Snapshot *snapshot)
+{
+    pthread_mutex_lock(&graph->version_lock);
+    graph->current->readers++;
+    snapshot->version = graph->current;
+    snapshot->stats = graph->stats;
+    pthread_mutex_unlock(&graph->version_lock);
+}
+
+/**
+ * @brief Unpins a snapshot, reclaiming versions nobody can observe.
+ */
+void dynamic_graph_release(Dynamic_Graph *graph,
+                           Dynamic_Graph_Snapshot *snapshot)
+{
+    if(!snapshot->version)
+        return;
+
+    pthread_mutex_lock(&graph->version_lock);
+    ((Graph_Version *)snapshot->version)->readers--;
+    reclaim_versions(graph);
+    pthread_mutex_unlock(&graph->version_lock);
+    snapshot->version = NULL;
+}
+
+/**
+ * @brief Returns the version number (number of applied batches).
+ */
+u64 dynamic_graph_version(const Dynamic_Graph_Snapshot *snapshot)
+{
+    return snapshot->version->number;
+}
+
+/**
+ * @brief Returns the number of vertices in the snapshot.
+ */
+u32 dynamic_graph_vertex_count(const Dynamic_Graph_Snapshot *snapshot)
+{
+    return snapshot->version->vertex_count;
+}
+
+/**
+ * @brief Returns the number of edges in the snapshot.
+ */
+u64 dynamic_graph_edge_count(const Dynamic_Graph_Snapshot *snapshot)
+{
+    return snapshot->version->edge_count;
+}
+
+/**
+ * @brief Returns the sorted out-neighbors of `vertex`.
+ *
+ * @return RESULT_SUCCESS or DS_ERROR_INDEX_OUT_OF_BOUNDS.
+ */
+Result dynamic_graph_neighbors(const Dynamic_Graph_Snapshot *snapshot,
+                               u32 vertex, const u32 **neighbors, u32 *degree)
+{
+    DS_ASSERT(snapshot != NULL && neighbors != NULL && degree != NULL,
+              "Arguments must not be NULL");
+    if(vertex >= snapshot->version->vertex_count)
+        return RESULT_ERROR(DS_ERROR_INDEX_OUT_OF_BOUNDS,
+                            "Vertex out of range");
+
+    u64 start = container_stats_begin(snapshot->stats);
+    const Adjacency_Block *block = find_block(snapshot->version, vertex);
+    *neighbors = block ? block->neighbors : NULL;
+    *degree = block ? block->degree : 0;
+    container_stats_record(snapshot->stats, CONTAINER_OP_LOOKUP, 0, start);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Checks whether the edge source -> target exists (binary search).
+ */
+bool dynamic_graph_has_edge(const Dynamic_Graph_Snapshot *snapshot, u32 source,
+                            u32 target)
+{
+    if(source >= snapshot->version->vertex_count)
+        return false;
+
+    u64 start = container_stats_begin(snapshot->stats);
+    const Adjacency_Block *block = find_block(snapshot->version, source);
+    usize low = 0, high = block ? block->degree : 0;
+    u64 steps = 0;
+    while(low < high)
+    {
+        usize mid = low + (high - low) / 2;
+        if(block->neighbors[mid] < target)
+            low = mid + 1;
+        else
+            high = mid;
+        steps++;
+    }
+    container_stats_record(snapshot->stats, CONTAINER_OP_LOOKUP, steps, start);
+    return block && low < block->degree && block->neighbors[low] == target;
+}
+
+/**
+ * @brief Copies the snapshot into a (sorted, unweighted) CSR graph.
+ */
+Result dynamic_graph_to_csr(const Dynamic_Graph_Snapshot *snapshot,
+                            CSR_Graph *csr)
+{
+    DS_ASSERT(snapshot != NULL && csr != NULL, "Arguments must not be NULL");
+
+    const Graph_Version *version = snapshot->version;
+    *csr = (CSR_Graph){0};
+    csr->vertex_count = version->vertex_count;
+    csr->edge_count = version->edge_count;
+
+    Result result =
+        ARRAY_RESERVE(&csr->offsets, (usize)version->vertex_count + 1);
+    if(result_is_success(result))
+        result = ARRAY_RESERVE(&csr->neighbors,
+                               version->edge_count ? version->edge_count : 1);
+    if(result_is_error(result))
+    {
+        csr_graph_destroy(csr);
+        return result;
+    }
+
+    u64 offset = 0;
+    for(u32 v = 0; v < version->vertex_count; v++)
+    {
+        csr->offsets.data[v] = offset;
+        const Adjacency_Block *block = find_block(version, v);
+        if(block)
+        {
+            ds_memcpy(csr->neighbors.data + offset, block->neighbors,
+                      block->degree * sizeof(u32));
+            offset += block->degree;
+        }
+    }
+    csr->offsets.data[version->vertex_count] = offset;
+    csr->offsets.size = (usize)version->vertex_count + 1;
+    csr->neighbors.size = offset;
+    return RESULT_SUCCESS;
+}
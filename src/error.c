@@ -1,4 +1,5 @@
 #include "../include/error.h"
+#include "../include/error_ring.h"
 
 /**
  * @brief Returns a human-readable description of a given ResultCode.
@@ -39,11 +40,74 @@ const char *result_description(Result_Code code)
         return "Data corrupted.";
     case DS_ERROR_NOT_IMPLEMENTED:
         return "Not implemented.";
+    case DS_ERROR_IO:
+        return "I/O error.";
     default:
         return "Unknown error.";
     }
 }
 
+#ifdef DS_COMPACT_RESULT
+
+/**
+ * @brief Context of the last error raised by the calling thread.
+ */
+static _Thread_local Result_Context last_error = {DS_SUCCESS, "Success.",
+                                                  NULL, 0};
+
+/**
+ * @brief Records an error's context and returns its compact Result.
+ *
+ * Only called on the failure path, through RESULT_ERROR(). The event
+ * also goes to the thread's error ring while recording is enabled.
+ */
+Result result_raise(Result_Code code, const char *message, const char *file,
+                    int line)
+{
+    error_ring_record(code, message, file, line);
+    last_error.code = code;
+    last_error.message = message;
+    last_error.file = file;
+    last_error.line = line;
+    return code;
+}
+
+/**
+ * @brief Returns the context of a compact Result.
+ *
+ * @param result A Result returned on the calling thread.
+ * @return The last error recorded by this thread if it carries the same
+ *         code, otherwise a context with only the code's description.
+ */
+Result_Context result_context(Result result)
+{
+    if(result != DS_SUCCESS && last_error.code == result)
+        return last_error;
+    Result_Context context = {result, result_description(result), NULL, 0};
+    return context;
+}
+
+#else
+
+/**
+ * @brief Builds an error Result; only called through RESULT_ERROR().
+ *
+ * The event also goes to the thread's error ring while recording is
+ * enabled.
+ */
+Result result_raise(Result_Code code, const char *message, const char *file,
+                    int line)
+{
+    error_ring_record(code, message, file, line);
+    Result result = {code, message, file, line};
+    return result;
+}
+
+/**
+ * @brief Returns the context of a Result, which carries it itself.
+ */
+Result_Context result_context(Result result) { return result; }
+
 /**
  * @brief Checks whether the result indicates success.
  *
@@ -59,3 +123,5 @@ bool result_is_success(Result result) { return result.code == DS_SUCCESS; }
  * @return true if the operation failed, false otherwise.
  */
 bool result_is_error(Result result) { return result.code != DS_SUCCESS; }
+
+#endif // DS_COMPACT_RESULT
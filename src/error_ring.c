@@ -0,0 +1,252 @@
+#include "../include/error_ring.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief One event slot, guarded by a sequence number.
+ *
+ * The owner sets `sequence` to 2n + 1 while writing its n-th event and to
+ * 2n + 2 once done. A reader keeps an event only if it saw the same even
+ * sequence before and after copying it.
+ */
+typedef struct
+{
+        u64 sequence;
+        Error_Event event;
+} Error_Slot;
+
+/**
+ * @brief A thread's ring; `head` counts the events ever written.
+ */
+typedef struct Error_Ring Error_Ring;
+struct Error_Ring
+{
+        u64 head;
+        Error_Ring *next; // Immutable once published
+        bool in_use;
+        usize id;
+        Error_Slot slots[ERROR_RING_CAPACITY];
+};
+
+/**
+ * @brief All rings ever claimed (lock-free list, never shrinks).
+ */
+static Error_Ring *rings = NULL;
+static usize ring_count = 0;
+static bool recording = false;
+
+static _Thread_local Error_Ring *current_ring = NULL;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+/* ============================================================================
+ *  RING OWNERSHIP
+ * ============================================================================
+ */
+
+/**
+ * @brief Thread exit hook: hands the ring over to a future thread.
+ */
+static void release_ring(void *ring)
+{
+    __atomic_store_n(&((Error_Ring *)ring)->in_use, false, __ATOMIC_RELEASE);
+}
+
+static void create_ring_key(void)
+{
+    pthread_key_create(&ring_key, release_ring);
+}
+
+/**
+ * @brief Claims a released ring, or allocates a new one.
+ *
+ * Rings use the C allocator rather than ds_malloc(): they live as long as
+ * the process and must not show up as leaks in the memory statistics.
+ */
+static Error_Ring *claim_ring(void)
+{
+    pthread_once(&ring_key_once, create_ring_key);
+
+    Error_Ring *head = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+    Error_Ring *ring = NULL;
+    for(Error_Ring *it = head; it && !ring; it = it->next)
+    {
+        bool expected = false;
+        if(!__atomic_load_n(&it->in_use, __ATOMIC_RELAXED) &&
+           __atomic_compare_exchange_n(&it->in_use, &expected, true, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            ring = it;
+    }
+
+    if(!ring)
+    {
+        ring = (Error_Ring *)calloc(1, sizeof(Error_Ring));
+        if(!ring)
+            return NULL;
+        ring->in_use = true;
+        ring->id = __atomic_fetch_add(&ring_count, 1, __ATOMIC_RELAXED);
+        do
+            ring->next = head;
+        while(!__atomic_compare_exchange_n(&rings, &head, ring, true,
+                                           __ATOMIC_RELEASE,
+                                           __ATOMIC_ACQUIRE));
+    }
+
+    pthread_setspecific(ring_key, ring);
+    return ring;
+}
+
+/* ============================================================================
+ *  RECORDING
+ * ============================================================================
+ */
+
+/**
+ * @brief Cheap monotonic time stamp.
+ */
+static u64 read_timestamp(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000u + (u64)now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Turns recording on or off for every thread.
+ */
+void error_ring_enable(bool enabled)
+{
+    __atomic_store_n(&recording, enabled, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Whether errors are currently being recorded.
+ */
+bool error_ring_enabled(void)
+{
+    return __atomic_load_n(&recording, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Appends an event to the calling thread's ring.
+ *
+ * Does nothing while recording is disabled, or if the thread's first
+ * error finds no memory for a ring.
+ */
+void error_ring_record(Result_Code code, const char *message,
+                       const char *file, int line)
+{
+    if(!__atomic_load_n(&recording, __ATOMIC_RELAXED))
+        return;
+    if(!current_ring)
+        current_ring = claim_ring();
+    if(!current_ring)
+        return;
+
+    Error_Ring *ring = current_ring;
+    u64 index = ring->head;
+    Error_Slot *slot = &ring->slots[index & (ERROR_RING_CAPACITY - 1)];
+
+    __atomic_store_n(&slot->sequence, 2 * index + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->event.timestamp, read_timestamp(),
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.code, code, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.line, line, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.file, file, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.message, message, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->sequence, 2 * index + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, index + 1, __ATOMIC_RELEASE);
+}
+
+/* ============================================================================
+ *  INSPECTION
+ * ============================================================================
+ */
+
+/**
+ * @brief Copies the n-th event of a ring if it is still intact.
+ */
+static bool read_event(Error_Ring *ring, u64 index, Error_Event *event)
+{
+    Error_Slot *slot = &ring->slots[index & (ERROR_RING_CAPACITY - 1)];
+    u64 sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+    if(sequence != 2 * index + 2)
+        return false;
+
+    event->timestamp =
+        __atomic_load_n(&slot->event.timestamp, __ATOMIC_RELAXED);
+    event->code = __atomic_load_n(&slot->event.code, __ATOMIC_RELAXED);
+    event->line = __atomic_load_n(&slot->event.line, __ATOMIC_RELAXED);
+    event->file = __atomic_load_n(&slot->event.file, __ATOMIC_RELAXED);
+    event->message = __atomic_load_n(&slot->event.message, __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+/**
+ * @brief Index of the oldest event still held by a ring of `head` events.
+ */
+static u64 first_event(u64 head)
+{
+    return head > ERROR_RING_CAPACITY ? head - ERROR_RING_CAPACITY : 0;
+}
+
+/**
+ * @brief Copies the calling thread's most recent events, oldest first.
+ */
+usize error_ring_snapshot(Error_Event *events, usize capacity)
+{
+    if(!events || !current_ring)
+        return 0;
+
+    u64 head = current_ring->head;
+    u64 first = first_event(head);
+    if(head - first > capacity)
+        first = head - capacity;
+
+    usize count = 0;
+    for(u64 index = first; index < head; index++)
+        if(read_event(current_ring, index, &events[count]))
+            count++;
+    return count;
+}
+
+/**
+ * @brief Prints every ring's events to `stream`.
+ */
+void error_ring_dump(FILE *stream)
+{
+    if(!stream)
+        return;
+
+    Error_Ring *ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+    for(; ring; ring = ring->next)
+    {
+        u64 head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if(head == 0)
+            continue;
+
+        bool active = __atomic_load_n(&ring->in_use, __ATOMIC_RELAXED);
+        fprintf(stream, "Error ring %zu (%s, %llu events):\n", ring->id,
+                active ? "active" : "released", (unsigned long long)head);
+        for(u64 index = first_event(head); index < head; index++)
+        {
+            Error_Event event;
+            if(!read_event(ring, index, &event))
+                continue;
+            fprintf(stream, "  [%llu] %s %s (%s:%d)\n",
+                    (unsigned long long)event.timestamp,
+                    result_description(event.code),
+                    event.message ? event.message : "",
+                    event.file ? event.file : "?", event.line);
+        }
+    }
+    fflush(stream);
+}
@@ -0,0 +1,398 @@
+#include "../include/graph.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+#include "../include/parallel_ops.h"
+
+/**
+ * @brief Minimum number of edges or vertices handled by one parallel piece.
+ */
+#define CSR_GRAIN 16384
+
+/**
+ * @brief Number of edges whose slots are claimed at once during scatter.
+ */
+#define SCATTER_BATCH 64
+
+/**
+ * @brief Shared state of one parallel construction.
+ *
+ * Exactly one of `edges` (build from an edge list) and `source` (build the
+ * transpose of an existing graph) is set.
+ */
+typedef struct
+{
+        const Edge_List *edges;
+        const CSR_Graph *source;
+        CSR_Graph *graph;
+        u32 flags;
+        bool invalid; // Set (atomically) when an edge is out of range
+} CSR_Build;
+
+/* ============================================================================
+ *  PARALLEL PASSES
+ * ============================================================================
+ */
+
+/**
+ * @brief Atomically reserves a slot in the adjacency list of `vertex`.
+ */
+static inline u64 claim_slot(u64 *offsets, u32 vertex)
+{
+    return __atomic_fetch_add(&offsets[vertex], 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Pass 1: counts the out-degree of every vertex into offsets[v].
+ */
+static void count_degrees(usize begin, usize end, ptr context)
+{
+    CSR_Build *build = (CSR_Build *)context;
+    u64 *degree = build->graph->offsets.data;
+    u32 vertex_count = build->graph->vertex_count;
+
+    if(build->source)
+    {
+        const CSR_Graph *source = build->source;
+        for(usize e = source->offsets.data[begin]; e < source->offsets.data[end];
+            e++)
+            claim_slot(degree, source->neighbors.data[e]);
+        return;
+    }
+
+    const u32 *sources = build->edges->sources.data;
+    const u32 *targets = build->edges->targets.data;
+    bool symmetric = build->flags & CSR_BUILD_SYMMETRIC;
+
+    for(usize e = begin; e < end; e++)
+    {
+        u32 u = sources[e];
+        u32 v = targets[e];
+        if(u >= vertex_count || v >= vertex_count)
+        {
+            __atomic_store_n(&build->invalid, true, __ATOMIC_RELAXED);
+            return;
+        }
+        claim_slot(degree, u);
+        if(symmetric && u != v)
+            claim_slot(degree, v);
+    }
+}
+
+/**
+ * @brief Pass 2: scatters every edge into its adjacency list.
+ *
+ * offsets[v] is used as the insertion cursor of v, so once all edges are
+ * placed it holds the start of v + 1.
+ */
+static void scatter_edges(usize begin, usize end, ptr context)
+{
+    CSR_Build *build = (CSR_Build *)context;
+    CSR_Graph *graph = build->graph;
+    u64 *cursor = graph->offsets.data;
+    u32 *neighbors = graph->neighbors.data;
+    f64 *weights = graph->weights.size ? graph->weights.data : NULL;
+
+    if(build->source)
+    {
+        const CSR_Graph *source = build->source;
+        for(usize u = begin; u < end; u++)
+        {
+            for(u64 e = source->offsets.data[u]; e < source->offsets.data[u + 1];
+                e++)
+            {
+                u64 slot = claim_slot(cursor, source->neighbors.data[e]);
+                neighbors[slot] = (u32)u;
+                if(weights)
+                    weights[slot] = source->weights.data[e];
+            }
+        }
+        return;
+    }
+
+    const Edge_List *edges = build->edges;
+    bool symmetric = build->flags & CSR_BUILD_SYMMETRIC;
+    u64 slots[SCATTER_BATCH * 2];
+
+    // Slots are claimed for a whole batch before any edge is written: a
+    // locked increment waits for pending stores, so interleaving claims with
+    // the (cache-missing) neighbor writes would serialize every edge.
+    for(usize batch = begin; batch < end; batch += SCATTER_BATCH)
+    {
+        usize batch_end =
+            end - batch < SCATTER_BATCH ? end : batch + SCATTER_BATCH;
+        usize claimed = 0;
+
+        for(usize e = batch; e < batch_end; e++)
+        {
+            u32 u = edges->sources.data[e];
+            u32 v = edges->targets.data[e];
+            slots[claimed++] = claim_slot(cursor, u);
+            if(symmetric && u != v)
+                slots[claimed++] = claim_slot(cursor, v);
+        }
+
+        claimed = 0;
+        for(usize e = batch; e < batch_end; e++)
+        {
+            u32 u = edges->sources.data[e];
+            u32 v = edges->targets.data[e];
+            u64 slot = slots[claimed++];
+            neighbors[slot] = v;
+            if(weights)
+                weights[slot] = edges->weights.data[e];
+
+            if(symmetric && u != v)
+            {
+                slot = slots[claimed++];
+                neighbors[slot] = u;
+                if(weights)
+                    weights[slot] = edges->weights.data[e];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Sorts one adjacency list by target, moving weights along.
+ *
+ * Quicksort with median-of-three pivots, recursing on the smaller side,
+ * and insertion sort for short ranges (most adjacency lists are short).
+ */
+static void sort_adjacency(u32 *targets, f64 *weights, usize count)
+{
+    while(count > 16)
+    {
+        usize mid = count / 2;
+        u32 a = targets[0], b = targets[mid], c = targets[count - 1];
+        u32 pivot = (a < b) ? ((b < c) ? b : (a < c ? c : a))
+                            : ((a < c) ? a : (b < c ? c : b));
+
+        usize i = 0, j = count - 1;
+        for(;;)
+        {
+            while(targets[i] < pivot)
+                i++;
+            while(targets[j] > pivot)
+                j--;
+            if(i >= j)
+                break;
+
+            u32 t = targets[i];
+            targets[i] = targets[j];
+            targets[j] = t;
+            if(weights)
+            {
+                f64 w = weights[i];
+                weights[i] = weights[j];
+                weights[j] = w;
+            }
+            i++;
+            j--;
+        }
+
+        usize left = j + 1;
+        if(left < count - left)
+        {
+            sort_adjacency(targets, weights, left);
+            targets += left;
+            weights = weights ? weights + left : NULL;
+            count -= left;
+        }
+        else
+        {
+            sort_adjacency(targets + left, weights ? weights + left : NULL,
+                           count - left);
+            count = left;
+        }
+    }
+
+    for(usize i = 1; i < count; i++)
+    {
+        u32 t = targets[i];
+        f64 w = weights ? weights[i] : 0.0;
+        usize j = i;
+        while(j > 0 && targets[j - 1] > t)
+        {
+            targets[j] = targets[j - 1];
+            if(weights)
+                weights[j] = weights[j - 1];
+            j--;
+        }
+        targets[j] = t;
+        if(weights)
+            weights[j] = w;
+    }
+}
+
+/**
+ * @brief Pass 3 (optional): sorts the adjacency lists of a vertex range.
+ */
+static void sort_vertices(usize begin, usize end, ptr context)
+{
+    CSR_Graph *graph = (CSR_Graph *)context;
+    f64 *weights = graph->weights.size ? graph->weights.data : NULL;
+
+    for(usize v = begin; v < end; v++)
+    {
+        u64 first = graph->offsets.data[v];
+        sort_adjacency(graph->neighbors.data + first,
+                       weights ? weights + first : NULL,
+                       (usize)(graph->offsets.data[v + 1] - first));
+    }
+}
+
+/* ============================================================================
+ *  CONSTRUCTION PIPELINE
+ * ============================================================================
+ */
+
+/**
+ * @brief Runs the counting-sort pipeline shared by build and transpose.
+ *
+ * @param build         Initialized build state (graph->vertex_count set).
+ * @param item_count    Number of loop items of the count/scatter passes:
+ *                      edges for an edge list, vertices for a transpose.
+ * @param weighted      Whether to allocate and fill a weight array.
+ */
+static Result run_build(CSR_Build *build, usize item_count, bool weighted)
+{
+    CSR_Graph *graph = build->graph;
+    usize vertex_count = graph->vertex_count;
+
+    graph->offsets.data = ALLOC_ARRAY(u64, vertex_count + 1);
+    if(!graph->offsets.data)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate CSR offsets");
+    graph->offsets.size = graph->offsets.capacity = vertex_count + 1;
+
+    CHECK_RESULT(
+        ds_parallel_for(0, item_count, CSR_GRAIN, count_degrees, build));
+    if(build->invalid)
+        return RESULT_ERROR(DS_ERROR_INDEX_OUT_OF_BOUNDS,
+                            "Edge references a vertex out of range");
+
+    // Exclusive prefix sum of the degrees; the extra last entry (always
+    // zero) receives the edge count.
+    u64 total;
+    CHECK_RESULT(ds_prefix_sum_u64(&graph->offsets, &total));
+
+    graph->edge_count = total;
+    graph->neighbors.data = ALLOC_ARRAY(u32, total ? total : 1);
+    if(!graph->neighbors.data)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate CSR neighbors");
+    graph->neighbors.size = graph->neighbors.capacity = total;
+
+    if(weighted && total)
+    {
+        graph->weights.data = ALLOC_ARRAY(f64, total);
+        if(!graph->weights.data)
+            return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                "Failed to allocate CSR weights");
+        graph->weights.size = graph->weights.capacity = total;
+    }
+
+    CHECK_RESULT(
+        ds_parallel_for(0, item_count, CSR_GRAIN, scatter_edges, build));
+
+    // Every cursor now points at the start of the next vertex: shift back.
+    ds_memmove(graph->offsets.data + 1, graph->offsets.data,
+               vertex_count * sizeof(u64));
+    graph->offsets.data[0] = 0;
+
+    if(build->flags & CSR_BUILD_SORTED)
+        CHECK_RESULT(ds_parallel_for(0, vertex_count, CSR_GRAIN / 16,
+                                     sort_vertices, graph));
+
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  PUBLIC API
+ * ============================================================================
+ */
+
+/**
+ * @brief Builds a CSR graph from an edge list.
+ *
+ * @param graph        Graph to initialize (any previous content is ignored).
+ * @param vertex_count Number of vertices.
+ * @param edges        Edge list; weights are optional.
+ * @param flags        Combination of CSR_Build_Flags.
+ * @return RESULT_SUCCESS or an error; on error `graph` is left empty.
+ */
+Result csr_graph_build(CSR_Graph *graph, u32 vertex_count,
+                       const Edge_List *edges, u32 flags)
+{
+    DS_ASSERT(graph != NULL && edges != NULL, "Arguments must not be NULL");
+    DS_ASSERT(edges->sources.size == edges->targets.size,
+              "Edge list sources and targets differ in length");
+    DS_ASSERT(edges->weights.size == 0 ||
+                  edges->weights.size == edges->sources.size,
+              "Edge list weights differ in length");
+
+    *graph = (CSR_Graph){0};
+    graph->vertex_count = vertex_count;
+
+    CSR_Build build = {0};
+    build.edges = edges;
+    build.graph = graph;
+    build.flags = flags;
+
+    Result result =
+        run_build(&build, edges->sources.size, edges->weights.size != 0);
+    if(result_is_error(result))
+        csr_graph_destroy(graph);
+    return result;
+}
+
+/**
+ * @brief Builds the transpose of `graph` (all edges reversed).
+ *
+ * The adjacency lists of the transpose are always sorted by id. The
+ * transpose provides the in-neighbors needed by bottom-up traversals of
+ * directed graphs.
+ */
+Result csr_graph_transpose(const CSR_Graph *graph, CSR_Graph *transposed)
+{
+    DS_ASSERT(graph != NULL && transposed != NULL,
+              "Arguments must not be NULL");
+
+    *transposed = (CSR_Graph){0};
+    transposed->vertex_count = graph->vertex_count;
+
+    CSR_Build build = {0};
+    build.source = graph;
+    build.graph = transposed;
+    build.flags = CSR_BUILD_SORTED;
+
+    Result result =
+        run_build(&build, graph->vertex_count, graph->weights.size != 0);
+    if(result_is_error(result))
+        csr_graph_destroy(transposed);
+    return result;
+}
+
+/**
+ * @brief Sorts every adjacency list of `graph` by target id, in parallel.
+ */
+Result csr_graph_sort_neighbors(CSR_Graph *graph)
+{
+    DS_ASSERT(graph != NULL, "Graph must not be NULL");
+    return ds_parallel_for(0, graph->vertex_count, CSR_GRAIN / 16,
+                           sort_vertices, graph);
+}
+
+/**
+ * @brief Frees the arrays owned by a CSR graph and zeroes it.
+ */
+void csr_graph_destroy(CSR_Graph *graph)
+{
+    if(!graph)
+        return;
+
+    ds_free(graph->offsets.data);
+    ds_free(graph->neighbors.data);
+    ds_free(graph->weights.data);
+    *graph = (CSR_Graph){0};
+}
@@ -0,0 +1,419 @@
+#include "../include/graph_reorder.h"
+#include "../include/bitset.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+#include "../include/parallel_ops.h"
+#include <stdlib.h>
+
+/**
+ * @brief Minimum vertices handled by one parallel piece of the permutation.
+ */
+#define PERMUTE_GRAIN 4096
+
+/**
+ * @brief Shared state of csr_graph_permute().
+ */
+typedef struct
+{
+        const CSR_Graph *graph;
+        const u32 *permutation; // old -> new
+        const u32 *inverse;     // new -> old
+        CSR_Graph *permuted;
+} Permute_State;
+
+/* ============================================================================
+ *  HELPERS
+ * ============================================================================
+ */
+
+/**
+ * @brief Resizes a permutation array to `count` entries.
+ */
+static Result prepare_output(u32Array *permutation, u32 count)
+{
+    CHECK_RESULT(ARRAY_RESERVE(permutation, count ? count : 1));
+    permutation->size = count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Stores the permutation that gives order[i] the new id i.
+ */
+static void order_to_permutation(const u32 *order, u32 count, bool reverse,
+                                 u32 *permutation)
+{
+    for(u32 i = 0; i < count; i++)
+        permutation[order[i]] = reverse ? count - 1 - i : i;
+}
+
+/**
+ * @brief Lists all vertices by degree with a stable counting sort.
+ *
+ * @param descending Largest degrees first when true, smallest otherwise.
+ * @param order      Receives vertex_count vertex ids.
+ */
+static Result sort_by_degree(const CSR_Graph *graph, bool descending,
+                             u32 *order)
+{
+    u32 vertex_count = graph->vertex_count;
+    u64 max_degree = 0;
+    for(u32 v = 0; v < vertex_count; v++)
+    {
+        u64 degree = csr_graph_degree(graph, v);
+        if(degree > max_degree)
+            max_degree = degree;
+    }
+
+    u64 *start = ALLOC_ARRAY(u64, max_degree + 1);
+    if(!start)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate degree buckets");
+
+    for(u32 v = 0; v < vertex_count; v++)
+        start[csr_graph_degree(graph, v)]++;
+
+    u64 position = 0;
+    for(u64 i = 0; i <= max_degree; i++)
+    {
+        u64 degree = descending ? max_degree - i : i;
+        u64 count = start[degree];
+        start[degree] = position;
+        position += count;
+    }
+
+    for(u32 v = 0; v < vertex_count; v++)
+        order[start[csr_graph_degree(graph, v)]++] = v;
+
+    ds_free(start);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Three-way comparison of u64 values for qsort().
+ */
+static int compare_u64(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a;
+    u64 y = *(const u64 *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sorts packed (degree << 32 | vertex) keys.
+ *
+ * Most neighbor lists are short, so insertion sort handles them; qsort()
+ * takes over for hubs.
+ */
+static void sort_keys(u64 *keys, usize count)
+{
+    if(count > 32)
+    {
+        qsort(keys, count, sizeof(u64), compare_u64);
+        return;
+    }
+
+    for(usize i = 1; i < count; i++)
+    {
+        u64 key = keys[i];
+        usize j = i;
+        while(j > 0 && keys[j - 1] > key)
+        {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+    }
+}
+
+/**
+ * @brief Appends to `order` every vertex reachable from `start` that is not
+ *        yet visited, in breadth-first order.
+ *
+ * @param keys  Scratch of max-degree entries when neighbors must be visited
+ *              by increasing degree (Cuthill-McKee), NULL for stored order.
+ * @param tail  Number of vertices already in `order`; updated.
+ */
+static void visit_component(const CSR_Graph *graph, u32 start,
+                            Bitset *visited, u64 *keys, u32 *order,
+                            u32 *tail)
+{
+    u32 head = *tail;
+    bitset_set(visited, start);
+    order[(*tail)++] = start;
+
+    while(head < *tail)
+    {
+        u32 u = order[head++];
+        usize found = 0;
+
+        CSR_Neighbors it = csr_neighbors(graph, u);
+        u32 v;
+        f64 weight;
+        while(csr_neighbors_next(&it, &v, &weight))
+        {
+            if(bitset_test(visited, v))
+                continue;
+            bitset_set(visited, v);
+            if(keys)
+                keys[found++] = (csr_graph_degree(graph, v) << 32) | v;
+            else
+                order[(*tail)++] = v;
+        }
+
+        if(keys)
+        {
+            sort_keys(keys, found);
+            for(usize i = 0; i < found; i++)
+                order[(*tail)++] = (u32)keys[i];
+        }
+    }
+}
+
+/**
+ * @brief Shared driver of the breadth-first orderings.
+ *
+ * Components are started in degree order (ascending for Cuthill-McKee,
+ * descending for BFS), so the whole graph is covered even when it is
+ * disconnected or directed.
+ */
+static Result traversal_order(const CSR_Graph *graph, bool cuthill_mckee,
+                              u32 *permutation)
+{
+    u32 vertex_count = graph->vertex_count;
+    u64 max_degree = 0;
+    if(cuthill_mckee)
+        for(u32 v = 0; v < vertex_count; v++)
+        {
+            u64 degree = csr_graph_degree(graph, v);
+            if(degree > max_degree)
+                max_degree = degree;
+        }
+
+    u32 *starts = ALLOC_ARRAY(u32, vertex_count);
+    u32 *order = ALLOC_ARRAY(u32, vertex_count);
+    u64 *keys = cuthill_mckee ? ALLOC_ARRAY(u64, max_degree + 1) : NULL;
+    Bitset visited = {0};
+    Result result = RESULT_SUCCESS;
+
+    if(!starts || !order || (cuthill_mckee && !keys))
+        result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                              "Failed to allocate ordering scratch");
+    if(result_is_success(result))
+        result = bitset_create(&visited, vertex_count);
+    if(result_is_success(result))
+        result = sort_by_degree(graph, !cuthill_mckee, starts);
+    if(result_is_success(result))
+    {
+        u32 tail = 0;
+        for(u32 i = 0; i < vertex_count && tail < vertex_count; i++)
+            if(!bitset_test(&visited, starts[i]))
+                visit_component(graph, starts[i], &visited, keys, order,
+                                &tail);
+        order_to_permutation(order, vertex_count, cuthill_mckee, permutation);
+    }
+
+    bitset_destroy(&visited);
+    ds_free(keys);
+    ds_free(order);
+    ds_free(starts);
+    return result;
+}
+
+/* ============================================================================
+ *  PERMUTATION
+ * ============================================================================
+ */
+
+/**
+ * @brief Stores the degree of a range of new vertices into their offsets.
+ */
+static void copy_degrees(usize begin, usize end, ptr context)
+{
+    Permute_State *state = (Permute_State *)context;
+    for(usize n = begin; n < end; n++)
+        state->permuted->offsets.data[n] =
+            csr_graph_degree(state->graph, state->inverse[n]);
+}
+
+/**
+ * @brief Copies the adjacency lists of a range of new vertices, renaming
+ *        every target.
+ */
+static void copy_lists(usize begin, usize end, ptr context)
+{
+    Permute_State *state = (Permute_State *)context;
+    const CSR_Graph *graph = state->graph;
+    CSR_Graph *permuted = state->permuted;
+    bool weighted = graph->weights.size != 0;
+
+    for(usize n = begin; n < end; n++)
+    {
+        u32 old = state->inverse[n];
+        u64 from = graph->offsets.data[old];
+        u64 to = permuted->offsets.data[n];
+        u64 degree = graph->offsets.data[old + 1] - from;
+
+        for(u64 i = 0; i < degree; i++)
+            permuted->neighbors.data[to + i] =
+                state->permutation[graph->neighbors.data[from + i]];
+        if(weighted)
+            ds_memcpy(permuted->weights.data + to, graph->weights.data + from,
+                      degree * sizeof(f64));
+    }
+}
+
+/**
+ * @brief Allocates and fills the arrays of the permuted graph.
+ */
+static Result run_permute(Permute_State *state)
+{
+    const CSR_Graph *graph = state->graph;
+    CSR_Graph *permuted = state->permuted;
+    u32 vertex_count = graph->vertex_count;
+    u64 edge_count = graph->edge_count;
+
+    permuted->offsets.data = ALLOC_ARRAY(u64, (usize)vertex_count + 1);
+    permuted->neighbors.data = ALLOC_ARRAY(u32, edge_count ? edge_count : 1);
+    if(!permuted->offsets.data || !permuted->neighbors.data)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate permuted graph");
+    permuted->offsets.size = permuted->offsets.capacity =
+        (usize)vertex_count + 1;
+    permuted->neighbors.size = permuted->neighbors.capacity = edge_count;
+
+    if(graph->weights.size)
+    {
+        permuted->weights.data = ALLOC_ARRAY(f64, edge_count);
+        if(!permuted->weights.data)
+            return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                "Failed to allocate permuted weights");
+        permuted->weights.size = permuted->weights.capacity = edge_count;
+    }
+
+    CHECK_RESULT(ds_parallel_for(0, vertex_count, PERMUTE_GRAIN, copy_degrees,
+                                 state));
+    CHECK_RESULT(ds_prefix_sum_u64(&permuted->offsets, NULL));
+
+    CHECK_RESULT(ds_parallel_for(0, vertex_count, PERMUTE_GRAIN, copy_lists,
+                                 state));
+    return csr_graph_sort_neighbors(permuted);
+}
+
+/* ============================================================================
+ *  PUBLIC API
+ * ============================================================================
+ */
+
+/**
+ * @brief Orders vertices by decreasing degree (hubs first).
+ */
+Result csr_order_degree(const CSR_Graph *graph, u32Array *permutation)
+{
+    DS_ASSERT(graph != NULL && permutation != NULL,
+              "Arguments must not be NULL");
+
+    u32 vertex_count = graph->vertex_count;
+    CHECK_RESULT(prepare_output(permutation, vertex_count));
+
+    u32 *order = ALLOC_ARRAY(u32, vertex_count ? vertex_count : 1);
+    if(!order)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate ordering scratch");
+
+    Result result = sort_by_degree(graph, true, order);
+    if(result_is_success(result))
+        order_to_permutation(order, vertex_count, false, permutation->data);
+    ds_free(order);
+    return result;
+}
+
+/**
+ * @brief Computes the reverse Cuthill-McKee ordering of `graph`.
+ */
+Result csr_order_rcm(const CSR_Graph *graph, u32Array *permutation)
+{
+    DS_ASSERT(graph != NULL && permutation != NULL,
+              "Arguments must not be NULL");
+
+    CHECK_RESULT(prepare_output(permutation, graph->vertex_count));
+    if(graph->vertex_count == 0)
+        return RESULT_SUCCESS;
+    return traversal_order(graph, true, permutation->data);
+}
+
+/**
+ * @brief Computes a breadth-first ordering of `graph`, hubs first.
+ */
+Result csr_order_bfs(const CSR_Graph *graph, u32Array *permutation)
+{
+    DS_ASSERT(graph != NULL && permutation != NULL,
+              "Arguments must not be NULL");
+
+    CHECK_RESULT(prepare_output(permutation, graph->vertex_count));
+    if(graph->vertex_count == 0)
+        return RESULT_SUCCESS;
+    return traversal_order(graph, false, permutation->data);
+}
+
+/**
+ * @brief Inverts a permutation, validating it along the way.
+ *
+ * @return DS_ERROR_INVALID_ARGUMENT if `permutation` has an out-of-range or
+ *         repeated entry.
+ */
+Result csr_permutation_invert(const u32Array *permutation, u32Array *inverse)
+{
+    DS_ASSERT(permutation != NULL && inverse != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(permutation->size <= UINT32_MAX, "Permutation is too large");
+
+    u32 count = (u32)permutation->size;
+    CHECK_RESULT(prepare_output(inverse, count));
+    for(u32 id = 0; id < count; id++)
+        inverse->data[id] = UINT32_MAX;
+
+    for(u32 old = 0; old < count; old++)
+    {
+        u32 id = permutation->data[old];
+        if(id >= count || inverse->data[id] != UINT32_MAX)
+            return RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT,
+                                "Array is not a permutation");
+        inverse->data[id] = old;
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Relabels the vertices of `graph` according to `permutation`.
+ *
+ * @param graph       Source graph (unchanged).
+ * @param permutation permutation[old] = new, vertex_count entries.
+ * @param permuted    Graph to initialize; left empty on error.
+ */
+Result csr_graph_permute(const CSR_Graph *graph, const u32Array *permutation,
+                         CSR_Graph *permuted)
+{
+    DS_ASSERT(graph != NULL && permutation != NULL && permuted != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(graph != permuted, "Graph cannot be permuted in place");
+    DS_ASSERT(permutation->size == graph->vertex_count,
+              "Permutation size differs from the vertex count");
+
+    *permuted = (CSR_Graph){0};
+    permuted->vertex_count = graph->vertex_count;
+    permuted->edge_count = graph->edge_count;
+
+    u32Array inverse = {0};
+    Result result = csr_permutation_invert(permutation, &inverse);
+    if(result_is_success(result))
+    {
+        Permute_State state = {graph, permutation->data, inverse.data,
+                               permuted};
+        result = run_permute(&state);
+    }
+
+    ds_free(inverse.data);
+    if(result_is_error(result))
+        csr_graph_destroy(permuted);
+    return result;
+}
@@ -0,0 +1,727 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // For syscall()
+#endif
+
+#include "../include/loader.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+#include "../include/trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * @brief Alignment of chunk buffers and granularity of chunk sizes.
+ */
+#define LOADER_ALIGNMENT 4096
+
+/**
+ * @brief Largest io_uring submission queue requested.
+ */
+#define LOADER_MAX_QUEUE_DEPTH 4096
+
+typedef enum
+{
+    SLOT_FREE,
+    SLOT_READING,
+    SLOT_READY
+} Slot_State;
+
+typedef struct Loader Loader;
+
+/**
+ * @brief A chunk buffer and the read filling it.
+ *
+ * `error` is 0, an errno value, or -1 if the file ended early.
+ */
+typedef struct
+{
+        byte *buffer;
+        usize file;
+        u64 offset;
+        usize length;
+        usize filled;
+        int error;
+        Slot_State state;
+        struct iovec iov; // Remaining part of the read (io_uring)
+        Task task;        // Blocking read (fallback)
+        Loader *loader;
+} Load_Slot;
+
+/**
+ * @brief Progress of one file: bytes submitted and bytes decoded.
+ */
+typedef struct
+{
+        int fd;
+        bool opened;
+        bool done;
+        u64 size;
+        u64 issued;
+        u64 delivered;
+} Load_File;
+
+/**
+ * @brief An io_uring instance with its mapped rings.
+ */
+typedef struct
+{
+        int fd;
+        u32 *sq_tail;
+        u32 *sq_mask;
+        u32 *sq_array;
+        struct io_uring_sqe *sqes;
+        u32 *cq_head;
+        u32 *cq_tail;
+        u32 *cq_mask;
+        struct io_uring_cqe *cqes;
+        ptr sq_ring;
+        usize sq_ring_size;
+        ptr cq_ring;
+        usize cq_ring_size;
+        usize sqes_size;
+        u32 unsubmitted;
+} Uring;
+
+struct Loader
+{
+        const Load_Request *requests;
+        Load_File *files;
+        usize file_count;
+        usize next_file;  // First file with chunks left to submit
+        usize first_open; // First file not completely decoded
+        Load_Slot *slots;
+        usize slot_count;
+        usize chunk_size;
+        byte *buffers;
+
+        bool use_uring;
+        Uring ring;
+        usize reading; // Slots with a read in flight (io_uring)
+
+        pthread_mutex_t lock; // Fallback: guards slot completion
+        pthread_cond_t completed;
+        Task_Group group;
+};
+
+/* ============================================================================
+ *  IO_URING
+ * ============================================================================
+ */
+
+/**
+ * @brief Maps part of an io_uring instance.
+ */
+static ptr map_ring(int fd, usize size, u64 offset)
+{
+    return mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                (off_t)offset);
+}
+
+/**
+ * @brief Releases an io_uring instance.
+ */
+static void uring_destroy(Uring *ring)
+{
+    if(ring->sqes)
+        munmap(ring->sqes, ring->sqes_size);
+    if(ring->cq_ring && ring->cq_ring != ring->sq_ring)
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    if(ring->sq_ring)
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    if(ring->fd >= 0)
+        close(ring->fd);
+    *ring = (Uring){0};
+    ring->fd = -1;
+}
+
+/**
+ * @brief Creates an io_uring instance; false if the kernel refuses.
+ */
+static bool uring_create(Uring *ring, u32 entries)
+{
+    struct io_uring_params params;
+    ds_memset(&params, 0, sizeof(params));
+    *ring = (Uring){0};
+
+    long fd = syscall(__NR_io_uring_setup, entries, &params);
+    ring->fd = (int)fd;
+    if(fd < 0)
+        return false;
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    ring->cq_ring_size = params.cq_off.cqes +
+                         params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if(single && ring->cq_ring_size > ring->sq_ring_size)
+        ring->sq_ring_size = ring->cq_ring_size;
+
+    ring->sq_ring = map_ring(ring->fd, ring->sq_ring_size, IORING_OFF_SQ_RING);
+    if(ring->sq_ring == MAP_FAILED)
+        ring->sq_ring = NULL;
+    ring->cq_ring = single ? ring->sq_ring
+                           : map_ring(ring->fd, ring->cq_ring_size,
+                                      IORING_OFF_CQ_RING);
+    if(ring->cq_ring == MAP_FAILED)
+        ring->cq_ring = NULL;
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *)map_ring(ring->fd, ring->sqes_size,
+                                                 IORING_OFF_SQES);
+    if(ring->sqes == MAP_FAILED)
+        ring->sqes = NULL;
+
+    if(!ring->sq_ring || !ring->cq_ring || !ring->sqes)
+    {
+        uring_destroy(ring);
+        return false;
+    }
+
+    byte *sq = (byte *)ring->sq_ring;
+    byte *cq = (byte *)ring->cq_ring;
+    ring->sq_tail = (u32 *)(sq + params.sq_off.tail);
+    ring->sq_mask = (u32 *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (u32 *)(sq + params.sq_off.array);
+    ring->cq_head = (u32 *)(cq + params.cq_off.head);
+    ring->cq_tail = (u32 *)(cq + params.cq_off.tail);
+    ring->cq_mask = (u32 *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return true;
+}
+
+/**
+ * @brief Queues a vectored read of one slot (submitted by uring_enter()).
+ */
+static void uring_push_read(Uring *ring, int fd, const struct iovec *iov,
+                            u64 offset, u64 user_data)
+{
+    u32 tail = *ring->sq_tail; // Only this thread produces entries
+    u32 index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    ds_memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = (u64)(uintptr_t)iov;
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    ring->sq_array[index] = index;
+
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+}
+
+/**
+ * @brief Submits queued reads and waits for `min_complete` completions.
+ */
+static Result uring_enter(Uring *ring, u32 min_complete)
+{
+    long submitted;
+    do
+        submitted = syscall(__NR_io_uring_enter, ring->fd, ring->unsubmitted,
+                            min_complete,
+                            min_complete ? IORING_ENTER_GETEVENTS : 0, NULL,
+                            0);
+    while(submitted < 0 && errno == EINTR);
+
+    if(submitted < 0)
+        return RESULT_ERROR(DS_ERROR_IO, "io_uring_enter failed");
+    ring->unsubmitted -= (u32)submitted;
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  READS
+ * ============================================================================
+ */
+
+/**
+ * @brief Records a finished read in the fallback (may run on any thread).
+ */
+static void finish_slot(Load_Slot *slot)
+{
+    Loader *loader = slot->loader;
+    pthread_mutex_lock(&loader->lock);
+    __atomic_store_n(&slot->state, SLOT_READY, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&loader->completed);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+/**
+ * @brief Fallback task: fills a slot with blocking pread() calls.
+ */
+static void read_slot(ptr context)
+{
+    Load_Slot *slot = (Load_Slot *)context;
+    int fd = slot->loader->files[slot->file].fd;
+
+    while(slot->filled < slot->length)
+    {
+        ssize_t count = pread(fd, slot->buffer + slot->filled,
+                              slot->length - slot->filled,
+                              (off_t)(slot->offset + slot->filled));
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+        {
+            slot->error = count < 0 ? errno : -1;
+            break;
+        }
+        slot->filled += (usize)count;
+    }
+    finish_slot(slot);
+}
+
+/**
+ * @brief Submits the rest of a slot's read through io_uring.
+ */
+static void submit_uring_read(Loader *loader, Load_Slot *slot)
+{
+    slot->iov.iov_base = slot->buffer + slot->filled;
+    slot->iov.iov_len = slot->length - slot->filled;
+    uring_push_read(&loader->ring, loader->files[slot->file].fd, &slot->iov,
+                    slot->offset + slot->filled,
+                    (u64)(slot - loader->slots));
+}
+
+/**
+ * @brief Handles the io_uring completions available so far.
+ *
+ * Short reads are resubmitted for the missing bytes.
+ */
+static void reap_completions(Loader *loader)
+{
+    Uring *ring = &loader->ring;
+    u32 head = *ring->cq_head;
+    u32 tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    for(; head != tail; head++)
+    {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        Load_Slot *slot = &loader->slots[cqe->user_data];
+
+        if(cqe->res > 0)
+        {
+            slot->filled += (usize)cqe->res;
+            if(slot->filled < slot->length)
+            {
+                submit_uring_read(loader, slot);
+                continue;
+            }
+        }
+        else
+            slot->error = cqe->res < 0 ? -cqe->res : -1;
+
+        slot->state = SLOT_READY;
+        loader->reading--;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Opens the next file with data to read; skips empty files.
+ */
+static Result advance_file(Loader *loader)
+{
+    while(loader->next_file < loader->file_count)
+    {
+        Load_File *file = &loader->files[loader->next_file];
+        if(!file->opened)
+        {
+            file->fd = open(loader->requests[loader->next_file].path,
+                            O_RDONLY);
+            if(file->fd < 0)
+                return RESULT_ERROR(DS_ERROR_IO, "Failed to open file");
+            file->opened = true;
+
+            struct stat info;
+            if(fstat(file->fd, &info) != 0)
+                return RESULT_ERROR(DS_ERROR_IO, "Failed to stat file");
+            file->size = (u64)info.st_size;
+        }
+        if(file->issued < file->size)
+            break;
+        loader->next_file++;
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Starts reads into every free slot, in file order.
+ */
+static Result issue_reads(Loader *loader)
+{
+    for(usize i = 0; i < loader->slot_count; i++)
+    {
+        Load_Slot *slot = &loader->slots[i];
+        if(__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != SLOT_FREE)
+            continue;
+
+        CHECK_RESULT(advance_file(loader));
+        if(loader->next_file == loader->file_count)
+            break;
+
+        Load_File *file = &loader->files[loader->next_file];
+        u64 left = file->size - file->issued;
+        slot->file = loader->next_file;
+        slot->offset = file->issued;
+        slot->length = left < loader->chunk_size ? (usize)left
+                                                 : loader->chunk_size;
+        slot->filled = 0;
+        slot->error = 0;
+        slot->state = SLOT_READING;
+        file->issued += slot->length;
+
+        if(loader->use_uring)
+        {
+            loader->reading++;
+            submit_uring_read(loader, slot);
+        }
+        else
+            ds_task_spawn(&loader->group, &slot->task, read_slot, slot);
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief The slot holding the chunk the first open file needs next.
+ */
+static Load_Slot *head_slot(Loader *loader)
+{
+    if(loader->first_open >= loader->file_count)
+        return NULL;
+
+    const Load_File *file = &loader->files[loader->first_open];
+    for(usize i = 0; i < loader->slot_count; i++)
+    {
+        Load_Slot *slot = &loader->slots[i];
+        if(slot->file == loader->first_open &&
+           slot->offset == file->delivered &&
+           __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != SLOT_FREE)
+            return slot;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Submits pending reads and waits until the next chunk to decode
+ *        (if any is outstanding) has arrived.
+ */
+static Result wait_head(Loader *loader)
+{
+    Load_Slot *head = head_slot(loader);
+
+    if(loader->use_uring)
+    {
+        do
+        {
+            bool ready = !head || head->state == SLOT_READY;
+            if(ready && loader->ring.unsubmitted == 0)
+                break;
+            CHECK_RESULT(uring_enter(&loader->ring, ready ? 0 : 1));
+            reap_completions(loader);
+        } while(head && head->state != SLOT_READY);
+        return RESULT_SUCCESS;
+    }
+
+    if(!head)
+        return RESULT_SUCCESS;
+    pthread_mutex_lock(&loader->lock);
+    while(__atomic_load_n(&head->state, __ATOMIC_ACQUIRE) != SLOT_READY)
+        pthread_cond_wait(&loader->completed, &loader->lock);
+    pthread_mutex_unlock(&loader->lock);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Decodes every chunk whose predecessors have all been decoded.
+ */
+static Result deliver_chunks(Loader *loader)
+{
+    for(usize f = loader->first_open; f < loader->file_count; f++)
+    {
+        Load_File *file = &loader->files[f];
+        const Load_Request *request = &loader->requests[f];
+        if(!file->opened)
+            break;
+        if(file->done)
+            continue;
+
+        bool progress = true;
+        while(progress && file->delivered < file->size)
+        {
+            progress = false;
+            for(usize i = 0; i < loader->slot_count; i++)
+            {
+                Load_Slot *slot = &loader->slots[i];
+                if(slot->file != f || slot->offset != file->delivered ||
+                   __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) !=
+                       SLOT_READY)
+                    continue;
+
+                if(slot->error != 0)
+                    return RESULT_ERROR(DS_ERROR_IO,
+                                        slot->error < 0
+                                            ? "File shrank while loading"
+                                            : "Failed to read file");
+                CHECK_RESULT(request->decode(request->context, slot->buffer,
+                                             slot->filled, slot->offset));
+                file->delivered += slot->filled;
+                slot->state = SLOT_FREE;
+                progress = true;
+            }
+        }
+
+        if(file->delivered == file->size && file->issued == file->size)
+        {
+            CHECK_RESULT(
+                request->decode(request->context, NULL, 0, file->size));
+            close(file->fd);
+            file->done = true;
+        }
+    }
+
+    while(loader->first_open < loader->file_count &&
+          loader->files[loader->first_open].done)
+        loader->first_open++;
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  LOADER
+ * ============================================================================
+ */
+
+/**
+ * @brief Allocates the slots and sets up io_uring or the fallback.
+ */
+static Result loader_init(Loader *loader, const Load_Request *requests,
+                          usize count, Loader_Options options)
+{
+    loader->requests = requests;
+    loader->file_count = count;
+    loader->chunk_size = (options.chunk_size + LOADER_ALIGNMENT - 1) &
+                         ~(usize)(LOADER_ALIGNMENT - 1);
+    loader->slot_count = options.queue_depth < LOADER_MAX_QUEUE_DEPTH
+                             ? options.queue_depth
+                             : LOADER_MAX_QUEUE_DEPTH;
+    loader->group = TASK_GROUP_INIT;
+    loader->ring.fd = -1;
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->completed, NULL);
+
+    if(loader->chunk_size > SIZE_MAX / loader->slot_count)
+        return RESULT_ERROR(DS_ERROR_OVERFLOW, "Loader buffers too large");
+
+    loader->files = ALLOC_ARRAY(Load_File, count ? count : 1);
+    loader->slots = ALLOC_ARRAY(Load_Slot, loader->slot_count);
+    loader->buffers = (byte *)ds_aligned_alloc(
+        LOADER_ALIGNMENT, loader->chunk_size * loader->slot_count);
+    if(!loader->files || !loader->slots || !loader->buffers)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate loader buffers");
+
+    for(usize i = 0; i < count; i++)
+        loader->files[i].fd = -1;
+    for(usize i = 0; i < loader->slot_count; i++)
+    {
+        loader->slots[i].buffer = loader->buffers + i * loader->chunk_size;
+        loader->slots[i].file = SIZE_MAX;
+        loader->slots[i].loader = loader;
+    }
+
+    if(!(options.flags & LOADER_NO_URING))
+        loader->use_uring = uring_create(&loader->ring,
+                                         (u32)loader->slot_count);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Waits for reads in flight, then releases everything.
+ */
+static void loader_destroy(Loader *loader)
+{
+    if(loader->use_uring)
+    {
+        while(loader->reading > 0 &&
+              result_is_success(uring_enter(&loader->ring, 1)))
+            reap_completions(loader);
+        uring_destroy(&loader->ring);
+    }
+    else
+        ds_task_sync(&loader->group);
+
+    for(usize i = 0; loader->files && i < loader->file_count; i++)
+        if(loader->files[i].fd >= 0 && !loader->files[i].done)
+            close(loader->files[i].fd);
+
+    ds_free(loader->files);
+    ds_free(loader->slots);
+    ds_free(loader->buffers);
+    pthread_mutex_destroy(&loader->lock);
+    pthread_cond_destroy(&loader->completed);
+}
+
+/**
+ * @brief Loads every requested file, decoding chunks as they arrive.
+ */
+Result loader_run(const Load_Request *requests, usize count,
+                  Loader_Options options)
+{
+    DS_ASSERT(requests != NULL || count == 0, "Requests must not be NULL");
+    DS_ASSERT(options.chunk_size > 0 && options.queue_depth > 0,
+              "Loader options must be positive");
+    for(usize i = 0; i < count; i++)
+        DS_ASSERT(requests[i].path != NULL && requests[i].decode != NULL,
+                  "Every request needs a path and a decoder");
+
+    u64 span = trace_begin();
+    Loader loader = {0};
+    Result result = loader_init(&loader, requests, count, options);
+    while(result_is_success(result) && loader.first_open < count)
+    {
+        result = issue_reads(&loader);
+        if(result_is_success(result))
+            result = wait_head(&loader);
+        if(result_is_success(result))
+            result = deliver_chunks(&loader);
+    }
+
+    loader_destroy(&loader);
+    trace_end("bulk_load", span, count);
+    return result;
+}
+
+/* ============================================================================
+ *  DECODERS
+ * ============================================================================
+ */
+
+/**
+ * @brief Appends a chunk to a byteArray.
+ */
+Result loader_append_bytes(ptr array, const byte *data, usize size,
+                           u64 offset)
+{
+    (void)offset;
+    byteArray *bytes = (byteArray *)array;
+    DS_ASSERT(bytes != NULL, "Array must not be NULL");
+    if(size == 0)
+        return RESULT_SUCCESS;
+
+    CHECK_RESULT(ARRAY_RESERVE(bytes, bytes->size + size));
+    ds_memcpy(bytes->data + bytes->size, data, size);
+    bytes->size += size;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Prepares a decoder appending to `output`.
+ */
+void record_decoder_init(Record_Decoder *decoder, GenericData *output)
+{
+    *decoder = (Record_Decoder){0};
+    decoder->output = output;
+}
+
+/**
+ * @brief Checks a complete record header.
+ *
+ * Nothing is reserved for the elements yet: the count comes from the
+ * file, so the output only grows as their bytes arrive.
+ */
+static Result start_record(Record_Decoder *decoder)
+{
+    GenericData *output = decoder->output;
+    const Stream_Record_Header *header = &decoder->header;
+
+    if(header->magic != STREAM_RECORD_MAGIC ||
+       header->element_size != output->element_size)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Invalid record header in file");
+    if(header->count > (SIZE_MAX / output->element_size) - output->size)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Record length in file is out of range");
+
+    decoder->remaining = header->count * output->element_size;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Ends the current record: its elements become part of the output.
+ */
+static void finish_record(Record_Decoder *decoder)
+{
+    decoder->output->size += (usize)decoder->header.count;
+    decoder->header_filled = 0;
+}
+
+/**
+ * @brief Decodes a chunk of stream records into a GenericData.
+ */
+Result loader_decode_records(ptr context, const byte *data, usize size,
+                             u64 offset)
+{
+    (void)offset;
+    Record_Decoder *decoder = (Record_Decoder *)context;
+    DS_ASSERT(decoder != NULL && decoder->output != NULL,
+              "Decoder must be initialized");
+    DS_ASSERT(decoder->output->element_size != 0,
+              "Element size must not be zero");
+
+    if(size == 0)
+    {
+        if(decoder->header_filled != 0)
+            return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                "File ends inside a record");
+        return RESULT_SUCCESS;
+    }
+
+    const usize header_size = sizeof(Stream_Record_Header);
+    GenericData *output = decoder->output;
+    while(size > 0)
+    {
+        if(decoder->header_filled < header_size)
+        {
+            usize count = header_size - decoder->header_filled;
+            count = count < size ? count : size;
+            ds_memcpy((byte *)&decoder->header + decoder->header_filled, data,
+                      count);
+            decoder->header_filled += count;
+            data += count;
+            size -= count;
+            if(decoder->header_filled < header_size)
+                break;
+
+            CHECK_RESULT(start_record(decoder));
+            if(decoder->remaining == 0)
+                finish_record(decoder);
+            continue;
+        }
+
+        usize record_bytes = (usize)decoder->header.count *
+                             output->element_size;
+        usize position = output->size * output->element_size + record_bytes -
+                         (usize)decoder->remaining;
+        usize count = decoder->remaining < size ? (usize)decoder->remaining
+                                                : size;
+        usize filled = position + count;
+        CHECK_RESULT(ds_array_reserve(
+            &output->data, &output->capacity,
+            (filled + output->element_size - 1) / output->element_size,
+            output->element_size));
+        ds_memcpy((byte *)output->data + position, data, count);
+        decoder->remaining -= count;
+        data += count;
+        size -= count;
+        if(decoder->remaining == 0)
+            finish_record(decoder);
+    }
+    return RESULT_SUCCESS;
+}
@@ -1,4 +1,7 @@
 #include "../include/memory.h"
+#include "../include/trace.h"
+#include "../include/utils.h"
+#include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,9 +12,88 @@
  * This structure accumulates information about memory allocation
  * throughout the lifetime of the program. It allows tracking total
  * allocations, frees, peak usage, and other runtime statistics.
+ *
+ * Byte counts use the usable size of each block as reported by
+ * malloc_usable_size(), so that a block is accounted for with the same
+ * size when it is allocated and when it is freed, without a header.
  */
 static Memory_Stats stats = {0};
 
+/**
+ * @brief Smallest array growth (new size in bytes) recorded as a trace span.
+ */
+#define TRACED_GROWTH_BYTES ((usize)1 << 16)
+
+/**
+ * @brief Allocation counters per size class.
+ */
+static Size_Class_Stats size_classes = {0};
+
+/**
+ * @brief Size class of an allocation of `size` bytes.
+ */
+static inline usize size_class_of(usize size)
+{
+    if(size <= DS_SIZE_CLASS_MIN)
+        return 0;
+    // Class c holds sizes in (DS_SIZE_CLASS_MIN << (c - 1), ... << c].
+    usize bits = 64 - (usize)__builtin_clzll((u64)(size - 1));
+    usize size_class = bits - (usize)__builtin_ctzll(DS_SIZE_CLASS_MIN);
+    return size_class < DS_SIZE_CLASS_COUNT ? size_class
+                                            : DS_SIZE_CLASS_COUNT - 1;
+}
+
+/**
+ * @brief Counts an allocation of `size` bytes in its size class.
+ */
+static void record_size_class(usize size)
+{
+    usize size_class = size_class_of(size);
+    __atomic_fetch_add(&size_classes.allocation_count[size_class], 1,
+                       __ATOMIC_RELAXED);
+    __atomic_fetch_add(&size_classes.allocated_bytes[size_class], size,
+                       __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Raises the peak usage to `usage` if it exceeds it.
+ */
+static void update_peak(usize usage)
+{
+    usize peak = __atomic_load_n(&stats.peak_usage, __ATOMIC_RELAXED);
+    while(usage > peak &&
+          !__atomic_compare_exchange_n(&stats.peak_usage, &peak, usage, true,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/**
+ * @brief Records a successful allocation of `size` requested bytes.
+ *
+ * Counters are updated atomically so that allocations made concurrently by
+ * the parallel algorithms are all accounted for.
+ */
+static void record_allocation(ptr block, usize size)
+{
+    usize bytes = malloc_usable_size(block);
+    __atomic_fetch_add(&stats.total_allocated, bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats.allocation_count, 1, __ATOMIC_RELAXED);
+    record_size_class(size);
+    update_peak(
+        __atomic_add_fetch(&stats.current_usage, bytes, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Records that `block` is about to be freed.
+ */
+static void record_release(ptr block)
+{
+    usize bytes = malloc_usable_size(block);
+    __atomic_fetch_add(&stats.total_freed, bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats.free_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&stats.current_usage, bytes, __ATOMIC_RELAXED);
+}
+
 /* ============================================================================
  *  BASIC MEMORY ALLOCATION FUNCTIONS
  * ============================================================================
@@ -30,18 +112,7 @@ ptr ds_malloc(usize size)
 {
     ptr result = malloc(size);
     if(result)
-    {
-        // Track allocation statistics
-        stats.total_allocated += size;
-        stats.current_usage += size;
-        stats.allocation_count++;
-
-        // Update peak usage if this allocation exceeds it
-        if(stats.current_usage > stats.peak_usage)
-        {
-            stats.peak_usage = stats.current_usage;
-        }
-    }
+        record_allocation(result, size);
     return result;
 }
 
@@ -57,18 +128,39 @@ ptr ds_malloc(usize size)
  */
 ptr ds_calloc(usize count, usize size)
 {
-    usize total_size = count * size;
     ptr result = calloc(count, size);
+    if(result)
+        record_allocation(result, count * size);
+    return result;
+}
+
+/**
+ * @brief Allocates a zero-initialized block aligned to `alignment` bytes.
+ *
+ * Used for data shared between threads, where aligning to
+ * DS_CACHE_LINE_SIZE keeps independently written fields from sharing a
+ * cache line. The block is released with ds_free() like any other.
+ *
+ * @param alignment Power of two, at least sizeof(ptr).
+ * @param size      Number of bytes to allocate.
+ * @return Pointer to the aligned memory, or NULL if allocation fails or
+ *         `alignment` is invalid.
+ */
+ptr ds_aligned_alloc(usize alignment, usize size)
+{
+    if(alignment < sizeof(ptr) || !is_power_of_two(alignment))
+        return NULL;
+
+    // aligned_alloc() requires the size to be a multiple of the alignment.
+    usize rounded = (size + alignment - 1) & ~(alignment - 1);
+    if(rounded < size)
+        return NULL;
+
+    ptr result = aligned_alloc(alignment, rounded ? rounded : alignment);
     if(result)
     {
-        stats.total_allocated += total_size;
-        stats.current_usage += total_size;
-        stats.allocation_count++;
-
-        if(stats.current_usage > stats.peak_usage)
-        {
-            stats.peak_usage = stats.current_usage;
-        }
+        memset(result, 0, rounded);
+        record_allocation(result, rounded);
     }
     return result;
 }
@@ -76,23 +168,42 @@ ptr ds_calloc(usize count, usize size)
 /**
  * @brief Reallocates memory to a new size.
  *
- * This wraps `realloc()` but does not track the *old* size of the memory block,
- * meaning statistics are approximate. In a full memory tracker, each pointer’s
- * size would be recorded to accurately adjust stats.
+ * The statistics see the old block freed and the new one allocated (one
+ * allocation and, for a non-NULL `pointer`, one free), so
+ * `current_usage` changes by the difference of their sizes.
  *
  * @param pointer Pointer to the existing block (may be NULL).
- * @param new_size New size in bytes.
- * @return Pointer to the reallocated memory, or NULL if allocation fails.
+ * @param new_size New size in bytes (0 frees the block).
+ * @return Pointer to the reallocated memory, or NULL if allocation fails
+ *         (the old block is then left untouched) or `new_size` is 0.
  */
 ptr ds_realloc(ptr pointer, usize new_size)
 {
-    // NOTE: For simplicity, old size is not tracked.
+    if(new_size == 0)
+    {
+        ds_free(pointer);
+        return NULL;
+    }
+
+    usize old_bytes = pointer ? malloc_usable_size(pointer) : 0;
     ptr result = realloc(pointer, new_size);
-    if(result && new_size > 0)
+    if(result)
     {
-        stats.total_allocated += new_size;
-        stats.current_usage += new_size;
-        // Peak usage is automatically updated in malloc/calloc.
+        usize new_bytes = malloc_usable_size(result);
+        __atomic_fetch_add(&stats.total_allocated, new_bytes,
+                           __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats.total_freed, old_bytes, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats.allocation_count, 1, __ATOMIC_RELAXED);
+        if(pointer)
+            __atomic_fetch_add(&stats.free_count, 1, __ATOMIC_RELAXED);
+        record_size_class(new_size);
+        if(new_bytes >= old_bytes)
+            update_peak(__atomic_add_fetch(&stats.current_usage,
+                                           new_bytes - old_bytes,
+                                           __ATOMIC_RELAXED));
+        else
+            __atomic_fetch_sub(&stats.current_usage, old_bytes - new_bytes,
+                               __ATOMIC_RELAXED);
     }
     return result;
 }
@@ -100,8 +211,7 @@ ptr ds_realloc(ptr pointer, usize new_size)
 /**
  * @brief Frees a block of memory previously allocated.
  *
- * This wrapper around `free()` updates only the free count, not memory size,
- * since we lack information about the block’s original size.
+ * Updates the free count, the bytes freed and the current usage.
  *
  * @param pointer Pointer to the memory block to free.
  */
@@ -109,11 +219,8 @@ void ds_free(ptr pointer)
 {
     if(pointer)
     {
+        record_release(pointer);
         free(pointer);
-        stats.free_count++;
-
-        // NOTE: `current_usage` cannot be decremented correctly
-        // without tracking the original block size.
     }
 }
 
@@ -140,6 +247,44 @@ ptr ds_realloc_array(ptr array, usize new_count, usize element_size)
     return ds_realloc(array, new_count * element_size);
 }
 
+/**
+ * @brief Ensures an array has room for at least `needed` elements.
+ *
+ * Capacity grows geometrically through calculate_growth(), so repeated
+ * appends stay amortized O(1). On failure the original block is untouched.
+ *
+ * @param data         Address of the array's data pointer.
+ * @param capacity     Address of the array's capacity (in elements).
+ * @param needed       Minimum number of elements required.
+ * @param element_size Size of each element in bytes.
+ * @return RESULT_SUCCESS, or DS_ERROR_MEMORY_ALLOCATION / DS_ERROR_OVERFLOW.
+ */
+Result ds_array_reserve(ptr *data, usize *capacity, usize needed,
+                        usize element_size)
+{
+    DS_ASSERT(data != NULL && capacity != NULL, "Array must not be NULL");
+
+    if(needed <= *capacity)
+        return RESULT_SUCCESS;
+
+    usize new_capacity = calculate_growth(*capacity, needed - *capacity);
+    if(element_size != 0 && new_capacity > (usize)-1 / element_size)
+        return RESULT_ERROR(DS_ERROR_OVERFLOW, "Array capacity overflow");
+
+    // Small growths are too frequent and cheap to be worth a trace span.
+    usize new_bytes = new_capacity * element_size;
+    u64 span = new_bytes >= TRACED_GROWTH_BYTES ? trace_begin() : 0;
+    ptr grown = ds_realloc_array(*data, new_capacity, element_size);
+    trace_end("array_grow", span, new_bytes);
+    if(!grown)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to grow array storage");
+
+    *data = grown;
+    *capacity = new_capacity;
+    return RESULT_SUCCESS;
+}
+
 /* ============================================================================
  *  MEMORY COPYING AND MANIPULATION UTILITIES
  * ============================================================================
@@ -191,14 +336,73 @@ void ds_memset(ptr dest, byte value, usize size) { memset(dest, value, size); }
  *
  * @return A copy of the global Memory_Stats structure.
  */
-Memory_Stats ds_get_memory_stats(void) { return stats; }
+Memory_Stats ds_get_memory_stats(void)
+{
+    Memory_Stats snapshot;
+    snapshot.total_allocated =
+        __atomic_load_n(&stats.total_allocated, __ATOMIC_RELAXED);
+    snapshot.total_freed =
+        __atomic_load_n(&stats.total_freed, __ATOMIC_RELAXED);
+    snapshot.current_usage =
+        __atomic_load_n(&stats.current_usage, __ATOMIC_RELAXED);
+    snapshot.peak_usage = __atomic_load_n(&stats.peak_usage, __ATOMIC_RELAXED);
+    snapshot.allocation_count =
+        __atomic_load_n(&stats.allocation_count, __ATOMIC_RELAXED);
+    snapshot.free_count = __atomic_load_n(&stats.free_count, __ATOMIC_RELAXED);
+    snapshot.pending_reclaim =
+        __atomic_load_n(&stats.pending_reclaim, __ATOMIC_RELAXED);
+    return snapshot;
+}
 
 /**
- * @brief Resets all memory statistics to zero.
+ * @brief Returns a snapshot of the per-size-class allocation counters.
+ */
+Size_Class_Stats ds_get_size_class_stats(void)
+{
+    Size_Class_Stats snapshot;
+    for(usize i = 0; i < DS_SIZE_CLASS_COUNT; i++)
+    {
+        snapshot.allocation_count[i] = __atomic_load_n(
+            &size_classes.allocation_count[i], __ATOMIC_RELAXED);
+        snapshot.allocated_bytes[i] = __atomic_load_n(
+            &size_classes.allocated_bytes[i], __ATOMIC_RELAXED);
+    }
+    return snapshot;
+}
+
+/**
+ * @brief Largest allocation size counted in `size_class`, or 0 for the
+ *        last class, which has no limit.
+ */
+usize ds_size_class_limit(usize size_class)
+{
+    if(size_class + 1 >= DS_SIZE_CLASS_COUNT)
+        return 0;
+    return (usize)DS_SIZE_CLASS_MIN << size_class;
+}
+
+/**
+ * @brief Resets the cumulative memory statistics to zero.
  *
- * Useful for benchmarking or testing purposes.
+ * Useful for benchmarking or testing purposes. The current usage is kept,
+ * since the blocks it counts will still be freed, and becomes the peak.
  */
-void ds_reset_memory_stats(void) { stats = (Memory_Stats){0}; }
+void ds_reset_memory_stats(void)
+{
+    usize usage = __atomic_load_n(&stats.current_usage, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.total_allocated, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.total_freed, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.peak_usage, usage, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.allocation_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats.free_count, 0, __ATOMIC_RELAXED);
+    for(usize i = 0; i < DS_SIZE_CLASS_COUNT; i++)
+    {
+        __atomic_store_n(&size_classes.allocation_count[i], 0,
+                         __ATOMIC_RELAXED);
+        __atomic_store_n(&size_classes.allocated_bytes[i], 0,
+                         __ATOMIC_RELAXED);
+    }
+}
 
 /**
  * @brief Prints current memory usage statistics to stdout.
@@ -208,11 +412,24 @@ void ds_reset_memory_stats(void) { stats = (Memory_Stats){0}; }
  */
 void ds_print_memory_stats(void)
 {
+    Memory_Stats snapshot = ds_get_memory_stats();
+
     printf("Memory Statistics:\n");
-    printf("  Total Allocated: %zu bytes\n", stats.total_allocated);
-    printf("  Total Freed:     %zu bytes\n", stats.total_freed);
-    printf("  Current Usage:   %zu bytes\n", stats.current_usage);
-    printf("  Peak Usage:      %zu bytes\n", stats.peak_usage);
-    printf("  Allocation Count:%zu\n", stats.allocation_count);
-    printf("  Free Count:      %zu\n", stats.free_count);
+    printf("  Total Allocated: %zu bytes\n", snapshot.total_allocated);
+    printf("  Total Freed:     %zu bytes\n", snapshot.total_freed);
+    printf("  Current Usage:   %zu bytes\n", snapshot.current_usage);
+    printf("  Peak Usage:      %zu bytes\n", snapshot.peak_usage);
+    printf("  Allocation Count:%zu\n", snapshot.allocation_count);
+    printf("  Free Count:      %zu\n", snapshot.free_count);
+    printf("  Pending Reclaim: %zu bytes\n", snapshot.pending_reclaim);
+}
+
+/**
+ * @brief Adjusts the number of bytes waiting for deferred reclamation.
+ *
+ * @param delta Bytes retired (positive) or finally released (negative).
+ */
+void ds_adjust_pending_reclaim(isize delta)
+{
+    __atomic_fetch_add(&stats.pending_reclaim, (usize)delta, __ATOMIC_RELAXED);
 }
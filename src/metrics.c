@@ -0,0 +1,520 @@
+#include "../include/metrics.h"
+#include "../include/memory.h"
+
+/**
+ * @brief Quantiles reported per histogram (1 is the maximum).
+ */
+#define METRICS_QUANTILES 5
+
+static const f64 quantiles[METRICS_QUANTILES] = {0.5, 0.9, 0.99, 0.999, 1.0};
+static const char *const quantile_labels[METRICS_QUANTILES] = {
+    "0.5", "0.9", "0.99", "0.999", "1"};
+static const char *const quantile_keys[METRICS_QUANTILES] = {
+    "p50", "p90", "p99", "p999", "max"};
+
+static const char *const op_names[CONTAINER_OP_COUNT] = {"insert", "remove",
+                                                         "lookup", "batch"};
+
+/**
+ * @brief One Memory_Stats field and how it is exported.
+ */
+typedef struct
+{
+        const char *metric; // Prometheus name
+        const char *type;   // Prometheus type
+        const char *help;
+        const char *key; // JSON key
+        usize offset;    // Offset in Memory_Stats
+} Memory_Metric;
+
+#define MEMORY_METRIC(metric, type, help, field)                               \
+    {metric, type, help, #field, offsetof(Memory_Stats, field)}
+
+static const Memory_Metric memory_metrics[] = {
+    MEMORY_METRIC("ds_memory_allocated_bytes_total", "counter",
+                  "Usable bytes of every block ever allocated.",
+                  total_allocated),
+    MEMORY_METRIC("ds_memory_freed_bytes_total", "counter",
+                  "Usable bytes of every block ever freed.", total_freed),
+    MEMORY_METRIC("ds_memory_usage_bytes", "gauge",
+                  "Usable bytes of the blocks currently allocated.",
+                  current_usage),
+    MEMORY_METRIC("ds_memory_peak_usage_bytes", "gauge",
+                  "Highest usage seen.", peak_usage),
+    MEMORY_METRIC("ds_memory_allocations_total", "counter",
+                  "Allocation calls, reallocations included.",
+                  allocation_count),
+    MEMORY_METRIC("ds_memory_frees_total", "counter",
+                  "Free calls, replaced blocks included.", free_count),
+    MEMORY_METRIC("ds_memory_pending_reclaim_bytes", "gauge",
+                  "Bytes retired but not freed yet.", pending_reclaim),
+};
+
+/**
+ * @brief Count and quantiles of one histogram.
+ */
+typedef struct
+{
+        u64 count;
+        u64 quantiles[METRICS_QUANTILES];
+} Histogram_Summary;
+
+/* ============================================================================
+ *  OUTPUT BUFFER
+ * ============================================================================
+ */
+
+/**
+ * @brief Bounded output buffer.
+ *
+ * `length` keeps counting past the capacity, so that the size needed can
+ * be reported; text that does not fit (with its NUL) is dropped.
+ */
+typedef struct
+{
+        char *data;
+        usize capacity;
+        usize length;
+} Metrics_Writer;
+
+static void put_bytes(Metrics_Writer *writer, const char *text, usize size)
+{
+    if(writer->length + size < writer->capacity)
+        ds_memcpy(writer->data + writer->length, text, size);
+    else if(writer->length + 1 < writer->capacity)
+        ds_memcpy(writer->data + writer->length, text,
+                  writer->capacity - 1 - writer->length);
+    writer->length += size;
+}
+
+static void put_char(Metrics_Writer *writer, char c)
+{
+    put_bytes(writer, &c, 1);
+}
+
+static void put(Metrics_Writer *writer, const char *text)
+{
+    usize size = 0;
+    while(text[size])
+        size++;
+    put_bytes(writer, text, size);
+}
+
+static void put_u64(Metrics_Writer *writer, u64 value)
+{
+    char digits[20];
+    usize count = 0;
+    do
+    {
+        digits[sizeof(digits) - 1 - count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while(value);
+    put_bytes(writer, digits + sizeof(digits) - count, count);
+}
+
+/**
+ * @brief Writes `text` escaped for a Prometheus label value or a JSON
+ *        string (without the quotes).
+ *
+ * Both formats escape backslashes, quotes and newlines the same way;
+ * JSON additionally needs the other control characters as \u00XX.
+ */
+static void put_escaped(Metrics_Writer *writer, const char *text, bool json)
+{
+    static const char hex[] = "0123456789abcdef";
+    for(const char *c = text; *c; c++)
+    {
+        if(*c == '\\' || *c == '"')
+        {
+            put_char(writer, '\\');
+            put_char(writer, *c);
+        }
+        else if(*c == '\n')
+            put(writer, "\\n");
+        else if(json && (unsigned char)*c < 0x20)
+        {
+            put(writer, "\\u00");
+            put_char(writer, hex[(unsigned char)*c >> 4]);
+            put_char(writer, hex[*c & 15]);
+        }
+        else
+            put_char(writer, *c);
+    }
+}
+
+/**
+ * @brief NUL-terminates the output and reports its length.
+ */
+static Result finish(Metrics_Writer *writer, usize *length)
+{
+    if(writer->length < writer->capacity)
+    {
+        writer->data[writer->length] = '\0';
+        *length = writer->length;
+        return RESULT_SUCCESS;
+    }
+
+    if(writer->capacity > 0)
+        writer->data[writer->capacity - 1] = '\0';
+    *length = writer->length + 1;
+    return RESULT_ERROR(DS_ERROR_OVERFLOW, "Metrics buffer too small");
+}
+
+/* ============================================================================
+ *  SNAPSHOTS
+ * ============================================================================
+ */
+
+/**
+ * @brief Summarizes a histogram that may be recorded into concurrently.
+ */
+static void summarize(const Container_Histogram *histogram,
+                      Histogram_Summary *summary)
+{
+    Container_Histogram copy;
+    for(usize i = 0; i < CONTAINER_HISTOGRAM_BUCKETS; i++)
+        copy.counts[i] =
+            __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED);
+
+    summary->count = container_histogram_count(&copy);
+    for(usize q = 0; q < METRICS_QUANTILES; q++)
+        summary->quantiles[q] =
+            container_histogram_percentile(&copy, quantiles[q]);
+}
+
+static u64 load(const u64 *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static const char *container_name(const Container_Stats *stats)
+{
+    return stats->name ? stats->name : "unnamed";
+}
+
+static bool records_latency(const Container_Stats *stats)
+{
+    return (stats->flags & CONTAINER_STATS_LATENCY) != 0;
+}
+
+/* ============================================================================
+ *  PROMETHEUS
+ * ============================================================================
+ */
+
+static void put_family(Metrics_Writer *writer, const char *metric,
+                       const char *type, const char *help)
+{
+    put(writer, "# HELP ");
+    put(writer, metric);
+    put_char(writer, ' ');
+    put(writer, help);
+    put(writer, "\n# TYPE ");
+    put(writer, metric);
+    put_char(writer, ' ');
+    put(writer, type);
+    put_char(writer, '\n');
+}
+
+/**
+ * @brief Writes `metric{container="<name>"` (the label set is left open).
+ */
+static void put_container_sample(Metrics_Writer *writer, const char *metric,
+                                 const Container_Stats *stats)
+{
+    put(writer, metric);
+    put(writer, "{container=\"");
+    put_escaped(writer, container_name(stats), false);
+    put_char(writer, '"');
+}
+
+static void put_value(Metrics_Writer *writer, u64 value)
+{
+    put(writer, "} ");
+    put_u64(writer, value);
+    put_char(writer, '\n');
+}
+
+/**
+ * @brief Writes the quantile samples of one histogram per container and
+ *        operation kind.
+ */
+static void put_prometheus_histograms(Metrics_Writer *writer,
+                                      const char *metric, bool latency,
+                                      const Container_Stats *const *containers,
+                                      usize container_count)
+{
+    for(usize c = 0; c < container_count; c++)
+    {
+        const Container_Stats *stats = containers[c];
+        if(latency && !records_latency(stats))
+            continue;
+        for(usize op = 0; op < CONTAINER_OP_COUNT; op++)
+        {
+            Histogram_Summary summary;
+            summarize(latency ? &stats->latency_ns[op] : &stats->probes[op],
+                      &summary);
+            if(summary.count == 0)
+                continue;
+            for(usize q = 0; q < METRICS_QUANTILES; q++)
+            {
+                put_container_sample(writer, metric, stats);
+                put(writer, ",op=\"");
+                put(writer, op_names[op]);
+                put(writer, "\",quantile=\"");
+                put(writer, quantile_labels[q]);
+                put_char(writer, '"');
+                put_value(writer, summary.quantiles[q]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Formats the statistics in Prometheus text exposition format.
+ *
+ * @param buffer          Output buffer.
+ * @param capacity        Size of `buffer` in bytes.
+ * @param containers      Container statistics to export.
+ * @param container_count Number of entries in `containers`.
+ * @param length          Receives the document length, or the capacity
+ *                        needed on DS_ERROR_OVERFLOW.
+ * @return RESULT_SUCCESS or DS_ERROR_OVERFLOW.
+ */
+Result metrics_format_prometheus(char *buffer, usize capacity,
+                                 const Container_Stats *const *containers,
+                                 usize container_count, usize *length)
+{
+    DS_ASSERT(buffer != NULL || capacity == 0, "Buffer must not be NULL");
+    DS_ASSERT(containers != NULL || container_count == 0,
+              "Containers must not be NULL");
+    DS_ASSERT(length != NULL, "Length must not be NULL");
+
+    Metrics_Writer writer = {buffer, capacity, 0};
+
+    Memory_Stats memory = ds_get_memory_stats();
+    for(usize i = 0; i < sizeof(memory_metrics) / sizeof(*memory_metrics);
+        i++)
+    {
+        const Memory_Metric *metric = &memory_metrics[i];
+        put_family(&writer, metric->metric, metric->type, metric->help);
+        put(&writer, metric->metric);
+        put_char(&writer, ' ');
+        put_u64(&writer,
+                *(const usize *)((const byte *)&memory + metric->offset));
+        put_char(&writer, '\n');
+    }
+
+    Size_Class_Stats classes = ds_get_size_class_stats();
+    for(usize bytes = 0; bytes < 2; bytes++)
+    {
+        const char *metric = bytes ? "ds_memory_size_class_bytes_total"
+                                   : "ds_memory_size_class_allocations_total";
+        put_family(&writer, metric, "counter",
+                   bytes ? "Bytes requested per allocation size class."
+                         : "Allocation calls per allocation size class.");
+        for(usize i = 0; i < DS_SIZE_CLASS_COUNT; i++)
+        {
+            usize limit = ds_size_class_limit(i);
+            put(&writer, metric);
+            put(&writer, "{max_bytes=\"");
+            if(limit)
+                put_u64(&writer, limit);
+            else
+                put(&writer, "+Inf");
+            put_char(&writer, '"');
+            put_value(&writer, bytes ? classes.allocated_bytes[i]
+                                     : classes.allocation_count[i]);
+        }
+    }
+
+    if(container_count > 0)
+    {
+        put_family(&writer, "ds_container_operations_total", "counter",
+                   "Operations per container and kind.");
+        for(usize c = 0; c < container_count; c++)
+        {
+            for(usize op = 0; op < CONTAINER_OP_COUNT; op++)
+            {
+                u64 count = 0;
+                for(usize i = 0; i < CONTAINER_HISTOGRAM_BUCKETS; i++)
+                    count += load(&containers[c]->probes[op].counts[i]);
+                if(count == 0)
+                    continue;
+                put_container_sample(&writer, "ds_container_operations_total",
+                                     containers[c]);
+                put(&writer, ",op=\"");
+                put(&writer, op_names[op]);
+                put_char(&writer, '"');
+                put_value(&writer, count);
+            }
+        }
+
+        put_family(&writer, "ds_container_probe_length", "gauge",
+                   "Probe length quantiles (bucket lower bounds).");
+        put_prometheus_histograms(&writer, "ds_container_probe_length", false,
+                                  containers, container_count);
+        put_family(&writer, "ds_container_latency_nanoseconds", "gauge",
+                   "Operation latency quantiles (bucket lower bounds).");
+        put_prometheus_histograms(&writer, "ds_container_latency_nanoseconds",
+                                  true, containers, container_count);
+
+        put_family(&writer, "ds_container_resizes_total", "counter",
+                   "Storage growths per container.");
+        for(usize c = 0; c < container_count; c++)
+        {
+            put_container_sample(&writer, "ds_container_resizes_total",
+                                 containers[c]);
+            put_value(&writer, load(&containers[c]->resizes));
+        }
+        put_family(&writer, "ds_container_resize_bytes_total", "counter",
+                   "Storage bytes after each growth, summed.");
+        for(usize c = 0; c < container_count; c++)
+        {
+            put_container_sample(&writer, "ds_container_resize_bytes_total",
+                                 containers[c]);
+            put_value(&writer, load(&containers[c]->resize_bytes));
+        }
+        put_family(&writer, "ds_container_max_depth", "gauge",
+                   "Deepest structure seen per container.");
+        for(usize c = 0; c < container_count; c++)
+        {
+            put_container_sample(&writer, "ds_container_max_depth",
+                                 containers[c]);
+            put_value(&writer, load(&containers[c]->max_depth));
+        }
+    }
+
+    return finish(&writer, length);
+}
+
+/* ============================================================================
+ *  JSON
+ * ============================================================================
+ */
+
+static void put_json_key(Metrics_Writer *writer, const char *key)
+{
+    put_char(writer, '"');
+    put(writer, key);
+    put(writer, "\":");
+}
+
+static void put_json_summary(Metrics_Writer *writer, const char *key,
+                             const Histogram_Summary *summary)
+{
+    put_json_key(writer, key);
+    put_char(writer, '{');
+    for(usize q = 0; q < METRICS_QUANTILES; q++)
+    {
+        if(q)
+            put_char(writer, ',');
+        put_json_key(writer, quantile_keys[q]);
+        put_u64(writer, summary->quantiles[q]);
+    }
+    put_char(writer, '}');
+}
+
+static void put_json_container(Metrics_Writer *writer,
+                               const Container_Stats *stats)
+{
+    put(writer, "{\"name\":\"");
+    put_escaped(writer, container_name(stats), true);
+    put(writer, "\",\"resizes\":");
+    put_u64(writer, load(&stats->resizes));
+    put(writer, ",\"resize_bytes\":");
+    put_u64(writer, load(&stats->resize_bytes));
+    put(writer, ",\"max_depth\":");
+    put_u64(writer, load(&stats->max_depth));
+    put(writer, ",\"operations\":{");
+
+    bool first = true;
+    for(usize op = 0; op < CONTAINER_OP_COUNT; op++)
+    {
+        Histogram_Summary probes;
+        summarize(&stats->probes[op], &probes);
+        if(probes.count == 0)
+            continue;
+        if(!first)
+            put_char(writer, ',');
+        first = false;
+
+        put_json_key(writer, op_names[op]);
+        put(writer, "{\"count\":");
+        put_u64(writer, probes.count);
+        put_char(writer, ',');
+        put_json_summary(writer, "probe_length", &probes);
+        if(records_latency(stats))
+        {
+            Histogram_Summary latency;
+            summarize(&stats->latency_ns[op], &latency);
+            put_char(writer, ',');
+            put_json_summary(writer, "latency_ns", &latency);
+        }
+        put_char(writer, '}');
+    }
+    put(writer, "}}");
+}
+
+/**
+ * @brief Formats the statistics as one JSON object.
+ *
+ * The object has the members "memory" (the Memory_Stats fields),
+ * "size_classes" (an array of {max_bytes, allocations, bytes}, max_bytes
+ * being null for the last class) and "containers".
+ *
+ * @return RESULT_SUCCESS or DS_ERROR_OVERFLOW (see
+ *         metrics_format_prometheus()).
+ */
+Result metrics_format_json(char *buffer, usize capacity,
+                           const Container_Stats *const *containers,
+                           usize container_count, usize *length)
+{
+    DS_ASSERT(buffer != NULL || capacity == 0, "Buffer must not be NULL");
+    DS_ASSERT(containers != NULL || container_count == 0,
+              "Containers must not be NULL");
+    DS_ASSERT(length != NULL, "Length must not be NULL");
+
+    Metrics_Writer writer = {buffer, capacity, 0};
+
+    Memory_Stats memory = ds_get_memory_stats();
+    put(&writer, "{\"memory\":{");
+    for(usize i = 0; i < sizeof(memory_metrics) / sizeof(*memory_metrics);
+        i++)
+    {
+        const Memory_Metric *metric = &memory_metrics[i];
+        if(i)
+            put_char(&writer, ',');
+        put_json_key(&writer, metric->key);
+        put_u64(&writer,
+                *(const usize *)((const byte *)&memory + metric->offset));
+    }
+
+    Size_Class_Stats classes = ds_get_size_class_stats();
+    put(&writer, "},\"size_classes\":[");
+    for(usize i = 0; i < DS_SIZE_CLASS_COUNT; i++)
+    {
+        usize limit = ds_size_class_limit(i);
+        put(&writer, i ? ",{\"max_bytes\":" : "{\"max_bytes\":");
+        if(limit)
+            put_u64(&writer, limit);
+        else
+            put(&writer, "null");
+        put(&writer, ",\"allocations\":");
+        put_u64(&writer, classes.allocation_count[i]);
+        put(&writer, ",\"bytes\":");
+        put_u64(&writer, classes.allocated_bytes[i]);
+        put_char(&writer, '}');
+    }
+
+    put(&writer, "],\"containers\":[");
+    for(usize c = 0; c < container_count; c++)
+    {
+        if(c)
+            put_char(&writer, ',');
+        put_json_container(&writer, containers[c]);
+    }
+    put(&writer, "]}\n");
+
+    return finish(&writer, length);
+}
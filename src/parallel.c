@@ -0,0 +1,603 @@
+#include "../include/parallel.h"
+#include "../include/memory.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/**
+ * @brief Slots of each worker deque (a power of two).
+ *
+ * Fork-join code only keeps O(log n) tasks per worker in flight, so a
+ * fixed ring is plenty; a spawn that finds it full runs inline instead.
+ */
+#define DEQUE_CAPACITY 4096
+#define DEQUE_MASK (DEQUE_CAPACITY - 1)
+
+/**
+ * @brief Failed attempts to find work before a worker goes to sleep.
+ */
+#define IDLE_ROUNDS 64
+
+/**
+ * @brief Leaf pieces created per thread by ds_parallel_for().
+ *
+ * More pieces than threads let fast threads steal from slow ones; a small
+ * factor keeps the scheduling overhead negligible.
+ */
+#define PIECES_PER_THREAD 8
+
+/**
+ * @brief Upper bound on the number of times a range can be halved.
+ */
+#define MAX_SPLITS 64
+
+/**
+ * @brief One pool thread and its Chase-Lev deque.
+ *
+ * `top` is written by thieves and `bottom` by the owner, so they live on
+ * separate cache lines; the array of workers is itself cache-line aligned.
+ */
+typedef struct
+{
+        _Alignas(DS_CACHE_LINE_SIZE) isize top;
+        _Alignas(DS_CACHE_LINE_SIZE) isize bottom;
+        Task **buffer;
+        pthread_t thread;
+        bool started;
+} Worker;
+
+/**
+ * @brief The process-wide scheduler.
+ *
+ * `epoch` is bumped by every spawn; a worker only sleeps if it is unchanged
+ * since before its last (failed) search for work, so no wake-up is lost.
+ */
+typedef struct
+{
+        Worker *workers;
+        usize worker_count;
+        bool running;  // Pool started (possibly with no workers)
+        bool stopping; // Workers must exit
+
+        pthread_mutex_t injection_lock;
+        Task *injected_head; // Tasks spawned outside the pool
+        Task *injected_tail;
+        usize injected; // Queue length, readable without the lock
+
+        pthread_mutex_t sleep_lock;
+        pthread_cond_t wake;
+        u64 epoch;
+        usize sleepers;
+} Pool;
+
+/**
+ * @brief State shared by the pieces of one ds_parallel_for() call.
+ */
+typedef struct
+{
+        range_fn body;
+        ptr context;
+        usize leaf; // Ranges shorter than 2 * leaf are not split
+} Range_Loop;
+
+/**
+ * @brief A subrange handed to another thread.
+ */
+typedef struct
+{
+        const Range_Loop *loop;
+        usize begin;
+        usize end;
+} Range_Piece;
+
+/**
+ * @brief Configured thread count (0 means "number of online processors").
+ */
+static usize thread_count = 0;
+
+/**
+ * @brief Serializes starting and stopping the pool.
+ */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static Pool pool = {.injection_lock = PTHREAD_MUTEX_INITIALIZER,
+                    .sleep_lock = PTHREAD_MUTEX_INITIALIZER,
+                    .wake = PTHREAD_COND_INITIALIZER};
+
+/**
+ * @brief Worker run by the calling thread (NULL outside the pool).
+ */
+static _Thread_local Worker *current_worker = NULL;
+
+/**
+ * @brief Per-thread state of the victim selection generator.
+ */
+static _Thread_local u64 steal_seed = 0;
+
+/* ============================================================================
+ *  THREAD COUNT CONFIGURATION
+ * ============================================================================
+ */
+
+/**
+ * @brief Returns the number of threads parallel algorithms may use.
+ */
+usize ds_parallel_thread_count(void)
+{
+    usize count = __atomic_load_n(&thread_count, __ATOMIC_RELAXED);
+    if(count != 0)
+        return count;
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (usize)online : 1;
+}
+
+/**
+ * @brief Sets the number of threads parallel algorithms may use.
+ *
+ * A running pool of a different size is stopped and restarted lazily.
+ *
+ * @param count Thread count, or 0 to use the number of online processors.
+ */
+void ds_parallel_set_thread_count(usize count)
+{
+    usize previous = ds_parallel_thread_count();
+    __atomic_store_n(&thread_count, count, __ATOMIC_RELAXED);
+    if(ds_parallel_thread_count() != previous)
+        ds_parallel_shutdown();
+}
+
+/* ============================================================================
+ *  CHASE-LEV DEQUE
+ * ============================================================================
+ */
+
+/**
+ * @brief Pushes a task at the bottom of the owner's deque.
+ *
+ * @return false if the deque is full.
+ */
+static bool deque_push(Worker *worker, Task *task)
+{
+    isize bottom = __atomic_load_n(&worker->bottom, __ATOMIC_RELAXED);
+    isize top = __atomic_load_n(&worker->top, __ATOMIC_ACQUIRE);
+    if(bottom - top >= DEQUE_CAPACITY)
+        return false;
+
+    __atomic_store_n(&worker->buffer[bottom & DEQUE_MASK], task,
+                     __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/**
+ * @brief Pops the most recently pushed task (owner only).
+ *
+ * Only the last remaining task can be contended by a thief; that race is
+ * settled by a compare-and-swap on `top`.
+ */
+static Task *deque_pop(Worker *worker)
+{
+    isize bottom = __atomic_load_n(&worker->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&worker->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    isize top = __atomic_load_n(&worker->top, __ATOMIC_RELAXED);
+
+    if(top > bottom)
+    {
+        __atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    Task *task =
+        __atomic_load_n(&worker->buffer[bottom & DEQUE_MASK], __ATOMIC_RELAXED);
+    if(top == bottom)
+    {
+        if(!__atomic_compare_exchange_n(&worker->top, &top, top + 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            task = NULL;
+        __atomic_store_n(&worker->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+/**
+ * @brief Steals the oldest task of a deque (any thread).
+ *
+ * @return The task, or NULL if the deque is empty or another thread won.
+ */
+static Task *deque_steal(Worker *worker)
+{
+    isize top = __atomic_load_n(&worker->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    isize bottom = __atomic_load_n(&worker->bottom, __ATOMIC_ACQUIRE);
+    if(top >= bottom)
+        return NULL;
+
+    Task *task =
+        __atomic_load_n(&worker->buffer[top & DEQUE_MASK], __ATOMIC_ACQUIRE);
+    if(!__atomic_compare_exchange_n(&worker->top, &top, top + 1, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+    return task;
+}
+
+/* ============================================================================
+ *  SCHEDULING
+ * ============================================================================
+ */
+
+/**
+ * @brief Runs a task and signals its completion to the group.
+ */
+static void execute(Task *task)
+{
+    // The task may be reused as soon as the group is signaled.
+    Task_Group *group = task->group;
+    task->run(task->context);
+    __atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Appends a task spawned outside the pool to the injection queue.
+ */
+static void inject(Task *task)
+{
+    task->next = NULL;
+    pthread_mutex_lock(&pool.injection_lock);
+    if(pool.injected_tail)
+        pool.injected_tail->next = task;
+    else
+        pool.injected_head = task;
+    pool.injected_tail = task;
+    __atomic_add_fetch(&pool.injected, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&pool.injection_lock);
+}
+
+/**
+ * @brief Removes the oldest task of the injection queue, if any.
+ */
+static Task *take_injected(void)
+{
+    if(__atomic_load_n(&pool.injected, __ATOMIC_RELAXED) == 0)
+        return NULL;
+
+    pthread_mutex_lock(&pool.injection_lock);
+    Task *task = pool.injected_head;
+    if(task)
+    {
+        pool.injected_head = task->next;
+        if(!pool.injected_head)
+            pool.injected_tail = NULL;
+        __atomic_sub_fetch(&pool.injected, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&pool.injection_lock);
+    return task;
+}
+
+/**
+ * @brief Returns the next pseudo-random victim index (xorshift64).
+ */
+static usize next_victim(usize count)
+{
+    if(steal_seed == 0)
+        steal_seed = (u64)(usize)&steal_seed | 1;
+    steal_seed ^= steal_seed << 13;
+    steal_seed ^= steal_seed >> 7;
+    steal_seed ^= steal_seed << 17;
+    return (usize)(steal_seed % count);
+}
+
+/**
+ * @brief Looks for a task: own deque first, then injected tasks, then
+ *        the deques of the other workers starting from a random one.
+ */
+static Task *find_task(Worker *self)
+{
+    Task *task = self ? deque_pop(self) : NULL;
+    if(!task)
+        task = take_injected();
+
+    usize count = pool.worker_count;
+    if(task || count == 0)
+        return task;
+
+    usize first = next_victim(count);
+    for(usize i = 0; i < count && !task; i++)
+    {
+        Worker *victim = &pool.workers[(first + i) % count];
+        if(victim != self)
+            task = deque_steal(victim);
+    }
+    return task;
+}
+
+/**
+ * @brief Wakes one sleeping worker after new work was published.
+ */
+static void notify_workers(void)
+{
+    __atomic_add_fetch(&pool.epoch, 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&pool.sleepers, __ATOMIC_SEQ_CST) == 0)
+        return;
+
+    pthread_mutex_lock(&pool.sleep_lock);
+    pthread_cond_signal(&pool.wake);
+    pthread_mutex_unlock(&pool.sleep_lock);
+}
+
+/**
+ * @brief Blocks until work may have been published after `epoch` was read.
+ */
+static void wait_for_work(u64 epoch)
+{
+    pthread_mutex_lock(&pool.sleep_lock);
+    __atomic_add_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&pool.epoch, __ATOMIC_SEQ_CST) == epoch &&
+          !__atomic_load_n(&pool.stopping, __ATOMIC_ACQUIRE))
+        pthread_cond_wait(&pool.wake, &pool.sleep_lock);
+    __atomic_sub_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool.sleep_lock);
+}
+
+/**
+ * @brief Main loop of a pool thread.
+ */
+static void *worker_main(void *argument)
+{
+    Worker *self = (Worker *)argument;
+    current_worker = self;
+
+    usize idle = 0;
+    while(!__atomic_load_n(&pool.stopping, __ATOMIC_ACQUIRE))
+    {
+        // Read the epoch before the last search, see Pool.
+        u64 epoch = __atomic_load_n(&pool.epoch, __ATOMIC_SEQ_CST);
+        Task *task = find_task(self);
+        if(task)
+        {
+            execute(task);
+            idle = 0;
+        }
+        else if(++idle < IDLE_ROUNDS)
+            sched_yield();
+        else
+        {
+            wait_for_work(epoch);
+            idle = 0;
+        }
+    }
+
+    current_worker = NULL;
+    return NULL;
+}
+
+/**
+ * @brief Starts the pool if needed.
+ *
+ * @return Whether there is at least one worker thread to hand tasks to.
+ */
+static bool ensure_pool(void)
+{
+    if(__atomic_load_n(&pool.running, __ATOMIC_ACQUIRE))
+        return pool.worker_count != 0;
+
+    pthread_mutex_lock(&pool_lock);
+    if(!pool.running)
+    {
+        usize count = ds_parallel_thread_count() - 1;
+        Worker *workers = count ? ALLOC_ALIGNED(Worker, count) : NULL;
+        for(usize i = 0; workers && i < count; i++)
+        {
+            workers[i].buffer = ALLOC_ALIGNED(Task *, DEQUE_CAPACITY);
+            if(!workers[i].buffer)
+                count = i; // Run with the workers allocated so far
+        }
+
+        pool.workers = workers;
+        pool.worker_count = workers ? count : 0;
+        pool.stopping = false;
+        for(usize i = 0; i < pool.worker_count; i++)
+            workers[i].started = pthread_create(&workers[i].thread, NULL,
+                                                worker_main, &workers[i]) == 0;
+        __atomic_store_n(&pool.running, true, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return pool.worker_count != 0;
+}
+
+/**
+ * @brief Stops the worker threads and frees the pool.
+ *
+ * Called automatically when the thread count changes; also useful before
+ * checking for leaks at exit. The pool restarts on next use.
+ */
+void ds_parallel_shutdown(void)
+{
+    pthread_mutex_lock(&pool_lock);
+    if(pool.running)
+    {
+        pthread_mutex_lock(&pool.sleep_lock);
+        __atomic_store_n(&pool.stopping, true, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&pool.wake);
+        pthread_mutex_unlock(&pool.sleep_lock);
+
+        for(usize i = 0; i < pool.worker_count; i++)
+        {
+            if(pool.workers[i].started)
+                pthread_join(pool.workers[i].thread, NULL);
+            ds_free(pool.workers[i].buffer);
+        }
+        ds_free(pool.workers);
+
+        pool.workers = NULL;
+        pool.worker_count = 0;
+        pool.stopping = false;
+        __atomic_store_n(&pool.running, false, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/* ============================================================================
+ *  TASKS
+ * ============================================================================
+ */
+
+/**
+ * @brief Spawns `run(context)` as a task of `group`.
+ *
+ * Inside the pool the task goes to the bottom of the worker's deque;
+ * other threads use the injection queue. Without worker threads (thread
+ * count 1, or threads could not be created) the task runs immediately.
+ *
+ * @param group   Group to sync on; its counter is incremented.
+ * @param task    Caller-owned storage, valid until the group is synced.
+ * @param run     Task body.
+ * @param context Opaque pointer passed to `run`.
+ */
+void ds_task_spawn(Task_Group *group, Task *task, task_fn run, ptr context)
+{
+    task->run = run;
+    task->context = context;
+    task->group = group;
+    task->next = NULL;
+
+    Worker *self = current_worker;
+    if(!self && !ensure_pool())
+    {
+        run(context);
+        return;
+    }
+
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+    if(!self)
+        inject(task);
+    else if(!deque_push(self, task))
+    {
+        execute(task);
+        return;
+    }
+    notify_workers();
+}
+
+/**
+ * @brief Waits for every task of `group`, executing tasks meanwhile.
+ */
+void ds_task_sync(Task_Group *group)
+{
+    usize idle = 0;
+    while(__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) != 0)
+    {
+        Task *task = find_task(current_worker);
+        if(task)
+        {
+            execute(task);
+            idle = 0;
+        }
+        else if(++idle >= IDLE_ROUNDS)
+            sched_yield();
+    }
+}
+
+/* ============================================================================
+ *  PARALLEL LOOP
+ * ============================================================================
+ */
+
+static void split_range(const Range_Loop *loop, usize begin, usize end);
+
+/**
+ * @brief Task body processing a stolen subrange.
+ */
+static void run_range_piece(ptr context)
+{
+    Range_Piece *piece = (Range_Piece *)context;
+    split_range(piece->loop, piece->begin, piece->end);
+}
+
+/**
+ * @brief Processes [begin, end), offering its upper halves to other threads.
+ *
+ * Each iteration spawns the upper half of what is left, so the oldest task
+ * in the deque (the first to be stolen) is always the largest one.
+ */
+static void split_range(const Range_Loop *loop, usize begin, usize end)
+{
+    Task_Group group = TASK_GROUP_INIT;
+    Task tasks[MAX_SPLITS];
+    Range_Piece pieces[MAX_SPLITS];
+    usize spawned = 0;
+
+    while((end - begin) / 2 >= loop->leaf && spawned < MAX_SPLITS)
+    {
+        usize middle = begin + (end - begin) / 2;
+        pieces[spawned] = (Range_Piece){loop, middle, end};
+        ds_task_spawn(&group, &tasks[spawned], run_range_piece,
+                      &pieces[spawned]);
+        spawned++;
+        end = middle;
+    }
+
+    loop->body(begin, end, loop->context);
+    ds_task_sync(&group);
+}
+
+/**
+ * @brief Runs `body` over [begin, end) split into contiguous pieces.
+ *
+ * The range is split recursively into about PIECES_PER_THREAD pieces per
+ * thread, which the pool balances by stealing. The calling thread works
+ * on the range too and returns once every piece has completed.
+ *
+ * @param begin   First index.
+ * @param end     One past the last index.
+ * @param grain   Minimum piece size (0 is treated as 1).
+ * @param body    Callback invoked once per piece.
+ * @param context Opaque pointer passed to every invocation.
+ * @return RESULT_SUCCESS, or an error if the arguments are invalid.
+ */
+Result ds_parallel_for(usize begin, usize end, usize grain, range_fn body,
+                       ptr context)
+{
+    DS_ASSERT(body != NULL, "Loop body must not be NULL");
+    if(begin >= end)
+        return RESULT_SUCCESS;
+
+    usize length = end - begin;
+    if(grain == 0)
+        grain = 1;
+
+    usize threads = ds_parallel_thread_count();
+    if(threads == 1 || length / 2 < grain)
+    {
+        // Serial path: a single piece runs inline.
+        body(begin, end, context);
+        return RESULT_SUCCESS;
+    }
+
+    Range_Loop loop = {body, context, length / (threads * PIECES_PER_THREAD)};
+    if(loop.leaf < grain)
+        loop.leaf = grain;
+
+    split_range(&loop, begin, end);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Returns how many fixed blocks a multi-pass loop over `count`
+ *        elements should use.
+ *
+ * @param count Number of elements.
+ * @param grain Minimum elements per block (0 is treated as 1).
+ */
+usize ds_parallel_block_count(usize count, usize grain)
+{
+    if(grain == 0)
+        grain = 1;
+
+    usize blocks = ds_parallel_thread_count() * PIECES_PER_THREAD;
+    if(blocks > count / grain)
+        blocks = count / grain;
+    return blocks ? blocks : 1;
+}
@@ -0,0 +1,362 @@
+#include "../include/parallel_ops.h"
+
+/**
+ * @brief Shared state of the generic operations.
+ *
+ * Every pass works on fixed blocks (see ds_parallel_block_range()), so a
+ * block finds in later passes the per-block values computed earlier.
+ * `scratch` holds one element-sized slot per block (partial results,
+ * block offsets) and `swap` one more per block for the scan.
+ */
+typedef struct
+{
+        const byte *input;
+        byte *output;
+        usize count;
+        usize width;        // Input element size
+        usize output_width; // Output element size (map)
+        usize block_count;
+
+        map_fn map;
+        predicate_fn keep;
+        combine_fn combine;
+        cptr identity;
+
+        u8 *flags;     // Filter: keep() result of every element
+        usize *counts; // Filter: kept elements, then offset, of each block
+        byte *scratch;
+        byte *swap;
+} Bulk_Operation;
+
+/* ============================================================================
+ *  PASSES
+ * ============================================================================
+ */
+
+/**
+ * @brief Map: applies the callback to a range of elements.
+ */
+static void map_range(usize begin, usize end, ptr context)
+{
+    Bulk_Operation *op = (Bulk_Operation *)context;
+    for(usize i = begin; i < end; i++)
+        op->map(op->input + i * op->width, op->output + i * op->output_width);
+}
+
+/**
+ * @brief Filter pass 1: evaluates the predicate and counts kept elements.
+ */
+static void filter_count(usize begin, usize end, ptr context)
+{
+    Bulk_Operation *op = (Bulk_Operation *)context;
+    for(usize block = begin; block < end; block++)
+    {
+        usize first, last, kept = 0;
+        ds_parallel_block_range(op->count, op->block_count, block, &first,
+                                &last);
+        for(usize i = first; i < last; i++)
+        {
+            op->flags[i] = op->keep(op->input + i * op->width);
+            kept += op->flags[i];
+        }
+        op->counts[block] = kept;
+    }
+}
+
+/**
+ * @brief Filter pass 2: copies kept elements from the block's offset on.
+ */
+static void filter_copy(usize begin, usize end, ptr context)
+{
+    Bulk_Operation *op = (Bulk_Operation *)context;
+    for(usize block = begin; block < end; block++)
+    {
+        usize first, last;
+        byte *next = op->output + op->counts[block] * op->width;
+        ds_parallel_block_range(op->count, op->block_count, block, &first,
+                                &last);
+        for(usize i = first; i < last; i++)
+        {
+            if(!op->flags[i])
+                continue;
+            ds_memcpy(next, op->input + i * op->width, op->width);
+            next += op->width;
+        }
+    }
+}
+
+/**
+ * @brief Reduce / scan pass 1: folds each block into its scratch slot.
+ */
+static void fold_blocks(usize begin, usize end, ptr context)
+{
+    Bulk_Operation *op = (Bulk_Operation *)context;
+    for(usize block = begin; block < end; block++)
+    {
+        usize first, last;
+        byte *partial = op->scratch + block * op->width;
+        ds_parallel_block_range(op->count, op->block_count, block, &first,
+                                &last);
+        ds_memcpy(partial, op->identity, op->width);
+        for(usize i = first; i < last; i++)
+            op->combine(partial, op->input + i * op->width);
+    }
+}
+
+/**
+ * @brief Scan pass 2: rewrites each block as an exclusive scan starting
+ *        from the fold of the preceding blocks.
+ */
+static void scan_blocks(usize begin, usize end, ptr context)
+{
+    Bulk_Operation *op = (Bulk_Operation *)context;
+    for(usize block = begin; block < end; block++)
+    {
+        usize first, last;
+        byte *running = op->scratch + block * op->width;
+        byte *value = op->swap + block * op->width;
+        ds_parallel_block_range(op->count, op->block_count, block, &first,
+                                &last);
+        for(usize i = first; i < last; i++)
+        {
+            byte *element = op->output + i * op->width;
+            ds_memcpy(value, element, op->width);
+            ds_memcpy(element, running, op->width);
+            op->combine(running, value);
+        }
+    }
+}
+
+/* ============================================================================
+ *  GENERIC OPERATIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief Applies `map` to every element of `input`, in parallel.
+ *
+ * @param input  Source elements.
+ * @param output Destination; its element_size must be set. Resized to
+ *               input->size elements.
+ * @param map    Element transform.
+ */
+Result ds_parallel_map(const GenericData *input, GenericData *output,
+                       map_fn map)
+{
+    DS_ASSERT(input != NULL && output != NULL && map != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(input->element_size != 0 && output->element_size != 0,
+              "Element sizes must not be zero");
+
+    CHECK_RESULT(ds_array_reserve(&output->data, &output->capacity,
+                                  input->size, output->element_size));
+
+    Bulk_Operation op = {0};
+    op.input = (const byte *)input->data;
+    op.output = (byte *)output->data;
+    op.width = input->element_size;
+    op.output_width = output->element_size;
+    op.map = map;
+
+    output->size = input->size;
+    return ds_parallel_for(0, input->size, PARALLEL_OPS_GRAIN, map_range, &op);
+}
+
+/**
+ * @brief Copies the elements satisfying `keep` to `output`, in order.
+ *
+ * The predicate is evaluated once per element; its results are kept in a
+ * byte per element between the counting and the copying pass.
+ */
+Result ds_parallel_filter(const GenericData *input, GenericData *output,
+                          predicate_fn keep)
+{
+    DS_ASSERT(input != NULL && output != NULL && keep != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(input != output, "Filter cannot run in place");
+    DS_ASSERT(input->element_size != 0, "Element size must not be zero");
+
+    Bulk_Operation op = {0};
+    op.input = (const byte *)input->data;
+    op.count = input->size;
+    op.width = input->element_size;
+    op.keep = keep;
+    op.block_count = ds_parallel_block_count(op.count, PARALLEL_OPS_GRAIN);
+    op.flags = ALLOC_ARRAY(u8, op.count ? op.count : 1);
+    op.counts = ALLOC_ARRAY(usize, op.block_count);
+
+    Result result = RESULT_SUCCESS;
+    if(!op.flags || !op.counts)
+        result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                              "Failed to allocate filter scratch");
+    if(result_is_success(result))
+        result = ds_parallel_for(0, op.block_count, 1, filter_count, &op);
+
+    usize kept = 0;
+    for(usize block = 0; result_is_success(result) && block < op.block_count;
+        block++)
+    {
+        usize count = op.counts[block];
+        op.counts[block] = kept;
+        kept += count;
+    }
+
+    // The output takes the input's element size: recount its capacity in
+    // elements of that size before growing it.
+    if(result_is_success(result) && output->element_size != op.width)
+    {
+        output->capacity = output->element_size
+                               ? output->capacity * output->element_size /
+                                     op.width
+                               : 0;
+        output->element_size = op.width;
+        output->size = 0;
+    }
+    if(result_is_success(result))
+        result = ds_array_reserve(&output->data, &output->capacity, kept,
+                                  op.width);
+    if(result_is_success(result))
+    {
+        output->size = kept;
+        op.output = (byte *)output->data;
+        result = ds_parallel_for(0, op.block_count, 1, filter_copy, &op);
+    }
+
+    ds_free(op.flags);
+    ds_free(op.counts);
+    return result;
+}
+
+/**
+ * @brief Folds all elements of `input` into `result`.
+ *
+ * @param identity Element-sized neutral value of the operation.
+ * @param combine  Associative operation.
+ * @param result   Element-sized output.
+ */
+Result ds_parallel_reduce(const GenericData *input, cptr identity,
+                          combine_fn combine, ptr result)
+{
+    DS_ASSERT(input != NULL && identity != NULL && combine != NULL &&
+                  result != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(input->element_size != 0, "Element size must not be zero");
+
+    Bulk_Operation op = {0};
+    op.input = (const byte *)input->data;
+    op.count = input->size;
+    op.width = input->element_size;
+    op.combine = combine;
+    op.identity = identity;
+    op.block_count = ds_parallel_block_count(op.count, PARALLEL_OPS_GRAIN);
+    op.scratch = (byte *)ds_alloc_array(op.block_count, op.width);
+    if(!op.scratch)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate reduce partials");
+
+    Result status = ds_parallel_for(0, op.block_count, 1, fold_blocks, &op);
+    if(result_is_success(status))
+    {
+        ds_memcpy(result, identity, op.width);
+        for(usize block = 0; block < op.block_count; block++)
+            combine(result, op.scratch + block * op.width);
+    }
+
+    ds_free(op.scratch);
+    return status;
+}
+
+/**
+ * @brief Exclusive prefix sum of `data` in place under `combine`.
+ *
+ * @param identity Element-sized neutral value (first output element).
+ * @param combine  Associative operation.
+ * @param total    Receives the fold of all elements (may be NULL).
+ */
+Result ds_parallel_prefix_sum(GenericData *data, cptr identity,
+                              combine_fn combine, ptr total)
+{
+    DS_ASSERT(data != NULL && identity != NULL && combine != NULL,
+              "Arguments must not be NULL");
+    DS_ASSERT(data->element_size != 0, "Element size must not be zero");
+
+    Bulk_Operation op = {0};
+    op.input = (const byte *)data->data;
+    op.output = (byte *)data->data;
+    op.count = data->size;
+    op.width = data->element_size;
+    op.combine = combine;
+    op.identity = identity;
+    op.block_count = ds_parallel_block_count(op.count, PARALLEL_OPS_GRAIN);
+
+    // Per-block sums, per-block swap slots, then the running fold and one
+    // temporary for the serial scan of the block sums.
+    op.scratch = (byte *)ds_alloc_array(2 * op.block_count + 2, op.width);
+    if(!op.scratch)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate scan scratch");
+    op.swap = op.scratch + op.block_count * op.width;
+    byte *running = op.swap + op.block_count * op.width;
+    byte *sum = running + op.width;
+
+    Result result = ds_parallel_for(0, op.block_count, 1, fold_blocks, &op);
+    if(result_is_success(result))
+    {
+        ds_memcpy(running, identity, op.width);
+        for(usize block = 0; block < op.block_count; block++)
+        {
+            byte *slot = op.scratch + block * op.width;
+            ds_memcpy(sum, slot, op.width);
+            ds_memcpy(slot, running, op.width);
+            combine(running, sum);
+        }
+        result = ds_parallel_for(0, op.block_count, 1, scan_blocks, &op);
+    }
+    if(result_is_success(result) && total)
+        ds_memcpy(total, running, op.width);
+
+    ds_free(op.scratch);
+    return result;
+}
+
+/* ============================================================================
+ *  TYPED OPERATIONS
+ * ============================================================================
+ */
+
+DEFINE_PARALLEL_SCAN(scan_u32, u32, 0, a + b)
+DEFINE_PARALLEL_SCAN(scan_u64, u64, 0, a + b)
+DEFINE_PARALLEL_REDUCE(sum_u64, u64, 0, a + b)
+DEFINE_PARALLEL_REDUCE(sum_f64, f64, 0.0, a + b)
+
+/**
+ * @brief Exclusive prefix sum of a u32Array in place.
+ */
+Result ds_prefix_sum_u32(u32Array *array, u32 *total)
+{
+    return scan_u32(array, total);
+}
+
+/**
+ * @brief Exclusive prefix sum of a u64Array in place.
+ */
+Result ds_prefix_sum_u64(u64Array *array, u64 *total)
+{
+    return scan_u64(array, total);
+}
+
+/**
+ * @brief Sum of a u64Array.
+ */
+Result ds_sum_u64(const u64Array *array, u64 *result)
+{
+    return sum_u64(array, result);
+}
+
+/**
+ * @brief Sum of an f64Array (summed block by block, in index order).
+ */
+Result ds_sum_f64(const f64Array *array, f64 *result)
+{
+    return sum_f64(array, result);
+}
@@ -0,0 +1,464 @@
+#include "../include/reclaim.h"
+#include "../include/memory.h"
+#include <stdlib.h>
+
+/**
+ * @brief Number of epoch batches kept per thread (epochs e, e-1, e-2).
+ */
+#define EPOCH_BATCHES 3
+
+/**
+ * @brief A retired node waiting to be released.
+ */
+typedef struct
+{
+        ptr pointer;
+        usize size;
+        destroy_fn destroy;
+} Retired_Node;
+
+DECLARE_TYPE(Retired_Node);
+
+/**
+ * @brief Nodes retired by one thread during one epoch.
+ */
+typedef struct
+{
+        Retired_NodeArray nodes;
+        u64 epoch;
+} Retired_Batch;
+
+/**
+ * @brief Per-thread EBR state.
+ *
+ * `state` is read by every thread trying to advance the epoch, so it gets
+ * its own cache line; the rest is private to the owner.
+ */
+struct Epoch_Record
+{
+        _Alignas(DS_CACHE_LINE_SIZE) u64 state; // (epoch << 1) | active
+        _Alignas(DS_CACHE_LINE_SIZE) Epoch_Domain *domain;
+        Epoch_Record *next; // Immutable once published
+        bool in_use;
+        u32 nesting;
+        usize retired; // Retirements since the last collection
+        Retired_Batch batches[EPOCH_BATCHES];
+};
+
+/**
+ * @brief Per-thread HP state: published slots and private retired list.
+ */
+struct Hazard_Record
+{
+        _Alignas(DS_CACHE_LINE_SIZE) ptr slots[HAZARD_SLOTS];
+        _Alignas(DS_CACHE_LINE_SIZE) Hazard_Domain *domain;
+        Hazard_Record *next; // Immutable once published
+        bool in_use;
+        Retired_NodeArray retired;
+};
+
+/* ============================================================================
+ *  RETIRED NODES
+ * ============================================================================
+ */
+
+/**
+ * @brief Appends a node to a retired list and accounts for it.
+ */
+static Result push_retired(Retired_NodeArray *list, ptr pointer, usize size,
+                           destroy_fn destroy)
+{
+    CHECK_RESULT(ARRAY_RESERVE(list, list->size + 1));
+    list->data[list->size++] = (Retired_Node){pointer, size, destroy};
+    ds_adjust_pending_reclaim((isize)size);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Releases one retired node.
+ */
+static void release_node(const Retired_Node *node)
+{
+    if(node->destroy)
+        node->destroy(node->pointer);
+    else
+        ds_free(node->pointer);
+    ds_adjust_pending_reclaim(-(isize)node->size);
+}
+
+/**
+ * @brief Releases every node of a list and empties it (keeping storage).
+ */
+static void release_all(Retired_NodeArray *list)
+{
+    for(usize i = 0; i < list->size; i++)
+        release_node(&list->data[i]);
+    list->size = 0;
+}
+
+/* ============================================================================
+ *  EPOCH-BASED RECLAMATION
+ * ============================================================================
+ */
+
+/**
+ * @brief Initializes an empty domain at epoch 0.
+ */
+Result epoch_domain_create(Epoch_Domain *domain)
+{
+    DS_ASSERT(domain != NULL, "Domain must not be NULL");
+    *domain = (Epoch_Domain){0};
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Releases every pending node and all records.
+ */
+void epoch_domain_destroy(Epoch_Domain *domain)
+{
+    if(!domain)
+        return;
+
+    Epoch_Record *record = domain->records;
+    while(record)
+    {
+        Epoch_Record *next = record->next;
+        for(usize i = 0; i < EPOCH_BATCHES; i++)
+        {
+            release_all(&record->batches[i].nodes);
+            ds_free(record->batches[i].nodes.data);
+        }
+        ds_free(record);
+        record = next;
+    }
+    *domain = (Epoch_Domain){0};
+}
+
+/**
+ * @brief Claims a free record of the domain, allocating one if needed.
+ */
+Result epoch_register(Epoch_Domain *domain, Epoch_Record **record)
+{
+    DS_ASSERT(domain != NULL && record != NULL, "Arguments must not be NULL");
+
+    Epoch_Record *head = __atomic_load_n(&domain->records, __ATOMIC_ACQUIRE);
+    for(Epoch_Record *it = head; it; it = it->next)
+    {
+        bool expected = false;
+        if(!__atomic_load_n(&it->in_use, __ATOMIC_RELAXED) &&
+           __atomic_compare_exchange_n(&it->in_use, &expected, true, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            *record = it;
+            return RESULT_SUCCESS;
+        }
+    }
+
+    Epoch_Record *fresh = ALLOC_ALIGNED(Epoch_Record, 1);
+    if(!fresh)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate epoch record");
+    fresh->domain = domain;
+    fresh->in_use = true;
+
+    do
+        fresh->next = head;
+    while(!__atomic_compare_exchange_n(&domain->records, &head, fresh, true,
+                                       __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    *record = fresh;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Releases a record for reuse by another thread.
+ *
+ * Nodes that are not safe to free yet stay with the record and are
+ * released by its next owner or by epoch_domain_destroy().
+ */
+void epoch_unregister(Epoch_Record *record)
+{
+    if(!record)
+        return;
+
+    record->nesting = 0;
+    __atomic_store_n(&record->state, 0, __ATOMIC_RELEASE);
+    epoch_collect(record);
+    __atomic_store_n(&record->in_use, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Enters a read-side critical section.
+ */
+void epoch_enter(Epoch_Record *record)
+{
+    if(record->nesting++ != 0)
+        return;
+
+    u64 epoch = __atomic_load_n(&record->domain->epoch, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->state, (epoch << 1) | 1, __ATOMIC_RELAXED);
+    // The announcement must be visible before any node is read.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Leaves a read-side critical section.
+ */
+void epoch_exit(Epoch_Record *record)
+{
+    if(--record->nesting == 0)
+        __atomic_store_n(&record->state, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Advances the global epoch if every active thread has seen it.
+ */
+static void try_advance(Epoch_Domain *domain)
+{
+    u64 epoch = __atomic_load_n(&domain->epoch, __ATOMIC_SEQ_CST);
+    Epoch_Record *it = __atomic_load_n(&domain->records, __ATOMIC_ACQUIRE);
+    for(; it; it = it->next)
+    {
+        u64 state = __atomic_load_n(&it->state, __ATOMIC_SEQ_CST);
+        if((state & 1) && (state >> 1) != epoch)
+            return;
+    }
+    __atomic_compare_exchange_n(&domain->epoch, &epoch, epoch + 1, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Frees the calling thread's batches retired two epochs ago or
+ *        earlier, after trying to advance the epoch.
+ */
+void epoch_collect(Epoch_Record *record)
+{
+    if(!record)
+        return;
+
+    try_advance(record->domain);
+    u64 epoch = __atomic_load_n(&record->domain->epoch, __ATOMIC_ACQUIRE);
+    for(usize i = 0; i < EPOCH_BATCHES; i++)
+    {
+        Retired_Batch *batch = &record->batches[i];
+        if(batch->nodes.size && batch->epoch + 2 <= epoch)
+            release_all(&batch->nodes);
+    }
+    record->retired = 0;
+}
+
+/**
+ * @brief Retires a node unlinked from a container.
+ */
+Result epoch_retire(Epoch_Record *record, ptr pointer, usize size,
+                    destroy_fn destroy)
+{
+    DS_ASSERT(record != NULL, "Record must not be NULL");
+    if(!pointer)
+        return RESULT_SUCCESS;
+
+    u64 epoch = __atomic_load_n(&record->domain->epoch, __ATOMIC_SEQ_CST);
+    Retired_Batch *batch = &record->batches[epoch % EPOCH_BATCHES];
+    if(batch->epoch != epoch)
+    {
+        // The slot last held epoch - 3 or older: already safe.
+        release_all(&batch->nodes);
+        batch->epoch = epoch;
+    }
+
+    CHECK_RESULT(push_retired(&batch->nodes, pointer, size, destroy));
+    if(++record->retired >= EPOCH_COLLECT_INTERVAL)
+        epoch_collect(record);
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  HAZARD POINTERS
+ * ============================================================================
+ */
+
+/**
+ * @brief Three-way comparison of pointers for qsort() and bsearch().
+ */
+static int compare_pointers(cptr a, cptr b)
+{
+    usize x = (usize)(*(const ptr *)a);
+    usize y = (usize)(*(const ptr *)b);
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Initializes an empty hazard pointer domain.
+ */
+Result hazard_domain_create(Hazard_Domain *domain)
+{
+    DS_ASSERT(domain != NULL, "Domain must not be NULL");
+    *domain = (Hazard_Domain){0};
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Releases every pending node and all records.
+ */
+void hazard_domain_destroy(Hazard_Domain *domain)
+{
+    if(!domain)
+        return;
+
+    Hazard_Record *record = domain->records;
+    while(record)
+    {
+        Hazard_Record *next = record->next;
+        release_all(&record->retired);
+        ds_free(record->retired.data);
+        ds_free(record);
+        record = next;
+    }
+    *domain = (Hazard_Domain){0};
+}
+
+/**
+ * @brief Claims a free record of the domain, allocating one if needed.
+ */
+Result hazard_register(Hazard_Domain *domain, Hazard_Record **record)
+{
+    DS_ASSERT(domain != NULL && record != NULL, "Arguments must not be NULL");
+
+    Hazard_Record *head = __atomic_load_n(&domain->records, __ATOMIC_ACQUIRE);
+    for(Hazard_Record *it = head; it; it = it->next)
+    {
+        bool expected = false;
+        if(!__atomic_load_n(&it->in_use, __ATOMIC_RELAXED) &&
+           __atomic_compare_exchange_n(&it->in_use, &expected, true, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            *record = it;
+            return RESULT_SUCCESS;
+        }
+    }
+
+    Hazard_Record *fresh = ALLOC_ALIGNED(Hazard_Record, 1);
+    if(!fresh)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate hazard record");
+    fresh->domain = domain;
+    fresh->in_use = true;
+
+    do
+        fresh->next = head;
+    while(!__atomic_compare_exchange_n(&domain->records, &head, fresh, true,
+                                       __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    __atomic_add_fetch(&domain->record_count, 1, __ATOMIC_RELAXED);
+    *record = fresh;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Clears the record's slots and releases it for reuse.
+ *
+ * Nodes still protected by other threads stay with the record.
+ */
+void hazard_unregister(Hazard_Record *record)
+{
+    if(!record)
+        return;
+
+    for(usize i = 0; i < HAZARD_SLOTS; i++)
+        hazard_clear(record, i);
+    hazard_collect(record);
+    __atomic_store_n(&record->in_use, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publishes the pointer stored at `source` in `slot`.
+ *
+ * The pointer is re-read after publication: if it changed, it may have
+ * been retired before the hazard became visible, so the loop retries.
+ */
+ptr hazard_protect(Hazard_Record *record, usize slot, ptr const *source)
+{
+    ptr value = __atomic_load_n(source, __ATOMIC_ACQUIRE);
+    for(;;)
+    {
+        __atomic_store_n(&record->slots[slot], value, __ATOMIC_SEQ_CST);
+        ptr current = __atomic_load_n(source, __ATOMIC_SEQ_CST);
+        if(current == value)
+            return value;
+        value = current;
+    }
+}
+
+/**
+ * @brief Withdraws the protection published in `slot`.
+ */
+void hazard_clear(Hazard_Record *record, usize slot)
+{
+    __atomic_store_n(&record->slots[slot], NULL, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Frees every retired node of `record` not published in any slot.
+ */
+void hazard_collect(Hazard_Record *record)
+{
+    if(!record || record->retired.size == 0)
+        return;
+
+    // Records registered after this snapshot cannot protect nodes that
+    // were unlinked before it, so the snapshot's records are enough.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    Hazard_Record *head =
+        __atomic_load_n(&record->domain->records, __ATOMIC_ACQUIRE);
+    usize capacity = 0;
+    for(Hazard_Record *it = head; it; it = it->next)
+        capacity += HAZARD_SLOTS;
+
+    ptr *hazards = ALLOC_ARRAY(ptr, capacity);
+    if(!hazards)
+        return; // Retry on the next retirement
+
+    usize count = 0;
+    for(Hazard_Record *it = head; it; it = it->next)
+        for(usize i = 0; i < HAZARD_SLOTS; i++)
+        {
+            ptr hazard = __atomic_load_n(&it->slots[i], __ATOMIC_SEQ_CST);
+            if(hazard)
+                hazards[count++] = hazard;
+        }
+    qsort(hazards, count, sizeof(ptr), compare_pointers);
+
+    // Release unprotected nodes, compacting the protected ones in place.
+    usize kept = 0;
+    for(usize i = 0; i < record->retired.size; i++)
+    {
+        Retired_Node *node = &record->retired.data[i];
+        if(bsearch(&node->pointer, hazards, count, sizeof(ptr),
+                   compare_pointers))
+            record->retired.data[kept++] = *node;
+        else
+            release_node(node);
+    }
+    record->retired.size = kept;
+    ds_free(hazards);
+}
+
+/**
+ * @brief Retires a node unlinked from a container.
+ */
+Result hazard_retire(Hazard_Record *record, ptr pointer, usize size,
+                     destroy_fn destroy)
+{
+    DS_ASSERT(record != NULL, "Record must not be NULL");
+    if(!pointer)
+        return RESULT_SUCCESS;
+
+    CHECK_RESULT(push_retired(&record->retired, pointer, size, destroy));
+
+    usize threshold =
+        2 * HAZARD_SLOTS *
+        __atomic_load_n(&record->domain->record_count, __ATOMIC_RELAXED);
+    if(threshold < HAZARD_SCAN_THRESHOLD)
+        threshold = HAZARD_SCAN_THRESHOLD;
+    if(record->retired.size >= threshold)
+        hazard_collect(record);
+    return RESULT_SUCCESS;
+}
@@ -0,0 +1,508 @@
+#include "../include/snapshot.h"
+#include "../include/memory.h"
+#include "../include/trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief A section to be written: its elements in memory.
+ */
+typedef struct
+{
+        cptr data;
+        u64 count;
+        u64 element_size;
+} Section_Source;
+
+/**
+ * @brief Rounds a file offset up to the section alignment.
+ */
+static u64 align_offset(u64 offset)
+{
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(u64)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Number of checksummed blocks of a section.
+ */
+static u64 section_blocks(u64 bytes, u64 block_size)
+{
+    return bytes / block_size + (bytes % block_size != 0);
+}
+
+/**
+ * @brief CRC32C protecting the header, section table and block checksums.
+ */
+static u32 header_checksum(const Snapshot_Header *header,
+                           const Snapshot_Section *sections,
+                           const u64 *checksums, usize block_count)
+{
+    Snapshot_Header copy = *header;
+    copy.header_checksum = 0;
+    u32 crc = ds_crc32c(0, &copy, sizeof(copy));
+    crc = ds_crc32c(crc, sections,
+                    header->section_count * sizeof(Snapshot_Section));
+    return ds_crc32c(crc, checksums, block_count * sizeof(u64));
+}
+
+/* ============================================================================
+ *  WRITING
+ * ============================================================================
+ */
+
+/**
+ * @brief Writes a whole buffer, retrying short and interrupted writes.
+ */
+static Result write_all(int fd, const byte *data, usize size)
+{
+    while(size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written <= 0)
+            return RESULT_ERROR(DS_ERROR_IO, "Failed to write snapshot");
+        data += written;
+        size -= (usize)written;
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Writes zero bytes up to the next aligned offset.
+ */
+static Result write_padding(int fd, u64 *offset)
+{
+    static const byte zeros[SNAPSHOT_ALIGNMENT] = {0};
+    u64 aligned = align_offset(*offset);
+    Result result = write_all(fd, zeros, (usize)(aligned - *offset));
+    *offset = aligned;
+    return result;
+}
+
+/**
+ * @brief Checksums the blocks of every section, in section order.
+ */
+static Result checksum_sections(const Section_Source *sources, u32 count,
+                                 Checksum_Kind kind, u64Array *checksums)
+{
+    u64Array blocks = {0};
+    Result result = RESULT_SUCCESS;
+    for(u32 i = 0; result_is_success(result) && i < count; i++)
+    {
+        usize bytes = (usize)(sources[i].count * sources[i].element_size);
+        byteArray data = {(byte *)sources[i].data, bytes, bytes};
+        result = ds_checksum_blocks(&data, SNAPSHOT_BLOCK_SIZE, kind, &blocks);
+        if(result_is_success(result))
+            result = ARRAY_RESERVE(checksums, checksums->size + blocks.size);
+        if(result_is_success(result) && blocks.size > 0)
+        {
+            ds_memcpy(checksums->data + checksums->size, blocks.data,
+                      blocks.size * sizeof(u64));
+            checksums->size += blocks.size;
+        }
+    }
+    ds_free(blocks.data);
+    return result;
+}
+
+/**
+ * @brief Writes the header, sections, data and block checksums.
+ */
+static Result write_file(int fd, const Snapshot_Header *header,
+                         const Snapshot_Section *sections,
+                         const Section_Source *sources,
+                         const u64Array *checksums)
+{
+    u32 count = header->section_count;
+    CHECK_RESULT(write_all(fd, (const byte *)header, sizeof(*header)));
+    CHECK_RESULT(write_all(fd, (const byte *)sections,
+                           count * sizeof(Snapshot_Section)));
+
+    u64 offset = sizeof(Snapshot_Header) + count * sizeof(Snapshot_Section);
+    for(u32 i = 0; i < count; i++)
+    {
+        usize bytes = (usize)(sources[i].count * sources[i].element_size);
+        CHECK_RESULT(write_padding(fd, &offset));
+        if(bytes > 0)
+            CHECK_RESULT(write_all(fd, (const byte *)sources[i].data, bytes));
+        offset += bytes;
+    }
+
+    CHECK_RESULT(write_padding(fd, &offset));
+    return write_all(fd, (const byte *)checksums->data,
+                     checksums->size * sizeof(u64));
+}
+
+/**
+ * @brief Writes a snapshot made of the given sections.
+ */
+static Result write_snapshot(const char *path, Snapshot_Kind kind,
+                             const Section_Source *sources, u32 count)
+{
+    u64 span = trace_begin();
+    Snapshot_Header header = {0};
+    Snapshot_Section sections[SNAPSHOT_MAX_SECTIONS] = {{0}};
+
+    u64 offset = sizeof(Snapshot_Header) + count * sizeof(Snapshot_Section);
+    for(u32 i = 0; i < count; i++)
+    {
+        offset = align_offset(offset);
+        sections[i].offset = offset;
+        sections[i].count = sources[i].count;
+        sections[i].element_size = sources[i].element_size;
+        offset += sources[i].count * sources[i].element_size;
+    }
+
+    // The hardware CRC is the fastest choice; without it xxHash64 is.
+    Checksum_Kind checksum_kind =
+        ds_crc32c_hardware() ? CHECKSUM_CRC32C : CHECKSUM_XXH64;
+    u64Array checksums = {0};
+    Result result =
+        checksum_sections(sources, count, checksum_kind, &checksums);
+
+    int fd = -1;
+    if(result_is_success(result))
+    {
+        header.magic = SNAPSHOT_MAGIC;
+        header.version = SNAPSHOT_VERSION;
+        header.byte_order = SNAPSHOT_BYTE_ORDER;
+        header.kind = (u32)kind;
+        header.section_count = count;
+        header.block_size = SNAPSHOT_BLOCK_SIZE;
+        header.checksum_offset = align_offset(offset);
+        header.checksum_kind = (u32)checksum_kind;
+        header.file_size =
+            header.checksum_offset + checksums.size * sizeof(u64);
+        header.header_checksum =
+            header_checksum(&header, sections, checksums.data, checksums.size);
+
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0)
+            result =
+                RESULT_ERROR(DS_ERROR_IO, "Failed to create snapshot file");
+    }
+    if(result_is_success(result))
+        result = write_file(fd, &header, sections, sources, &checksums);
+    if(fd >= 0 && close(fd) != 0 && result_is_success(result))
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to close snapshot file");
+
+    ds_free(checksums.data);
+    trace_end("snapshot_write", span, header.file_size);
+    return result;
+}
+
+/**
+ * @brief Saves a GenericData container.
+ */
+Result snapshot_save_generic(const char *path, const GenericData *data)
+{
+    DS_ASSERT(path != NULL && data != NULL, "Arguments must not be NULL");
+    DS_ASSERT(data->element_size != 0, "Element size must not be zero");
+
+    Section_Source source = {data->data, data->size, data->element_size};
+    return write_snapshot(path, SNAPSHOT_GENERIC, &source, 1);
+}
+
+/**
+ * @brief Saves a CSR graph as its offsets, neighbors and weights.
+ */
+Result snapshot_save_csr_graph(const char *path, const CSR_Graph *graph)
+{
+    DS_ASSERT(path != NULL && graph != NULL, "Arguments must not be NULL");
+    DS_ASSERT(graph->offsets.size == (usize)graph->vertex_count + 1,
+              "Graph offsets do not match its vertex count");
+
+    Section_Source sources[3] = {
+        {graph->offsets.data, graph->offsets.size, sizeof(u64)},
+        {graph->neighbors.data, graph->edge_count, sizeof(u32)},
+        {graph->weights.data, graph->weights.size, sizeof(f64)}};
+    return write_snapshot(path, SNAPSHOT_CSR_GRAPH, sources, 3);
+}
+
+/* ============================================================================
+ *  LOADING
+ * ============================================================================
+ */
+
+/**
+ * @brief Checks that a header, its section table and its checksum table
+ *        describe the mapping.
+ */
+static bool snapshot_is_valid(const byte *base, usize size)
+{
+    if(size < sizeof(Snapshot_Header))
+        return false;
+
+    const Snapshot_Header *header = (const Snapshot_Header *)base;
+    if(header->magic != SNAPSHOT_MAGIC ||
+       header->version != SNAPSHOT_VERSION ||
+       header->byte_order != SNAPSHOT_BYTE_ORDER ||
+       header->file_size != size ||
+       header->section_count > SNAPSHOT_MAX_SECTIONS ||
+       header->block_size == 0 ||
+       header->checksum_offset % SNAPSHOT_ALIGNMENT != 0 ||
+       header->checksum_offset > size ||
+       (header->checksum_kind != CHECKSUM_CRC32C &&
+        header->checksum_kind != CHECKSUM_XXH64))
+        return false;
+
+    u64 table_end = sizeof(Snapshot_Header) +
+                    header->section_count * sizeof(Snapshot_Section);
+    if(table_end > size)
+        return false;
+
+    u64 data_end = header->checksum_offset;
+    u64 block_count = 0;
+    const Snapshot_Section *sections =
+        (const Snapshot_Section *)(base + sizeof(Snapshot_Header));
+    for(u32 i = 0; i < header->section_count; i++)
+    {
+        const Snapshot_Section *section = &sections[i];
+        if(section->element_size == 0 ||
+           section->offset % SNAPSHOT_ALIGNMENT != 0 ||
+           section->offset < table_end || section->offset > data_end ||
+           section->count >
+               (data_end - section->offset) / section->element_size)
+            return false;
+        block_count += section_blocks(section->count * section->element_size,
+                                      header->block_size);
+    }
+
+    if(block_count != (size - header->checksum_offset) / sizeof(u64) ||
+       (size - header->checksum_offset) % sizeof(u64) != 0)
+        return false;
+
+    const u64 *checksums = (const u64 *)(base + header->checksum_offset);
+    return header->header_checksum ==
+           header_checksum(header, sections, checksums, (usize)block_count);
+}
+
+/**
+ * @brief Maps a snapshot file read-only and validates it.
+ *
+ * @param flags SNAPSHOT_TRUSTED skips the block checksums.
+ */
+Result snapshot_open(Snapshot *snapshot, const char *path, u32 flags)
+{
+    DS_ASSERT(snapshot != NULL && path != NULL, "Arguments must not be NULL");
+    *snapshot = (Snapshot){0};
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to open snapshot file");
+
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to stat snapshot file");
+    }
+    if((usize)info.st_size < sizeof(Snapshot_Header))
+    {
+        close(fd);
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Snapshot file is truncated");
+    }
+
+    usize size = (usize)info.st_size;
+    ptr base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file referenced
+    if(base == MAP_FAILED)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to map snapshot file");
+
+    if(!snapshot_is_valid((const byte *)base, size))
+    {
+        munmap(base, size);
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Snapshot header is invalid");
+    }
+
+    snapshot->base = (const byte *)base;
+    snapshot->size = size;
+    if(flags & SNAPSHOT_TRUSTED)
+        return RESULT_SUCCESS;
+
+    u64 corrupt_offset = 0;
+    Result result = snapshot_verify(snapshot, &corrupt_offset);
+    if(result_is_error(result))
+    {
+        snapshot_close(snapshot);
+        snapshot->corrupt_offset = corrupt_offset;
+    }
+    return result;
+}
+
+/**
+ * @brief Verifies the block checksums of every section, in parallel.
+ */
+Result snapshot_verify(const Snapshot *snapshot, u64 *corrupt_offset)
+{
+    DS_ASSERT(snapshot != NULL && snapshot->base != NULL,
+              "Snapshot must be open");
+
+    const Snapshot_Header *header = (const Snapshot_Header *)snapshot->base;
+    const Snapshot_Section *sections =
+        (const Snapshot_Section *)(snapshot->base + sizeof(Snapshot_Header));
+    u64 *checksums = (u64 *)(snapshot->base + header->checksum_offset);
+
+    for(u32 i = 0; i < header->section_count; i++)
+    {
+        usize bytes = (usize)(sections[i].count * sections[i].element_size);
+        usize blocks = (usize)section_blocks(bytes, header->block_size);
+        byteArray data = {(byte *)(snapshot->base + sections[i].offset), bytes,
+                          bytes};
+        u64Array expected = {checksums, blocks, blocks};
+        usize bad_block = 0;
+
+        Result result = ds_verify_blocks(&data, (usize)header->block_size,
+                                         (Checksum_Kind)header->checksum_kind,
+                                         &expected, &bad_block);
+        if(result_is_error(result))
+        {
+            if(corrupt_offset)
+                *corrupt_offset =
+                    sections[i].offset + bad_block * header->block_size;
+            return result;
+        }
+        checksums += blocks;
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Unmaps a snapshot; every view of it becomes invalid.
+ */
+void snapshot_close(Snapshot *snapshot)
+{
+    if(!snapshot || !snapshot->base)
+        return;
+
+    munmap((ptr)snapshot->base, snapshot->size);
+    *snapshot = (Snapshot){0};
+}
+
+/**
+ * @brief Kind of container stored in an open snapshot.
+ */
+Snapshot_Kind snapshot_kind(const Snapshot *snapshot)
+{
+    return (Snapshot_Kind)((const Snapshot_Header *)snapshot->base)->kind;
+}
+
+/**
+ * @brief Locates a section of an open snapshot.
+ *
+ * @param element_size Expected element size, or 0 to accept any.
+ */
+static Result find_section(const Snapshot *snapshot, Snapshot_Kind kind,
+                           u32 index, u64 element_size, ptr *data,
+                           usize *count)
+{
+    DS_ASSERT(snapshot != NULL && snapshot->base != NULL,
+              "Snapshot must be open");
+
+    const Snapshot_Header *header = (const Snapshot_Header *)snapshot->base;
+    const Snapshot_Section *section =
+        (const Snapshot_Section *)(snapshot->base + sizeof(Snapshot_Header)) +
+        index;
+    if(header->kind != (u32)kind || index >= header->section_count ||
+       (element_size != 0 && section->element_size != element_size))
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Snapshot does not hold this container");
+
+    *data = (ptr)(snapshot->base + section->offset);
+    *count = (usize)section->count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Views a snapshot of a GenericData container.
+ */
+Result snapshot_view_generic(const Snapshot *snapshot, GenericData *view)
+{
+    DS_ASSERT(view != NULL, "View must not be NULL");
+
+    ptr data = NULL;
+    usize count = 0;
+    CHECK_RESULT(find_section(snapshot, SNAPSHOT_GENERIC, 0, 0, &data, &count));
+
+    const Snapshot_Section *section =
+        (const Snapshot_Section *)(snapshot->base + sizeof(Snapshot_Header));
+    view->data = data;
+    view->size = count;
+    view->capacity = count;
+    view->element_size = (usize)section->element_size;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Views a snapshot of a CSR graph.
+ *
+ * Only the array sizes and the first and last offsets are checked; the
+ * adjacency lists themselves are trusted.
+ */
+Result snapshot_view_csr_graph(const Snapshot *snapshot, CSR_Graph *view)
+{
+    DS_ASSERT(view != NULL, "View must not be NULL");
+
+    ptr offsets = NULL, neighbors = NULL, weights = NULL;
+    usize offset_count = 0, edge_count = 0, weight_count = 0;
+    CHECK_RESULT(find_section(snapshot, SNAPSHOT_CSR_GRAPH, 0, sizeof(u64),
+                              &offsets, &offset_count));
+    CHECK_RESULT(find_section(snapshot, SNAPSHOT_CSR_GRAPH, 1, sizeof(u32),
+                              &neighbors, &edge_count));
+    CHECK_RESULT(find_section(snapshot, SNAPSHOT_CSR_GRAPH, 2, sizeof(f64),
+                              &weights, &weight_count));
+
+    const u64 *first = (const u64 *)offsets;
+    if(offset_count == 0 || offset_count - 1 > UINT32_MAX ||
+       first[0] != 0 || first[offset_count - 1] != edge_count ||
+       (weight_count != 0 && weight_count != edge_count))
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Snapshot graph sections are inconsistent");
+
+    view->vertex_count = (u32)(offset_count - 1);
+    view->edge_count = edge_count;
+    view->offsets = (u64Array){(u64 *)offsets, offset_count, offset_count};
+    view->neighbors = (u32Array){(u32 *)neighbors, edge_count, edge_count};
+    view->weights = (f64Array){(f64 *)weights, weight_count, weight_count};
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  TYPED ARRAYS
+ * ============================================================================
+ */
+
+/**
+ * @brief Defines the save and view functions of a typed array.
+ */
+#define DEFINE_SNAPSHOT_ARRAY(T, KIND)                                         \
+    Result snapshot_save_##T(const char *path, const T##Array *array)          \
+    {                                                                          \
+        DS_ASSERT(path != NULL && array != NULL,                               \
+                  "Arguments must not be NULL");                               \
+        Section_Source source = {array->data, array->size, sizeof(T)};         \
+        return write_snapshot(path, KIND, &source, 1);                         \
+    }                                                                          \
+                                                                               \
+    Result snapshot_view_##T(const Snapshot *snapshot, T##Array *view)         \
+    {                                                                          \
+        DS_ASSERT(view != NULL, "View must not be NULL");                      \
+        ptr data = NULL;                                                       \
+        usize count = 0;                                                       \
+        CHECK_RESULT(                                                          \
+            find_section(snapshot, KIND, 0, sizeof(T), &data, &count));        \
+        *view = (T##Array){(T *)data, count, count};                           \
+        return RESULT_SUCCESS;                                                 \
+    }
+
+DEFINE_SNAPSHOT_ARRAY(i32, SNAPSHOT_I32)
+DEFINE_SNAPSHOT_ARRAY(u32, SNAPSHOT_U32)
+DEFINE_SNAPSHOT_ARRAY(u64, SNAPSHOT_U64)
+DEFINE_SNAPSHOT_ARRAY(f64, SNAPSHOT_F64)
+DEFINE_SNAPSHOT_ARRAY(byte, SNAPSHOT_BYTE)
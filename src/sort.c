@@ -0,0 +1,566 @@
+#include "../include/sort.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+#include "../include/trace.h"
+#include <stdlib.h>
+
+/**
+ * @brief Smallest number of elements sorted or merged by one task.
+ */
+#define SORT_MIN_LEAF 4096
+
+/**
+ * @brief Leaf tasks created per thread (more leaves balance better).
+ */
+#define SORT_PIECES_PER_THREAD 4
+
+/**
+ * @brief Arrays up to this size are insertion-sorted by the radix sorts.
+ */
+#define RADIX_SMALL 64
+
+/**
+ * @brief Bits per radix digit and the resulting number of buckets.
+ */
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+/**
+ * @brief Minimum elements per piece of a radix pass.
+ */
+#define RADIX_GRAIN 65536
+
+/**
+ * @brief Parameters shared by all tasks of one merge sort.
+ */
+typedef struct
+{
+        compare_fn compare;
+        usize width; // Element size in bytes
+        usize leaf;  // Elements handled serially
+} Merge_Sort;
+
+/**
+ * @brief Sorts `count` elements of `data`; the result ends in `scratch`
+ *        instead when `to_scratch` is set.
+ */
+typedef struct
+{
+        const Merge_Sort *sort;
+        byte *data;
+        byte *scratch;
+        usize count;
+        bool to_scratch;
+} Sort_Job;
+
+/**
+ * @brief Merges two sorted runs into `out`.
+ */
+typedef struct
+{
+        const Merge_Sort *sort;
+        const byte *left;
+        usize left_count;
+        const byte *right;
+        usize right_count;
+        byte *out;
+} Merge_Job;
+
+/**
+ * @brief Shared state of one radix sort.
+ *
+ * Keys are u32 or u64 (`wide`). `counts` holds one histogram of
+ * RADIX_BUCKETS entries per piece, turned into scatter cursors before the
+ * scatter step.
+ */
+typedef struct
+{
+        ptr source;
+        ptr target;
+        usize count;
+        bool wide;
+        u32 shift;
+        u64 *counts;
+        usize piece_count;
+} Radix_Sort;
+
+/* ============================================================================
+ *  MERGE SORT
+ * ============================================================================
+ */
+
+/**
+ * @brief Returns the first index of `run` whose element is not less than
+ *        `key`.
+ */
+static usize lower_bound(const Merge_Sort *sort, const byte *run, usize count,
+                         cptr key)
+{
+    usize low = 0;
+    while(low < count)
+    {
+        usize middle = low + (count - low) / 2;
+        if(sort->compare(run + middle * sort->width, key) < 0)
+            low = middle + 1;
+        else
+            count = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief Merges two runs on the calling thread.
+ */
+static void merge_serial(const Merge_Job *job)
+{
+    const Merge_Sort *sort = job->sort;
+    usize width = sort->width;
+    const byte *left = job->left;
+    const byte *left_end = left + job->left_count * width;
+    const byte *right = job->right;
+    const byte *right_end = right + job->right_count * width;
+    byte *out = job->out;
+
+    while(left < left_end && right < right_end)
+    {
+        if(sort->compare(right, left) < 0)
+        {
+            ds_memcpy(out, right, width);
+            right += width;
+        }
+        else
+        {
+            ds_memcpy(out, left, width);
+            left += width;
+        }
+        out += width;
+    }
+
+    ds_memcpy(out, left, (usize)(left_end - left));
+    out += left_end - left;
+    ds_memcpy(out, right, (usize)(right_end - right));
+}
+
+/**
+ * @brief Merges two runs, splitting large merges into independent halves.
+ *
+ * The longer run is cut at its middle element; a binary search finds the
+ * matching cut in the other run. Everything before both cuts precedes
+ * everything after them, so the two halves merge in parallel.
+ */
+static void merge_job(ptr context)
+{
+    const Merge_Job *job = (const Merge_Job *)context;
+    const Merge_Sort *sort = job->sort;
+    if(job->left_count + job->right_count <= sort->leaf)
+    {
+        merge_serial(job);
+        return;
+    }
+
+    bool split_left = job->left_count >= job->right_count;
+    const byte *longer = split_left ? job->left : job->right;
+    usize longer_count = split_left ? job->left_count : job->right_count;
+    const byte *shorter = split_left ? job->right : job->left;
+    usize shorter_count = split_left ? job->right_count : job->left_count;
+
+    usize cut = longer_count / 2;
+    usize other =
+        lower_bound(sort, shorter, shorter_count, longer + cut * sort->width);
+    usize left_cut = split_left ? cut : other;
+    usize right_cut = split_left ? other : cut;
+
+    Merge_Job low = {sort, job->left, left_cut, job->right, right_cut,
+                     job->out};
+    Merge_Job high = {sort,
+                      job->left + left_cut * sort->width,
+                      job->left_count - left_cut,
+                      job->right + right_cut * sort->width,
+                      job->right_count - right_cut,
+                      job->out + (left_cut + right_cut) * sort->width};
+
+    Task_Group group = TASK_GROUP_INIT;
+    Task task;
+    ds_task_spawn(&group, &task, merge_job, &low);
+    merge_job(&high);
+    ds_task_sync(&group);
+}
+
+/**
+ * @brief Sorts a range: both halves as parallel tasks, then one merge.
+ *
+ * Each level flips where its result lives, so the halves end up in the
+ * buffer the merge reads from and no copy is needed.
+ */
+static void sort_job(ptr context)
+{
+    const Sort_Job *job = (const Sort_Job *)context;
+    const Merge_Sort *sort = job->sort;
+    usize width = sort->width;
+
+    if(job->count <= sort->leaf)
+    {
+        qsort(job->data, job->count, width, sort->compare);
+        if(job->to_scratch)
+            ds_memcpy(job->scratch, job->data, job->count * width);
+        return;
+    }
+
+    usize half = job->count / 2;
+    Sort_Job low = {sort, job->data, job->scratch, half, !job->to_scratch};
+    Sort_Job high = {sort, job->data + half * width,
+                     job->scratch + half * width, job->count - half,
+                     !job->to_scratch};
+
+    Task_Group group = TASK_GROUP_INIT;
+    Task task;
+    ds_task_spawn(&group, &task, sort_job, &low);
+    sort_job(&high);
+    ds_task_sync(&group);
+
+    byte *from = job->to_scratch ? job->data : job->scratch;
+    byte *to = job->to_scratch ? job->scratch : job->data;
+    Merge_Job merge = {sort, from, half, from + half * width,
+                       job->count - half, to};
+    merge_job(&merge);
+}
+
+/* ============================================================================
+ *  RADIX SORT
+ * ============================================================================
+ */
+
+/**
+ * @brief Returns the bounds of piece `piece` of a radix sort.
+ */
+static void piece_bounds(const Radix_Sort *radix, usize piece, usize *first,
+                         usize *last)
+{
+    *first = radix->count * piece / radix->piece_count;
+    *last = radix->count * (piece + 1) / radix->piece_count;
+}
+
+/**
+ * @brief Builds the digit histogram of each piece of the source keys.
+ */
+static void count_digits(usize begin, usize end, ptr context)
+{
+    Radix_Sort *radix = (Radix_Sort *)context;
+
+    for(usize piece = begin; piece < end; piece++)
+    {
+        u64 *histogram = radix->counts + piece * RADIX_BUCKETS;
+        usize first, last;
+        piece_bounds(radix, piece, &first, &last);
+        for(usize d = 0; d < RADIX_BUCKETS; d++)
+            histogram[d] = 0;
+
+        if(radix->wide)
+        {
+            const u64 *keys = (const u64 *)radix->source;
+            for(usize i = first; i < last; i++)
+                histogram[(keys[i] >> radix->shift) & (RADIX_BUCKETS - 1)]++;
+        }
+        else
+        {
+            const u32 *keys = (const u32 *)radix->source;
+            for(usize i = first; i < last; i++)
+                histogram[(keys[i] >> radix->shift) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+}
+
+/**
+ * @brief Moves the keys of each piece to their slot for the current digit.
+ *
+ * Pieces cover consecutive keys and get consecutive cursors within each
+ * digit, so the scatter is stable.
+ */
+static void scatter_digits(usize begin, usize end, ptr context)
+{
+    Radix_Sort *radix = (Radix_Sort *)context;
+
+    for(usize piece = begin; piece < end; piece++)
+    {
+        u64 *cursor = radix->counts + piece * RADIX_BUCKETS;
+        usize first, last;
+        piece_bounds(radix, piece, &first, &last);
+
+        if(radix->wide)
+        {
+            const u64 *keys = (const u64 *)radix->source;
+            u64 *target = (u64 *)radix->target;
+            for(usize i = first; i < last; i++)
+            {
+                u64 key = keys[i];
+                target[cursor[(key >> radix->shift) & (RADIX_BUCKETS - 1)]++] =
+                    key;
+            }
+        }
+        else
+        {
+            const u32 *keys = (const u32 *)radix->source;
+            u32 *target = (u32 *)radix->target;
+            for(usize i = first; i < last; i++)
+            {
+                u32 key = keys[i];
+                target[cursor[(key >> radix->shift) & (RADIX_BUCKETS - 1)]++] =
+                    key;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Turns the per-piece histograms into scatter cursors.
+ *
+ * @return false if every key has the same digit, i.e. the pass would not
+ *         move anything and can be skipped.
+ */
+static bool prepare_cursors(Radix_Sort *radix)
+{
+    u64 running = 0;
+    for(usize d = 0; d < RADIX_BUCKETS; d++)
+    {
+        u64 digit_total = 0;
+        for(usize piece = 0; piece < radix->piece_count; piece++)
+        {
+            u64 *slot = &radix->counts[piece * RADIX_BUCKETS + d];
+            u64 count = *slot;
+            *slot = running;
+            running += count;
+            digit_total += count;
+        }
+        if(digit_total == radix->count)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Insertion sort for tiny arrays of unsigned keys.
+ */
+static void insertion_sort_keys(ptr keys, usize count, bool wide)
+{
+    for(usize i = 1; i < count; i++)
+    {
+        if(wide)
+        {
+            u64 *data = (u64 *)keys;
+            u64 key = data[i];
+            usize j = i;
+            for(; j > 0 && data[j - 1] > key; j--)
+                data[j] = data[j - 1];
+            data[j] = key;
+        }
+        else
+        {
+            u32 *data = (u32 *)keys;
+            u32 key = data[i];
+            usize j = i;
+            for(; j > 0 && data[j - 1] > key; j--)
+                data[j] = data[j - 1];
+            data[j] = key;
+        }
+    }
+}
+
+/**
+ * @brief Sorts `count` unsigned keys (u32, or u64 if `wide`) in place.
+ */
+static Result radix_sort(ptr keys, usize count, bool wide)
+{
+    if(count <= RADIX_SMALL)
+    {
+        insertion_sort_keys(keys, count, wide);
+        return RESULT_SUCCESS;
+    }
+
+    u64 span = trace_begin();
+    usize width = wide ? sizeof(u64) : sizeof(u32);
+    Radix_Sort radix = {0};
+    radix.count = count;
+    radix.wide = wide;
+    radix.piece_count = (count + RADIX_GRAIN - 1) / RADIX_GRAIN;
+    if(radix.piece_count > ds_parallel_thread_count())
+        radix.piece_count = ds_parallel_thread_count();
+
+    ptr scratch = ds_malloc(count * width);
+    radix.counts = ALLOC_ARRAY(u64, radix.piece_count * RADIX_BUCKETS);
+    Result result = RESULT_SUCCESS;
+    if(!scratch || !radix.counts)
+        result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                              "Failed to allocate radix sort scratch");
+
+    radix.source = keys;
+    radix.target = scratch;
+    for(u32 shift = 0; result_is_success(result) && shift < width * 8;
+        shift += RADIX_BITS)
+    {
+        radix.shift = shift;
+        result = ds_parallel_for(0, radix.piece_count, 1, count_digits, &radix);
+        if(result_is_error(result) || !prepare_cursors(&radix))
+            continue;
+
+        result =
+            ds_parallel_for(0, radix.piece_count, 1, scatter_digits, &radix);
+        ptr swap = radix.source;
+        radix.source = radix.target;
+        radix.target = swap;
+    }
+
+    if(result_is_success(result) && radix.source != keys)
+        ds_memcpy(keys, radix.source, count * width);
+
+    ds_free(radix.counts);
+    ds_free(scratch);
+    trace_end("sort", span, count);
+    return result;
+}
+
+/* ============================================================================
+ *  KEY TRANSFORMS
+ * ============================================================================
+ */
+
+/**
+ * @brief Flips the sign bit of i32 values so that they sort as u32.
+ */
+static void flip_i32(usize begin, usize end, ptr context)
+{
+    u32 *keys = (u32 *)context;
+    for(usize i = begin; i < end; i++)
+        keys[i] ^= 0x80000000u;
+}
+
+/**
+ * @brief Maps f64 bit patterns to u64 keys with the same total order.
+ *
+ * Positive values only need their sign bit set; negative values have all
+ * their bits flipped so that larger magnitudes sort first.
+ */
+static void encode_f64(usize begin, usize end, ptr context)
+{
+    f64 *values = (f64 *)context;
+    for(usize i = begin; i < end; i++)
+    {
+        u64 bits;
+        ds_memcpy(&bits, &values[i], sizeof(bits));
+        bits ^= (bits >> 63) ? ~(u64)0 : (u64)1 << 63;
+        ds_memcpy(&values[i], &bits, sizeof(bits));
+    }
+}
+
+/**
+ * @brief Inverse of encode_f64().
+ */
+static void decode_f64(usize begin, usize end, ptr context)
+{
+    f64 *values = (f64 *)context;
+    for(usize i = begin; i < end; i++)
+    {
+        u64 bits;
+        ds_memcpy(&bits, &values[i], sizeof(bits));
+        bits ^= (bits >> 63) ? (u64)1 << 63 : ~(u64)0;
+        ds_memcpy(&values[i], &bits, sizeof(bits));
+    }
+}
+
+/* ============================================================================
+ *  PUBLIC API
+ * ============================================================================
+ */
+
+/**
+ * @brief Sorts a GenericData container with a parallel merge sort.
+ *
+ * @param data    Container whose first `size` elements are sorted.
+ * @param compare Element comparison (qsort() contract).
+ * @return RESULT_SUCCESS or DS_ERROR_MEMORY_ALLOCATION.
+ */
+Result ds_parallel_sort(GenericData *data, compare_fn compare)
+{
+    DS_ASSERT(data != NULL && compare != NULL, "Arguments must not be NULL");
+    DS_ASSERT(data->size == 0 || data->data != NULL,
+              "Container data must not be NULL");
+    DS_ASSERT(data->element_size != 0, "Element size must not be zero");
+
+    usize threads = ds_parallel_thread_count();
+    Merge_Sort sort = {compare, data->element_size,
+                       data->size / (threads * SORT_PIECES_PER_THREAD)};
+    if(sort.leaf < SORT_MIN_LEAF)
+        sort.leaf = SORT_MIN_LEAF;
+
+    u64 span = trace_begin();
+    Result result = RESULT_SUCCESS;
+    if(threads == 1 || data->size <= sort.leaf)
+        qsort(data->data, data->size, data->element_size, compare);
+    else if(data->size > (usize)-1 / data->element_size)
+        result = RESULT_ERROR(DS_ERROR_OVERFLOW, "Container is too large");
+    else
+    {
+        byte *scratch = (byte *)ds_malloc(data->size * data->element_size);
+        if(scratch)
+        {
+            Sort_Job root = {&sort, (byte *)data->data, scratch, data->size,
+                             false};
+            sort_job(&root);
+            ds_free(scratch);
+        }
+        else
+            result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                                  "Failed to allocate sort scratch");
+    }
+
+    trace_end("sort", span, data->size);
+    return result;
+}
+
+/**
+ * @brief Sorts an i32Array in ascending order.
+ */
+Result ds_parallel_sort_i32(i32Array *array)
+{
+    DS_ASSERT(array != NULL, "Array must not be NULL");
+
+    // Signed and unsigned variants of a type may alias each other.
+    u32 *keys = (u32 *)array->data;
+    CHECK_RESULT(ds_parallel_for(0, array->size, RADIX_GRAIN, flip_i32, keys));
+    Result result = radix_sort(keys, array->size, false);
+    CHECK_RESULT(ds_parallel_for(0, array->size, RADIX_GRAIN, flip_i32, keys));
+    return result;
+}
+
+/**
+ * @brief Sorts a u32Array in ascending order.
+ */
+Result ds_parallel_sort_u32(u32Array *array)
+{
+    DS_ASSERT(array != NULL, "Array must not be NULL");
+    return radix_sort(array->data, array->size, false);
+}
+
+/**
+ * @brief Sorts a u64Array in ascending order.
+ */
+Result ds_parallel_sort_u64(u64Array *array)
+{
+    DS_ASSERT(array != NULL, "Array must not be NULL");
+    return radix_sort(array->data, array->size, true);
+}
+
+/**
+ * @brief Sorts an f64Array in ascending (IEEE-754 total) order.
+ */
+Result ds_parallel_sort_f64(f64Array *array)
+{
+    DS_ASSERT(array != NULL, "Array must not be NULL");
+
+    f64 *values = array->data;
+    CHECK_RESULT(
+        ds_parallel_for(0, array->size, RADIX_GRAIN, encode_f64, values));
+    Result result = radix_sort(values, array->size, true);
+    CHECK_RESULT(
+        ds_parallel_for(0, array->size, RADIX_GRAIN, decode_f64, values));
+    return result;
+}
@@ -0,0 +1,536 @@
+#include "../include/sssp.h"
+#include "../include/dary_heap.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+#include <math.h>
+
+/**
+ * @brief Minimum frontier vertices per parallel piece.
+ */
+#define SSSP_GRAIN 256
+
+/**
+ * @brief Vertices buffered per piece before being published.
+ */
+#define LOCAL_BUFFER_SIZE 256
+
+/**
+ * @brief Shared state of one delta-stepping search.
+ *
+ * `queued` holds one flag per vertex so that a vertex enters `touched` (or
+ * the near frontier) at most once per round, which bounds those arrays by
+ * vertex_count. The far pile may hold stale duplicates; they are dropped
+ * once the threshold has passed their distance.
+ */
+typedef struct
+{
+        const CSR_Graph *graph;
+        f64 *dist;
+        i32 *pred; // May be NULL
+        u8 *queued;
+
+        u32 *near;
+        usize near_size;
+        u32 *next_near;
+        usize next_near_size;
+        u32 *touched;
+        usize touched_size;
+
+        u32Array far;
+        u32Array far_next;
+
+        f64 delta;
+        f64 threshold;          // Near vertices have dist < threshold
+        f64 previous_threshold; // Far entries below it are settled
+        f64 far_minimum;
+
+        u32 pred_pass;
+        bool changed;
+        bool negative_weight;
+} SSSP_State;
+
+/**
+ * @brief Per-piece output buffer flushed into a shared array.
+ */
+typedef struct
+{
+        u32 *target;
+        usize *target_size;
+        u32 items[LOCAL_BUFFER_SIZE];
+        usize count;
+} Local_Buffer;
+
+/* ============================================================================
+ *  HELPERS
+ * ============================================================================
+ */
+
+static void local_init(Local_Buffer *local, u32 *target, usize *target_size)
+{
+    local->target = target;
+    local->target_size = target_size;
+    local->count = 0;
+}
+
+/**
+ * @brief Publishes the buffered items with a single atomic reservation.
+ */
+static void local_flush(Local_Buffer *local)
+{
+    if(local->count == 0)
+        return;
+
+    usize position = __atomic_fetch_add(local->target_size, local->count,
+                                        __ATOMIC_RELAXED);
+    ds_memcpy(local->target + position, local->items,
+              local->count * sizeof(u32));
+    local->count = 0;
+}
+
+static inline void local_push(Local_Buffer *local, u32 item)
+{
+    local->items[local->count++] = item;
+    if(local->count == LOCAL_BUFFER_SIZE)
+        local_flush(local);
+}
+
+static inline f64 load_distance(const f64 *slot)
+{
+    f64 value;
+    __atomic_load(slot, &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+/**
+ * @brief Lowers `*slot` to `candidate` unless it already is smaller.
+ *
+ * @return true if this call stored `candidate`.
+ */
+static inline bool atomic_min_distance(f64 *slot, f64 candidate)
+{
+    f64 current = load_distance(slot);
+    while(candidate < current)
+    {
+        if(__atomic_compare_exchange(slot, &current, &candidate, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return true;
+    }
+    return false;
+}
+
+static inline f64 edge_weight(const CSR_Graph *graph, u64 edge)
+{
+    return graph->weights.size ? graph->weights.data[edge] : 1.0;
+}
+
+/* ============================================================================
+ *  DELTA-STEPPING PHASES
+ * ============================================================================
+ */
+
+/**
+ * @brief Relaxes the out-edges of near[begin, end).
+ */
+static void relax_piece(usize begin, usize end, ptr context)
+{
+    SSSP_State *state = (SSSP_State *)context;
+    const CSR_Graph *graph = state->graph;
+    Local_Buffer touched;
+
+    local_init(&touched, state->touched, &state->touched_size);
+    for(usize i = begin; i < end; i++)
+    {
+        u32 u = state->near[i];
+        f64 du = load_distance(&state->dist[u]);
+
+        for(u64 e = graph->offsets.data[u]; e < graph->offsets.data[u + 1];
+            e++)
+        {
+            f64 weight = edge_weight(graph, e);
+            if(weight < 0.0)
+            {
+                __atomic_store_n(&state->negative_weight, true,
+                                 __ATOMIC_RELAXED);
+                continue;
+            }
+
+            u32 v = graph->neighbors.data[e];
+            if(atomic_min_distance(&state->dist[v], du + weight) &&
+               __atomic_exchange_n(&state->queued[v], 1, __ATOMIC_RELAXED) ==
+                   0)
+                local_push(&touched, v);
+        }
+    }
+    local_flush(&touched);
+}
+
+/**
+ * @brief Sends the vertices improved by a round to the near frontier (if
+ *        below the threshold) or to the far pile.
+ */
+static void split_touched_piece(usize begin, usize end, ptr context)
+{
+    SSSP_State *state = (SSSP_State *)context;
+    Local_Buffer near, far;
+
+    local_init(&near, state->next_near, &state->next_near_size);
+    local_init(&far, state->far.data, &state->far.size);
+    for(usize i = begin; i < end; i++)
+    {
+        u32 v = state->touched[i];
+        state->queued[v] = 0;
+        if(state->dist[v] < state->threshold)
+            local_push(&near, v);
+        else
+            local_push(&far, v);
+    }
+    local_flush(&near);
+    local_flush(&far);
+}
+
+/**
+ * @brief Finds the smallest unsettled distance in the far pile.
+ */
+static void far_minimum_piece(usize begin, usize end, ptr context)
+{
+    SSSP_State *state = (SSSP_State *)context;
+    f64 minimum = INFINITY;
+
+    for(usize i = begin; i < end; i++)
+    {
+        f64 d = state->dist[state->far.data[i]];
+        if(d >= state->threshold && d < minimum)
+            minimum = d;
+    }
+    atomic_min_distance(&state->far_minimum, minimum);
+}
+
+/**
+ * @brief Moves far vertices below the new threshold into the near frontier
+ *        and compacts the rest, dropping settled entries.
+ */
+static void split_far_piece(usize begin, usize end, ptr context)
+{
+    SSSP_State *state = (SSSP_State *)context;
+    Local_Buffer near, far;
+
+    local_init(&near, state->near, &state->near_size);
+    local_init(&far, state->far_next.data, &state->far_next.size);
+    for(usize i = begin; i < end; i++)
+    {
+        u32 v = state->far.data[i];
+        f64 d = state->dist[v];
+        if(d < state->previous_threshold)
+            continue;
+        if(d >= state->threshold)
+            local_push(&far, v);
+        else if(__atomic_exchange_n(&state->queued[v], 1, __ATOMIC_RELAXED) ==
+                0)
+            local_push(&near, v);
+    }
+    local_flush(&near);
+    local_flush(&far);
+}
+
+/**
+ * @brief Clears the duplicate filter of the new near frontier.
+ */
+static void unqueue_piece(usize begin, usize end, ptr context)
+{
+    SSSP_State *state = (SSSP_State *)context;
+    for(usize i = begin; i < end; i++)
+        state->queued[state->near[i]] = 0;
+}
+
+/**
+ * @brief One predecessor pass over the out-edges of vertices [begin, end).
+ *
+ * The first pass only accepts edges that strictly decrease the distance;
+ * later passes resolve zero-weight ties from vertices that already have a
+ * predecessor. Every vertex is thus attached after its predecessor, which
+ * keeps the predecessor graph a tree even with zero-weight cycles.
+ */
+static void predecessor_piece(usize begin, usize end, ptr context)
+{
+    SSSP_State *state = (SSSP_State *)context;
+    const CSR_Graph *graph = state->graph;
+    bool changed = false;
+
+    for(usize u = begin; u < end; u++)
+    {
+        f64 du = state->dist[u];
+        if(du == INFINITY)
+            continue;
+        if(state->pred_pass > 0 &&
+           __atomic_load_n(&state->pred[u], __ATOMIC_RELAXED) ==
+               SSSP_NO_PREDECESSOR)
+            continue;
+
+        for(u64 e = graph->offsets.data[u]; e < graph->offsets.data[u + 1];
+            e++)
+        {
+            u32 v = graph->neighbors.data[e];
+            f64 dv = state->dist[v];
+            if(du + edge_weight(graph, e) != dv ||
+               (state->pred_pass == 0 && du >= dv))
+                continue;
+
+            i32 expected = SSSP_NO_PREDECESSOR;
+            if(__atomic_compare_exchange_n(&state->pred[v], &expected, (i32)u,
+                                           false, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+                changed = true;
+        }
+    }
+    if(changed)
+        __atomic_store_n(&state->changed, true, __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ *  DRIVERS
+ * ============================================================================
+ */
+
+/**
+ * @brief Near/far delta-stepping main loop.
+ */
+static Result run_delta_stepping(SSSP_State *state, u32 source)
+{
+    const CSR_Graph *graph = state->graph;
+
+    state->dist[source] = 0.0;
+    state->near[0] = source;
+    state->near_size = 1;
+    state->threshold = state->delta;
+    state->previous_threshold = 0.0;
+
+    for(;;)
+    {
+        while(state->near_size > 0)
+        {
+            state->touched_size = 0;
+            CHECK_RESULT(ds_parallel_for(0, state->near_size, SSSP_GRAIN,
+                                         relax_piece, state));
+            if(state->negative_weight)
+                return RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT,
+                                    "Negative edge weight");
+
+            CHECK_RESULT(ARRAY_RESERVE(&state->far,
+                                       state->far.size + state->touched_size));
+            state->next_near_size = 0;
+            CHECK_RESULT(ds_parallel_for(0, state->touched_size, SSSP_GRAIN,
+                                         split_touched_piece, state));
+
+            u32 *swap = state->near;
+            state->near = state->next_near;
+            state->next_near = swap;
+            state->near_size = state->next_near_size;
+        }
+
+        state->far_minimum = INFINITY;
+        CHECK_RESULT(ds_parallel_for(0, state->far.size, SSSP_GRAIN,
+                                     far_minimum_piece, state));
+        if(state->far_minimum == INFINITY)
+            break;
+
+        // Advance by whole buckets until the closest far vertex is near.
+        // Once delta is below the spacing of doubles around the distances
+        // the sum rounds back down, so step past far_minimum at least.
+        state->previous_threshold = state->threshold;
+        state->threshold = fmax(
+            state->threshold +
+                (floor((state->far_minimum - state->threshold) /
+                       state->delta) +
+                 1.0) *
+                    state->delta,
+            nextafter(state->far_minimum, INFINITY));
+
+        CHECK_RESULT(ARRAY_RESERVE(&state->far_next, state->far.size));
+        state->far_next.size = 0;
+        state->near_size = 0;
+        CHECK_RESULT(ds_parallel_for(0, state->far.size, SSSP_GRAIN,
+                                     split_far_piece, state));
+        CHECK_RESULT(ds_parallel_for(0, state->near_size, SSSP_GRAIN,
+                                     unqueue_piece, state));
+
+        u32Array swap = state->far;
+        state->far = state->far_next;
+        state->far_next = swap;
+    }
+
+    if(state->pred)
+    {
+        state->pred[source] = (i32)source;
+        state->pred_pass = 0;
+        do
+        {
+            state->changed = false;
+            CHECK_RESULT(ds_parallel_for(0, graph->vertex_count, SSSP_GRAIN,
+                                         predecessor_piece, state));
+            state->pred_pass++;
+        } while(state->changed || state->pred_pass == 1);
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Allocates the delta-stepping state around caller-provided outputs.
+ */
+static Result delta_stepping(const CSR_Graph *graph, u32 source, f64 delta,
+                             f64 *dist, i32 *pred)
+{
+    u32 vertex_count = graph->vertex_count;
+    SSSP_State state = {0};
+    state.graph = graph;
+    state.dist = dist;
+    state.pred = pred;
+    state.delta = delta;
+
+    state.queued = ALLOC_ARRAY(u8, vertex_count);
+    state.near = ALLOC_ARRAY(u32, vertex_count);
+    state.next_near = ALLOC_ARRAY(u32, vertex_count);
+    state.touched = ALLOC_ARRAY(u32, vertex_count);
+
+    Result result = RESULT_SUCCESS;
+    if(!state.queued || !state.near || !state.next_near || !state.touched)
+        result = RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                              "Failed to allocate delta-stepping state");
+    if(result_is_success(result))
+        result = run_delta_stepping(&state, source);
+
+    ds_free(state.queued);
+    ds_free(state.near);
+    ds_free(state.next_near);
+    ds_free(state.touched);
+    ds_free(state.far.data);
+    ds_free(state.far_next.data);
+    return result;
+}
+
+/**
+ * @brief Serial Dijkstra with lazy deletion on a d-ary heap.
+ */
+static Result dijkstra(const CSR_Graph *graph, u32 source, f64 *dist,
+                       i32 *pred)
+{
+    Dary_Heap heap;
+    CHECK_RESULT(dary_heap_create(&heap, 64));
+
+    dist[source] = 0.0;
+    if(pred)
+        pred[source] = (i32)source;
+
+    Result result = dary_heap_push(&heap, 0.0, source);
+    Dary_Heap_Entry top;
+    while(result_is_success(result) && !dary_heap_is_empty(&heap))
+    {
+        dary_heap_pop(&heap, &top);
+        u32 u = top.value;
+        if(top.key > dist[u])
+            continue; // Stale entry
+
+        for(u64 e = graph->offsets.data[u];
+            e < graph->offsets.data[u + 1] && result_is_success(result); e++)
+        {
+            f64 weight = edge_weight(graph, e);
+            if(weight < 0.0)
+            {
+                result = RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT,
+                                      "Negative edge weight");
+                break;
+            }
+
+            u32 v = graph->neighbors.data[e];
+            f64 candidate = top.key + weight;
+            if(candidate < dist[v])
+            {
+                dist[v] = candidate;
+                if(pred)
+                    pred[v] = (i32)u;
+                result = dary_heap_push(&heap, candidate, v);
+            }
+        }
+    }
+
+    dary_heap_destroy(&heap);
+    return result;
+}
+
+/**
+ * @brief Validates arguments and sizes the output arrays.
+ */
+static Result prepare_outputs(const CSR_Graph *graph, u32 source,
+                              f64Array *distances, i32Array *predecessors)
+{
+    DS_ASSERT(graph != NULL && distances != NULL,
+              "Graph and distances must not be NULL");
+    if(source >= graph->vertex_count)
+        return RESULT_ERROR(DS_ERROR_INDEX_OUT_OF_BOUNDS,
+                            "Source vertex out of range");
+    DS_ASSERT(predecessors == NULL || graph->vertex_count <= INT32_MAX,
+              "Vertex ids do not fit in i32 predecessors");
+
+    u32 vertex_count = graph->vertex_count;
+    CHECK_RESULT(ARRAY_RESERVE(distances, vertex_count));
+    distances->size = vertex_count;
+    for(usize v = 0; v < vertex_count; v++)
+        distances->data[v] = INFINITY;
+
+    if(predecessors)
+    {
+        CHECK_RESULT(ARRAY_RESERVE(predecessors, vertex_count));
+        predecessors->size = vertex_count;
+        for(usize v = 0; v < vertex_count; v++)
+            predecessors->data[v] = SSSP_NO_PREDECESSOR;
+    }
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  PUBLIC API
+ * ============================================================================
+ */
+
+/**
+ * @brief Shortest paths from `source`, parallel for large graphs.
+ *
+ * @param graph        Graph with non-negative weights (or unweighted).
+ * @param source       Start vertex.
+ * @param delta        Bucket width, or 0 for the mean edge weight.
+ * @param distances    Output: distance of every vertex (INFINITY if
+ *                     unreachable).
+ * @param predecessors Optional output: predecessor on a shortest path.
+ * @return RESULT_SUCCESS or an error code.
+ */
+Result csr_sssp(const CSR_Graph *graph, u32 source, f64 delta,
+                f64Array *distances, i32Array *predecessors)
+{
+    CHECK_RESULT(prepare_outputs(graph, source, distances, predecessors));
+    DS_ASSERT(delta >= 0.0, "Delta must not be negative");
+
+    i32 *pred = predecessors ? predecessors->data : NULL;
+    if(graph->edge_count < SSSP_SERIAL_EDGES || ds_parallel_thread_count() == 1)
+        return dijkstra(graph, source, distances->data, pred);
+
+    if(delta == 0.0)
+    {
+        f64 total = 0.0;
+        for(usize e = 0; e < graph->weights.size; e++)
+            total += graph->weights.data[e];
+        delta = graph->weights.size ? total / (f64)graph->weights.size : 1.0;
+        if(!(delta > 0.0))
+            delta = 1.0;
+    }
+    return delta_stepping(graph, source, delta, distances->data, pred);
+}
+
+/**
+ * @brief Serial Dijkstra shortest paths from `source`.
+ */
+Result csr_dijkstra(const CSR_Graph *graph, u32 source, f64Array *distances,
+                    i32Array *predecessors)
+{
+    CHECK_RESULT(prepare_outputs(graph, source, distances, predecessors));
+    return dijkstra(graph, source, distances->data,
+                    predecessors ? predecessors->data : NULL);
+}
@@ -0,0 +1,521 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // For O_DIRECT
+#endif
+
+#include "../include/stream.h"
+#include "../include/memory.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef O_DIRECT
+#define O_DIRECT 0
+#endif
+
+/* ============================================================================
+ *  SYSTEM CALLS
+ * ============================================================================
+ */
+
+/**
+ * @brief Opens a file, dropping O_DIRECT if the filesystem refuses it.
+ */
+static int open_file(const char *path, int mode, u32 flags, bool *direct)
+{
+    *direct = false;
+    if((flags & STREAM_DIRECT) && O_DIRECT != 0)
+    {
+        int fd = open(path, mode | O_DIRECT, 0644);
+        if(fd >= 0 || errno != EINVAL)
+        {
+            *direct = fd >= 0;
+            return fd;
+        }
+    }
+    return open(path, mode, 0644);
+}
+
+/**
+ * @brief Writes the iovecs completely, resuming after short writes.
+ */
+static Result writev_all(int fd, struct iovec *iov, int count)
+{
+    while(count > 0)
+    {
+        ssize_t written = writev(fd, iov, count);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written <= 0)
+            return RESULT_ERROR(DS_ERROR_IO, "Failed to write stream");
+
+        usize left = (usize)written;
+        while(count > 0 && left >= iov->iov_len)
+        {
+            left -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if(count > 0)
+        {
+            iov->iov_base = (byte *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Writes a buffer completely.
+ */
+static Result write_all(int fd, const byte *data, usize size)
+{
+    struct iovec iov = {(ptr)data, size};
+    return writev_all(fd, &iov, size > 0 ? 1 : 0);
+}
+
+/**
+ * @brief One read() call, retried on interruption; 0 means end of file.
+ */
+static Result read_once(int fd, byte *data, usize size, usize *read_bytes)
+{
+    ssize_t count;
+    do
+        count = read(fd, data, size);
+    while(count < 0 && errno == EINTR);
+
+    if(count < 0)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to read stream");
+    *read_bytes = (usize)count;
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  WRITER
+ * ============================================================================
+ */
+
+/**
+ * @brief Sets up a writer on an open descriptor.
+ */
+static Result writer_init(Stream_Writer *writer, int fd, bool owns_fd,
+                          bool direct)
+{
+    *writer = (Stream_Writer){0};
+    writer->fd = fd;
+    writer->owns_fd = owns_fd;
+    writer->direct = direct;
+    writer->buffer = (byte *)ds_aligned_alloc(STREAM_ALIGNMENT,
+                                              STREAM_BUFFER_SIZE);
+    if(!writer->buffer)
+    {
+        if(owns_fd)
+            close(fd);
+        writer->fd = -1;
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate stream buffer");
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Creates (or truncates) a file and opens a writer on it.
+ */
+Result stream_writer_open(Stream_Writer *writer, const char *path, u32 flags)
+{
+    DS_ASSERT(writer != NULL && path != NULL, "Arguments must not be NULL");
+
+    bool direct;
+    int fd = open_file(path, O_WRONLY | O_CREAT | O_TRUNC, flags, &direct);
+    if(fd < 0)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to create stream file");
+    return writer_init(writer, fd, true, direct);
+}
+
+/**
+ * @brief Opens a writer on a descriptor owned by the caller.
+ */
+Result stream_writer_from_fd(Stream_Writer *writer, int fd)
+{
+    DS_ASSERT(writer != NULL && fd >= 0, "Invalid writer or descriptor");
+    return writer_init(writer, fd, false, false);
+}
+
+/**
+ * @brief Writes out the buffered bytes.
+ *
+ * In direct mode only whole blocks can be written; a partial last block
+ * stays buffered until the writer is closed.
+ */
+Result stream_writer_flush(Stream_Writer *writer)
+{
+    DS_ASSERT(writer != NULL && writer->buffer != NULL,
+              "Writer must be open");
+
+    usize size = writer->length;
+    if(writer->direct)
+        size -= size % STREAM_ALIGNMENT;
+    if(size == 0)
+        return RESULT_SUCCESS;
+
+    CHECK_RESULT(write_all(writer->fd, writer->buffer, size));
+    writer->length -= size;
+    if(writer->length > 0)
+        ds_memmove(writer->buffer, writer->buffer + size, writer->length);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Appends bytes to the stream.
+ */
+Result stream_write(Stream_Writer *writer, cptr data, usize size)
+{
+    DS_ASSERT(writer != NULL && writer->buffer != NULL,
+              "Writer must be open");
+    DS_ASSERT(data != NULL || size == 0, "Data must not be NULL");
+
+    const byte *bytes = (const byte *)data;
+    writer->position += size;
+
+    // Large writes skip the copy: buffered bytes and data go out together.
+    if(!writer->direct && writer->length + size > STREAM_BUFFER_SIZE &&
+       size >= STREAM_BUFFER_SIZE / 2)
+    {
+        struct iovec iov[2] = {{writer->buffer, writer->length},
+                               {(ptr)bytes, size}};
+        usize buffered = writer->length;
+        writer->length = 0;
+        return writev_all(writer->fd, buffered ? iov : iov + 1,
+                          buffered ? 2 : 1);
+    }
+
+    while(size > 0)
+    {
+        usize room = STREAM_BUFFER_SIZE - writer->length;
+        usize count = size < room ? size : room;
+        ds_memcpy(writer->buffer + writer->length, bytes, count);
+        writer->length += count;
+        bytes += count;
+        size -= count;
+        if(writer->length == STREAM_BUFFER_SIZE)
+            CHECK_RESULT(stream_writer_flush(writer));
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Flushes and closes a writer.
+ *
+ * In direct mode the last block is written zero-padded and the file is
+ * then truncated to the number of bytes actually written.
+ */
+Result stream_writer_close(Stream_Writer *writer)
+{
+    if(!writer || !writer->buffer)
+        return RESULT_SUCCESS;
+
+    Result result = stream_writer_flush(writer);
+    if(result_is_success(result) && writer->direct && writer->length > 0)
+    {
+        usize padded = (writer->length + STREAM_ALIGNMENT - 1) &
+                       ~(usize)(STREAM_ALIGNMENT - 1);
+        ds_memset(writer->buffer + writer->length, 0,
+                  padded - writer->length);
+        result = write_all(writer->fd, writer->buffer, padded);
+        if(result_is_success(result) &&
+           ftruncate(writer->fd, (off_t)writer->position) != 0)
+            result = RESULT_ERROR(DS_ERROR_IO, "Failed to truncate stream");
+    }
+
+    if(writer->owns_fd && close(writer->fd) != 0 &&
+       result_is_success(result))
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to close stream file");
+    ds_free(writer->buffer);
+    *writer = (Stream_Writer){0};
+    writer->fd = -1;
+    return result;
+}
+
+/* ============================================================================
+ *  READER
+ * ============================================================================
+ */
+
+/**
+ * @brief Sets up a reader on an open descriptor.
+ */
+static Result reader_init(Stream_Reader *reader, int fd, bool owns_fd,
+                          bool direct)
+{
+    *reader = (Stream_Reader){0};
+    reader->fd = fd;
+    reader->owns_fd = owns_fd;
+    reader->direct = direct;
+    reader->buffer = (byte *)ds_aligned_alloc(STREAM_ALIGNMENT,
+                                              STREAM_BUFFER_SIZE);
+    if(!reader->buffer)
+    {
+        if(owns_fd)
+            close(fd);
+        reader->fd = -1;
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate stream buffer");
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Opens a reader on an existing file.
+ */
+Result stream_reader_open(Stream_Reader *reader, const char *path, u32 flags)
+{
+    DS_ASSERT(reader != NULL && path != NULL, "Arguments must not be NULL");
+
+    bool direct;
+    int fd = open_file(path, O_RDONLY, flags, &direct);
+    if(fd < 0)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to open stream file");
+    return reader_init(reader, fd, true, direct);
+}
+
+/**
+ * @brief Opens a reader on a descriptor owned by the caller.
+ */
+Result stream_reader_from_fd(Stream_Reader *reader, int fd)
+{
+    DS_ASSERT(reader != NULL && fd >= 0, "Invalid reader or descriptor");
+    return reader_init(reader, fd, false, false);
+}
+
+/**
+ * @brief Releases a reader.
+ */
+void stream_reader_close(Stream_Reader *reader)
+{
+    if(!reader || !reader->buffer)
+        return;
+
+    if(reader->owns_fd)
+        close(reader->fd);
+    ds_free(reader->buffer);
+    *reader = (Stream_Reader){0};
+    reader->fd = -1;
+}
+
+/**
+ * @brief Refills an empty buffer; leaves it empty at the end of the file.
+ */
+static Result refill(Stream_Reader *reader)
+{
+    usize count = 0;
+    CHECK_RESULT(read_once(reader->fd, reader->buffer, STREAM_BUFFER_SIZE,
+                           &count));
+    reader->begin = 0;
+    reader->end = count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Reads up to `capacity` bytes.
+ */
+Result stream_read_some(Stream_Reader *reader, ptr data, usize capacity,
+                        usize *read)
+{
+    DS_ASSERT(reader != NULL && reader->buffer != NULL,
+              "Reader must be open");
+    DS_ASSERT((data != NULL || capacity == 0) && read != NULL,
+              "Arguments must not be NULL");
+
+    *read = 0;
+    if(capacity == 0)
+        return RESULT_SUCCESS;
+
+    if(reader->begin == reader->end)
+    {
+        // Large requests bypass the buffer (not possible with O_DIRECT,
+        // which needs aligned destinations).
+        if(!reader->direct && capacity >= STREAM_BUFFER_SIZE / 2)
+        {
+            CHECK_RESULT(read_once(reader->fd, (byte *)data, capacity, read));
+            reader->position += *read;
+            return RESULT_SUCCESS;
+        }
+        CHECK_RESULT(refill(reader));
+    }
+
+    usize available = reader->end - reader->begin;
+    usize count = capacity < available ? capacity : available;
+    ds_memcpy(data, reader->buffer + reader->begin, count);
+    reader->begin += count;
+    reader->position += count;
+    *read = count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Reads exactly `size` bytes.
+ */
+Result stream_read(Stream_Reader *reader, ptr data, usize size)
+{
+    byte *bytes = (byte *)data;
+    while(size > 0)
+    {
+        usize count = 0;
+        CHECK_RESULT(stream_read_some(reader, bytes, size, &count));
+        if(count == 0)
+            return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                "Stream ended unexpectedly");
+        bytes += count;
+        size -= count;
+    }
+    return RESULT_SUCCESS;
+}
+
+/* ============================================================================
+ *  CONTAINER RECORDS
+ * ============================================================================
+ */
+
+/**
+ * @brief Writes one record holding `count` elements of `width` bytes.
+ */
+static Result write_record(Stream_Writer *writer, cptr data, usize count,
+                           usize width)
+{
+    DS_ASSERT(writer != NULL, "Writer must not be NULL");
+    DS_ASSERT(data != NULL || count == 0, "Data must not be NULL");
+    DS_ASSERT(width != 0 && width <= UINT32_MAX, "Invalid element size");
+
+    Stream_Record_Header header = {STREAM_RECORD_MAGIC, (u32)width, count};
+    CHECK_RESULT(stream_write(writer, &header, sizeof(header)));
+    return stream_write(writer, data, count * width);
+}
+
+/**
+ * @brief Starts the next record, or reports the end of the stream.
+ */
+static Result next_record(Stream_Reader *reader, bool *more)
+{
+    *more = false;
+    if(reader->begin == reader->end)
+    {
+        CHECK_RESULT(refill(reader));
+        if(reader->begin == reader->end)
+            return RESULT_SUCCESS;
+    }
+
+    Stream_Record_Header header;
+    CHECK_RESULT(stream_read(reader, &header, sizeof(header)));
+    if(header.magic != STREAM_RECORD_MAGIC)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Invalid stream record header");
+
+    reader->record_remaining = header.count;
+    reader->record_width = header.element_size;
+    *more = true;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Reads the next elements of the stream into a growable array.
+ *
+ * Stops before a record of another element size, which is kept for the
+ * next call; that is an error only if no element could be read.
+ */
+static Result read_elements(Stream_Reader *reader, ptr *data,
+                            usize *capacity, usize *size, usize width,
+                            usize max_count)
+{
+    DS_ASSERT(reader != NULL && reader->buffer != NULL,
+              "Reader must be open");
+    DS_ASSERT(width != 0, "Element size must not be zero");
+
+    *size = 0;
+    while(max_count == 0 || *size < max_count)
+    {
+        if(reader->record_remaining == 0)
+        {
+            bool more;
+            CHECK_RESULT(next_record(reader, &more));
+            if(!more)
+                break;
+            continue;
+        }
+        if(reader->record_width != width)
+        {
+            if(*size > 0)
+                break;
+            return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                "Stream record has another element size");
+        }
+
+        // The record count comes from the stream, so the array only grows
+        // by what one buffer holds before those bytes have been read: a
+        // corrupted or truncated stream then fails at the read instead of
+        // after an arbitrarily large allocation.
+        u64 count = reader->record_remaining;
+        if(max_count != 0 && count > max_count - *size)
+            count = max_count - *size;
+        usize step =
+            width < STREAM_BUFFER_SIZE ? STREAM_BUFFER_SIZE / width : 1;
+        if(count > step)
+            count = step;
+        if(count > (u64)(SIZE_MAX / width) - *size)
+            return RESULT_ERROR(DS_ERROR_OVERFLOW,
+                                "Stream record is too large");
+
+        CHECK_RESULT(ds_array_reserve(data, capacity, *size + (usize)count,
+                                      width));
+        CHECK_RESULT(stream_read(reader, (byte *)*data + *size * width,
+                                 (usize)count * width));
+        *size += (usize)count;
+        reader->record_remaining -= count;
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Appends a GenericData container as one record.
+ */
+Result stream_write_generic(Stream_Writer *writer, const GenericData *data)
+{
+    DS_ASSERT(data != NULL, "Data must not be NULL");
+    return write_record(writer, data->data, data->size, data->element_size);
+}
+
+/**
+ * @brief Reads the next elements into a GenericData container.
+ */
+Result stream_read_generic(Stream_Reader *reader, GenericData *data,
+                           usize max_count)
+{
+    DS_ASSERT(data != NULL, "Data must not be NULL");
+    return read_elements(reader, &data->data, &data->capacity, &data->size,
+                         data->element_size, max_count);
+}
+
+/**
+ * @brief Defines the record functions of a typed array.
+ */
+#define DEFINE_STREAM_ARRAY(T)                                                 \
+    Result stream_write_##T##_array(Stream_Writer *writer,                     \
+                                    const T##Array *array)                     \
+    {                                                                          \
+        DS_ASSERT(array != NULL, "Array must not be NULL");                    \
+        return write_record(writer, array->data, array->size, sizeof(T));      \
+    }                                                                          \
+                                                                               \
+    Result stream_read_##T##_array(Stream_Reader *reader, T##Array *array,     \
+                                   usize max_count)                            \
+    {                                                                          \
+        DS_ASSERT(array != NULL, "Array must not be NULL");                    \
+        ptr data = array->data;                                                \
+        Result result = read_elements(reader, &data, &array->capacity,         \
+                                      &array->size, sizeof(T), max_count);     \
+        array->data = (T *)data;                                               \
+        return result;                                                         \
+    }
+
+DEFINE_STREAM_ARRAY(byte)
+DEFINE_STREAM_ARRAY(i32)
+DEFINE_STREAM_ARRAY(f64)
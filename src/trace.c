@@ -0,0 +1,287 @@
+#include "../include/trace.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief One span slot, guarded by a sequence number.
+ *
+ * The owner sets `sequence` to 2n + 1 while writing its n-th span and to
+ * 2n + 2 once done. A reader keeps a span only if it saw the same even
+ * sequence before and after copying it.
+ */
+typedef struct
+{
+        u64 sequence;
+        Trace_Span span;
+} Trace_Slot;
+
+/**
+ * @brief A thread's ring; `head` counts the spans ever written.
+ */
+typedef struct Trace_Ring Trace_Ring;
+struct Trace_Ring
+{
+        u64 head;
+        Trace_Ring *next; // Immutable once published
+        bool in_use;
+        usize id;
+        Trace_Slot slots[TRACE_RING_CAPACITY];
+};
+
+/**
+ * @brief All rings ever claimed (lock-free list, never shrinks).
+ */
+static Trace_Ring *rings = NULL;
+static usize ring_count = 0;
+static bool tracing = false;
+
+static _Thread_local Trace_Ring *current_ring = NULL;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+/* ============================================================================
+ *  RING OWNERSHIP
+ * ============================================================================
+ */
+
+/**
+ * @brief Thread exit hook: hands the ring over to a future thread.
+ */
+static void release_ring(void *ring)
+{
+    __atomic_store_n(&((Trace_Ring *)ring)->in_use, false, __ATOMIC_RELEASE);
+}
+
+static void create_ring_key(void)
+{
+    pthread_key_create(&ring_key, release_ring);
+}
+
+/**
+ * @brief Claims a released ring, or allocates a new one.
+ *
+ * Rings use the C allocator rather than ds_malloc(): they live as long as
+ * the process and must not show up in the memory statistics (nor trace
+ * their own allocation).
+ */
+static Trace_Ring *claim_ring(void)
+{
+    pthread_once(&ring_key_once, create_ring_key);
+
+    Trace_Ring *head = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+    Trace_Ring *ring = NULL;
+    for(Trace_Ring *it = head; it && !ring; it = it->next)
+    {
+        bool expected = false;
+        if(!__atomic_load_n(&it->in_use, __ATOMIC_RELAXED) &&
+           __atomic_compare_exchange_n(&it->in_use, &expected, true, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            ring = it;
+    }
+
+    if(!ring)
+    {
+        ring = (Trace_Ring *)calloc(1, sizeof(Trace_Ring));
+        if(!ring)
+            return NULL;
+        ring->in_use = true;
+        ring->id = __atomic_fetch_add(&ring_count, 1, __ATOMIC_RELAXED);
+        do
+            ring->next = head;
+        while(!__atomic_compare_exchange_n(&rings, &head, ring, true,
+                                           __ATOMIC_RELEASE,
+                                           __ATOMIC_ACQUIRE));
+    }
+
+    pthread_setspecific(ring_key, ring);
+    return ring;
+}
+
+/* ============================================================================
+ *  RECORDING
+ * ============================================================================
+ */
+
+/**
+ * @brief Monotonic time in nanoseconds.
+ */
+static u64 read_clock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000u + (u64)now.tv_nsec;
+}
+
+/**
+ * @brief Turns tracing on or off for every thread.
+ */
+void trace_enable(bool enabled)
+{
+    __atomic_store_n(&tracing, enabled, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Whether spans are currently being recorded.
+ */
+bool trace_enabled(void)
+{
+    return __atomic_load_n(&tracing, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Starts a span: the current time, or 0 while tracing is disabled.
+ */
+u64 trace_begin(void)
+{
+    return __atomic_load_n(&tracing, __ATOMIC_RELAXED) ? read_clock() : 0;
+}
+
+/**
+ * @brief Appends a span that started at `begin` to the calling thread's
+ *        ring.
+ *
+ * Does nothing for spans begun while tracing was disabled, or if the
+ * thread's first span finds no memory for a ring.
+ */
+void trace_end(const char *name, u64 begin, u64 count)
+{
+    if(begin == 0)
+        return;
+    u64 end = read_clock();
+    if(!current_ring)
+        current_ring = claim_ring();
+    if(!current_ring)
+        return;
+
+    Trace_Ring *ring = current_ring;
+    u64 index = ring->head;
+    Trace_Slot *slot = &ring->slots[index & (TRACE_RING_CAPACITY - 1)];
+
+    __atomic_store_n(&slot->sequence, 2 * index + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->span.begin, begin, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->span.end, end, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->span.name, name, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->span.count, count, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->sequence, 2 * index + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, index + 1, __ATOMIC_RELEASE);
+}
+
+/* ============================================================================
+ *  INSPECTION
+ * ============================================================================
+ */
+
+/**
+ * @brief Copies the n-th span of a ring if it is still intact.
+ */
+static bool read_span(Trace_Ring *ring, u64 index, Trace_Span *span)
+{
+    Trace_Slot *slot = &ring->slots[index & (TRACE_RING_CAPACITY - 1)];
+    u64 sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+    if(sequence != 2 * index + 2)
+        return false;
+
+    span->begin = __atomic_load_n(&slot->span.begin, __ATOMIC_RELAXED);
+    span->end = __atomic_load_n(&slot->span.end, __ATOMIC_RELAXED);
+    span->name = __atomic_load_n(&slot->span.name, __ATOMIC_RELAXED);
+    span->count = __atomic_load_n(&slot->span.count, __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+/**
+ * @brief Index of the oldest span still held by a ring of `head` spans.
+ */
+static u64 first_span(u64 head)
+{
+    return head > TRACE_RING_CAPACITY ? head - TRACE_RING_CAPACITY : 0;
+}
+
+/**
+ * @brief Copies the calling thread's most recent spans, oldest first.
+ */
+usize trace_snapshot(Trace_Span *spans, usize capacity)
+{
+    if(!spans || !current_ring)
+        return 0;
+
+    u64 head = current_ring->head;
+    u64 first = first_span(head);
+    if(head - first > capacity)
+        first = head - capacity;
+
+    usize count = 0;
+    for(u64 index = first; index < head; index++)
+        if(read_span(current_ring, index, &spans[count]))
+            count++;
+    return count;
+}
+
+/**
+ * @brief Writes nanoseconds as the microseconds Chrome traces expect.
+ */
+static void print_microseconds(FILE *stream, u64 nanoseconds)
+{
+    fprintf(stream, "%llu.%03u", (unsigned long long)(nanoseconds / 1000),
+            (unsigned)(nanoseconds % 1000));
+}
+
+/**
+ * @brief Writes a span name as a JSON string.
+ */
+static void print_name(FILE *stream, const char *name)
+{
+    fputc('"', stream);
+    for(const char *c = name ? name : "?"; *c; c++)
+    {
+        if(*c == '"' || *c == '\\')
+            fputc('\\', stream);
+        if((unsigned char)*c >= 0x20)
+            fputc(*c, stream);
+    }
+    fputc('"', stream);
+}
+
+/**
+ * @brief Writes every ring's spans to `stream` as a Chrome trace.
+ */
+void trace_dump_json(FILE *stream)
+{
+    if(!stream)
+        return;
+
+    fprintf(stream, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    Trace_Ring *ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+    for(; ring; ring = ring->next)
+    {
+        u64 head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if(head == 0)
+            continue;
+
+        fprintf(stream,
+                "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%zu,\"args\":{\"name\":\"ring %zu\"}}",
+                first ? "" : ",", ring->id, ring->id);
+        first = false;
+        for(u64 index = first_span(head); index < head; index++)
+        {
+            Trace_Span span;
+            if(!read_span(ring, index, &span))
+                continue;
+            fprintf(stream, ",\n{\"name\":");
+            print_name(stream, span.name);
+            fprintf(stream, ",\"cat\":\"ds\",\"ph\":\"X\",\"ts\":");
+            print_microseconds(stream, span.begin);
+            fprintf(stream, ",\"dur\":");
+            print_microseconds(stream, span.end - span.begin);
+            fprintf(stream, ",\"pid\":1,\"tid\":%zu,\"args\":{\"count\":%llu}}",
+                    ring->id, (unsigned long long)span.count);
+        }
+    }
+    fprintf(stream, "\n]}\n");
+    fflush(stream);
+}
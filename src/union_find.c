@@ -0,0 +1,462 @@
+#include "../include/union_find.h"
+#include "../include/memory.h"
+#include "../include/parallel.h"
+
+/**
+ * @brief Minimum edges or vertices per parallel piece.
+ */
+#define COMPONENTS_GRAIN 4096
+
+/**
+ * @brief Neighbors per vertex linked before sampling (Afforest).
+ */
+#define AFFOREST_ROUNDS 2
+
+/**
+ * @brief Vertices sampled to guess the largest component (Afforest).
+ */
+#define AFFOREST_SAMPLES 1024
+
+/* ============================================================================
+ *  SERIAL UNION-FIND
+ * ============================================================================
+ */
+
+/**
+ * @brief Creates `element_count` singleton sets.
+ *
+ * @return RESULT_SUCCESS or DS_ERROR_MEMORY_ALLOCATION.
+ */
+Result union_find_create(Union_Find *uf, u32 element_count)
+{
+    DS_ASSERT(uf != NULL, "Union-find must not be NULL");
+
+    *uf = (Union_Find){0};
+    Result result = ARRAY_RESERVE(&uf->parent, element_count);
+    if(result_is_success(result))
+        result = ARRAY_RESERVE(&uf->size, element_count);
+    if(result_is_error(result))
+    {
+        union_find_destroy(uf);
+        return result;
+    }
+
+    for(u32 i = 0; i < element_count; i++)
+    {
+        uf->parent.data[i] = i;
+        uf->size.data[i] = 1;
+    }
+    uf->parent.size = uf->size.size = element_count;
+    uf->set_count = element_count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Frees the union-find storage.
+ */
+void union_find_destroy(Union_Find *uf)
+{
+    if(!uf)
+        return;
+
+    ds_free(uf->parent.data);
+    ds_free(uf->size.data);
+    *uf = (Union_Find){0};
+}
+
+/**
+ * @brief Returns the representative of `element`, halving the path.
+ *
+ * Path halving makes every visited node point to its grandparent, which
+ * gives the same amortized bound as full compression in a single pass.
+ * Adds the number of nodes walked to `steps`.
+ */
+static u32 find_root(Union_Find *uf, u32 element, u64 *steps)
+{
+    u32 *parent = uf->parent.data;
+    u64 walked = 0;
+    while(parent[element] != element)
+    {
+        parent[element] = parent[parent[element]];
+        element = parent[element];
+        walked++;
+    }
+    *steps += walked;
+    container_stats_depth(uf->stats, walked);
+    return element;
+}
+
+/**
+ * @brief Returns the representative of `element`.
+ */
+u32 union_find_find(Union_Find *uf, u32 element)
+{
+    u64 start = container_stats_begin(uf->stats);
+    u64 steps = 0;
+    u32 root = find_root(uf, element, &steps);
+    container_stats_record(uf->stats, CONTAINER_OP_LOOKUP, steps, start);
+    return root;
+}
+
+/**
+ * @brief Merges the sets containing `a` and `b` (union by size).
+ *
+ * @param merged Optional output: true if the sets were distinct.
+ * @return RESULT_SUCCESS or DS_ERROR_INDEX_OUT_OF_BOUNDS.
+ */
+Result union_find_unite(Union_Find *uf, u32 a, u32 b, bool *merged)
+{
+    DS_ASSERT(uf != NULL, "Union-find must not be NULL");
+    if(a >= uf->parent.size || b >= uf->parent.size)
+        return RESULT_ERROR(DS_ERROR_INDEX_OUT_OF_BOUNDS,
+                            "Union-find element out of range");
+
+    u64 start = container_stats_begin(uf->stats);
+    u64 steps = 0;
+    a = find_root(uf, a, &steps);
+    b = find_root(uf, b, &steps);
+    container_stats_record(uf->stats, CONTAINER_OP_INSERT, steps, start);
+    if(merged)
+        *merged = a != b;
+    if(a == b)
+        return RESULT_SUCCESS;
+
+    if(uf->size.data[a] < uf->size.data[b])
+    {
+        u32 swap = a;
+        a = b;
+        b = swap;
+    }
+    uf->parent.data[b] = a;
+    uf->size.data[a] += uf->size.data[b];
+    uf->set_count--;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Returns true if `a` and `b` belong to the same set.
+ */
+bool union_find_connected(Union_Find *uf, u32 a, u32 b)
+{
+    u64 start = container_stats_begin(uf->stats);
+    u64 steps = 0;
+    bool connected = find_root(uf, a, &steps) == find_root(uf, b, &steps);
+    container_stats_record(uf->stats, CONTAINER_OP_LOOKUP, steps, start);
+    return connected;
+}
+
+/* ============================================================================
+ *  LOCK-FREE UNION-FIND
+ * ============================================================================
+ *
+ * Invariant: parent[x] <= x. Linking only hooks a root under a smaller
+ * root, and compression only replaces a parent by one of its ancestors,
+ * so parents only ever decrease and no cycle can form.
+ */
+
+/**
+ * @brief Creates `element_count` singleton sets.
+ */
+Result atomic_union_find_create(Atomic_Union_Find *uf, u32 element_count)
+{
+    DS_ASSERT(uf != NULL, "Union-find must not be NULL");
+
+    *uf = (Atomic_Union_Find){0};
+    CHECK_RESULT(ARRAY_RESERVE(&uf->parent, element_count));
+    for(u32 i = 0; i < element_count; i++)
+        uf->parent.data[i] = i;
+    uf->parent.size = element_count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Frees the union-find storage.
+ */
+void atomic_union_find_destroy(Atomic_Union_Find *uf)
+{
+    if(!uf)
+        return;
+
+    ds_free(uf->parent.data);
+    *uf = (Atomic_Union_Find){0};
+}
+
+/**
+ * @brief Returns the current root of `element`.
+ *
+ * Each step tries to point the node at its grandparent. A failed CAS only
+ * means another thread changed that parent first, which is harmless.
+ */
+u32 atomic_union_find_find(Atomic_Union_Find *uf, u32 element)
+{
+    u32 *parent = uf->parent.data;
+    for(;;)
+    {
+        u32 p = __atomic_load_n(&parent[element], __ATOMIC_RELAXED);
+        if(p == element)
+            return element;
+
+        u32 grandparent = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+        if(p != grandparent)
+            __atomic_compare_exchange_n(&parent[element], &p, grandparent,
+                                        true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED);
+        element = grandparent;
+    }
+}
+
+/**
+ * @brief Merges the sets containing `a` and `b`.
+ *
+ * The larger root is hooked under the smaller one with a CAS that only
+ * succeeds while it still is a root; on failure the roots are looked up
+ * again.
+ *
+ * @return true if this call merged two distinct sets.
+ */
+bool atomic_union_find_unite(Atomic_Union_Find *uf, u32 a, u32 b)
+{
+    for(;;)
+    {
+        a = atomic_union_find_find(uf, a);
+        b = atomic_union_find_find(uf, b);
+        if(a == b)
+            return false;
+
+        if(a < b)
+        {
+            u32 swap = a;
+            a = b;
+            b = swap;
+        }
+
+        u32 expected = a;
+        if(__atomic_compare_exchange_n(&uf->parent.data[a], &expected, b,
+                                       false, __ATOMIC_RELAXED,
+                                       __ATOMIC_RELAXED))
+            return true;
+    }
+}
+
+/* ============================================================================
+ *  PARALLEL CONNECTED COMPONENTS
+ * ============================================================================
+ */
+
+/**
+ * @brief Shared state of a components computation.
+ */
+typedef struct
+{
+        Atomic_Union_Find uf;
+        const Edge_List *edges;
+        const CSR_Graph *graph;
+        u32 round;         // Afforest neighbor round
+        u32 skip;          // Afforest sampled component (or UINT32_MAX)
+        u32 *labels;
+        usize component_count;
+        bool invalid;
+} Components;
+
+static void link_edges_piece(usize begin, usize end, ptr context)
+{
+    Components *cc = (Components *)context;
+    u32 vertex_count = (u32)cc->uf.parent.size;
+
+    for(usize e = begin; e < end; e++)
+    {
+        u32 u = cc->edges->sources.data[e];
+        u32 v = cc->edges->targets.data[e];
+        if(u >= vertex_count || v >= vertex_count)
+        {
+            __atomic_store_n(&cc->invalid, true, __ATOMIC_RELAXED);
+            return;
+        }
+        atomic_union_find_unite(&cc->uf, u, v);
+    }
+}
+
+/**
+ * @brief Links the `round`-th neighbor of every vertex in [begin, end).
+ */
+static void link_round_piece(usize begin, usize end, ptr context)
+{
+    Components *cc = (Components *)context;
+    const CSR_Graph *graph = cc->graph;
+
+    for(usize u = begin; u < end; u++)
+    {
+        u64 e = graph->offsets.data[u] + cc->round;
+        if(e < graph->offsets.data[u + 1])
+            atomic_union_find_unite(&cc->uf, (u32)u, graph->neighbors.data[e]);
+    }
+}
+
+/**
+ * @brief Links the remaining neighbors of every vertex outside the sampled
+ *        component.
+ */
+static void link_rest_piece(usize begin, usize end, ptr context)
+{
+    Components *cc = (Components *)context;
+    const CSR_Graph *graph = cc->graph;
+
+    for(usize u = begin; u < end; u++)
+    {
+        if(atomic_union_find_find(&cc->uf, (u32)u) == cc->skip)
+            continue;
+
+        for(u64 e = graph->offsets.data[u] + cc->round;
+            e < graph->offsets.data[u + 1]; e++)
+            atomic_union_find_unite(&cc->uf, (u32)u, graph->neighbors.data[e]);
+    }
+}
+
+/**
+ * @brief Writes the root of every vertex and counts the roots.
+ */
+static void label_piece(usize begin, usize end, ptr context)
+{
+    Components *cc = (Components *)context;
+    usize roots = 0;
+
+    for(usize v = begin; v < end; v++)
+    {
+        u32 root = atomic_union_find_find(&cc->uf, (u32)v);
+        cc->labels[v] = root;
+        roots += root == v;
+    }
+    __atomic_fetch_add(&cc->component_count, roots, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Guesses the largest component from a deterministic sample.
+ */
+static u32 sample_largest_component(Components *cc)
+{
+    u32 vertex_count = (u32)cc->uf.parent.size;
+    u32 roots[AFFOREST_SAMPLES];
+    u32 counts[AFFOREST_SAMPLES];
+    usize distinct = 0;
+    u64 state = 0x9E3779B97F4A7C15ull;
+
+    for(usize i = 0; i < AFFOREST_SAMPLES; i++)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        u32 root = atomic_union_find_find(
+            &cc->uf, (u32)((state >> 33) % vertex_count));
+
+        usize j = 0;
+        while(j < distinct && roots[j] != root)
+            j++;
+        if(j == distinct)
+        {
+            roots[distinct] = root;
+            counts[distinct++] = 0;
+        }
+        counts[j]++;
+    }
+
+    usize best = 0;
+    for(usize j = 1; j < distinct; j++)
+    {
+        if(counts[j] > counts[best])
+            best = j;
+    }
+    return roots[best];
+}
+
+/**
+ * @brief Sizes the label array and runs the labeling pass.
+ */
+static Result finish_components(Components *cc, u32Array *labels,
+                                u32 *component_count)
+{
+    usize vertex_count = cc->uf.parent.size;
+    CHECK_RESULT(ARRAY_RESERVE(labels, vertex_count));
+    labels->size = vertex_count;
+    cc->labels = labels->data;
+    cc->component_count = 0;
+
+    CHECK_RESULT(ds_parallel_for(0, vertex_count, COMPONENTS_GRAIN,
+                                 label_piece, cc));
+    if(component_count)
+        *component_count = (u32)cc->component_count;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Connected components of the graph given as an edge list.
+ *
+ * @param vertex_count    Number of vertices.
+ * @param edges           Edge list (weights are ignored).
+ * @param labels          Output: smallest vertex id of each component.
+ * @param component_count Optional output: number of components.
+ * @return RESULT_SUCCESS, DS_ERROR_INDEX_OUT_OF_BOUNDS for an invalid edge,
+ *         or DS_ERROR_MEMORY_ALLOCATION.
+ */
+Result connected_components_edges(u32 vertex_count, const Edge_List *edges,
+                                  u32Array *labels, u32 *component_count)
+{
+    DS_ASSERT(edges != NULL && labels != NULL, "Arguments must not be NULL");
+    DS_ASSERT(edges->sources.size == edges->targets.size,
+              "Edge list sources and targets differ in length");
+
+    Components cc = {0};
+    cc.edges = edges;
+    CHECK_RESULT(atomic_union_find_create(&cc.uf, vertex_count));
+
+    Result result = ds_parallel_for(0, edges->sources.size, COMPONENTS_GRAIN,
+                                    link_edges_piece, &cc);
+    if(result_is_success(result) && cc.invalid)
+        result = RESULT_ERROR(DS_ERROR_INDEX_OUT_OF_BOUNDS,
+                              "Edge references a vertex out of range");
+    if(result_is_success(result))
+        result = finish_components(&cc, labels, component_count);
+
+    atomic_union_find_destroy(&cc.uf);
+    return result;
+}
+
+/**
+ * @brief Connected components of a CSR graph.
+ *
+ * @param graph           Graph to label.
+ * @param symmetric       True if every edge is stored in both directions,
+ *                        enabling the Afforest edge skipping.
+ * @param labels          Output: smallest vertex id of each component.
+ * @param component_count Optional output: number of components.
+ * @return RESULT_SUCCESS or DS_ERROR_MEMORY_ALLOCATION.
+ */
+Result connected_components_csr(const CSR_Graph *graph, bool symmetric,
+                                u32Array *labels, u32 *component_count)
+{
+    DS_ASSERT(graph != NULL && labels != NULL, "Arguments must not be NULL");
+
+    Components cc = {0};
+    cc.graph = graph;
+    cc.skip = UINT32_MAX;
+    CHECK_RESULT(atomic_union_find_create(&cc.uf, graph->vertex_count));
+
+    Result result = RESULT_SUCCESS;
+    if(symmetric && graph->vertex_count > 0)
+    {
+        for(cc.round = 0;
+            cc.round < AFFOREST_ROUNDS && result_is_success(result);
+            cc.round++)
+            result = ds_parallel_for(0, graph->vertex_count, COMPONENTS_GRAIN,
+                                     link_round_piece, &cc);
+        cc.skip = sample_largest_component(&cc);
+    }
+    else
+        cc.round = 0;
+
+    if(result_is_success(result))
+        result = ds_parallel_for(0, graph->vertex_count, COMPONENTS_GRAIN,
+                                 link_rest_piece, &cc);
+    if(result_is_success(result))
+        result = finish_components(&cc, labels, component_count);
+
+    atomic_union_find_destroy(&cc.uf);
+    return result;
+}
@@ -80,6 +80,83 @@ int compare_char(cptr a, cptr b)
     return (*a_char > *b_char) - (*a_char < *b_char);
 }
 
+/* ============================================================================
+ *  HASH FUNCTIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief FNV-1a 64-bit offset basis and prime.
+ */
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ull
+#define FNV_PRIME 0x100000001B3ull
+
+/**
+ * @brief Finalizer of SplitMix64: spreads every input bit over the
+ *        whole result, so sequential keys do not cluster in a table.
+ */
+static inline u64 mix64(u64 value)
+{
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Hashes an integer.
+ */
+u64 hash_int(cptr data, usize size)
+{
+    (void)size;
+    return mix64((u64)(u32)*(const int *)data);
+}
+
+/**
+ * @brief Hashes a float by its bit pattern (-0.0 hashes like 0.0).
+ */
+u64 hash_float(cptr data, usize size)
+{
+    (void)size;
+    float value = *(const float *)data;
+    u32 bits = 0;
+    if(value != 0.0f)
+        memcpy(&bits, &value, sizeof(bits));
+    return mix64(bits);
+}
+
+/**
+ * @brief Hashes a double by its bit pattern (-0.0 hashes like 0.0).
+ */
+u64 hash_double(cptr data, usize size)
+{
+    (void)size;
+    double value = *(const double *)data;
+    u64 bits = 0;
+    if(value != 0.0)
+        memcpy(&bits, &value, sizeof(bits));
+    return mix64(bits);
+}
+
+/**
+ * @brief Hashes a NUL-terminated string with FNV-1a.
+ *
+ * Consistent with compare_string(): the terminator ends the key and
+ * `size` is ignored.
+ */
+u64 hash_string(cptr data, usize size)
+{
+    (void)size;
+    u64 hash = FNV_OFFSET_BASIS;
+    for(const u8 *c = (const u8 *)data; *c != '\0'; c++)
+    {
+        hash ^= *c;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
 /* ============================================================================
  *  MATHEMATICAL UTILITIES
  * ============================================================================
@@ -0,0 +1,513 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // For fdatasync, nanosleep, O_DIRECTORY
+#endif
+
+#include "../include/wal.h"
+#include "../include/checksum.h"
+#include "../include/memory.h"
+#include "../include/trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================================
+ *  FILE HELPERS
+ * ============================================================================
+ */
+
+/**
+ * @brief Writes a whole buffer, retrying short and interrupted writes.
+ */
+static Result write_all(int fd, const byte *data, usize size)
+{
+    while(size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if(written < 0 && errno == EINTR)
+            continue;
+        if(written <= 0)
+            return RESULT_ERROR(DS_ERROR_IO, "Failed to write log");
+        data += written;
+        size -= (usize)written;
+    }
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Allocates 'path' followed by 'suffix'.
+ */
+static char *join_path(const char *path, const char *suffix)
+{
+    usize length = strlen(path);
+    usize extra = strlen(suffix);
+    char *joined = (char *)ds_malloc(length + extra + 1);
+    if(joined)
+    {
+        ds_memcpy(joined, path, length);
+        ds_memcpy(joined + length, suffix, extra + 1);
+    }
+    return joined;
+}
+
+/**
+ * @brief Flushes the directory entry of 'path' (after a rename).
+ */
+static Result sync_directory(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    usize length = slash ? (usize)(slash - path) + 1 : 1;
+    char *directory = (char *)ds_malloc(length + 1);
+    if(!directory)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate directory path");
+    ds_memcpy(directory, slash ? path : ".", length);
+    directory[length] = '\0';
+
+    Result result = RESULT_SUCCESS;
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if(fd < 0 || fsync(fd) != 0)
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to sync log directory");
+    if(fd >= 0)
+        close(fd);
+    ds_free(directory);
+    return result;
+}
+
+/**
+ * @brief CRC32C of a file header's fields before the checksum.
+ */
+static u32 file_header_checksum(const Wal_File_Header *header)
+{
+    return ds_crc32c(0, header, offsetof(Wal_File_Header, checksum));
+}
+
+/**
+ * @brief CRC32C of a record: its header after the checksum, then payload.
+ */
+static u32 record_checksum(const Wal_Record_Header *header, const byte *payload)
+{
+    const byte *fields = (const byte *)header + sizeof(header->checksum);
+    u32 crc = ds_crc32c(0, fields, sizeof(*header) - sizeof(header->checksum));
+    return ds_crc32c(crc, payload, (usize)header->size);
+}
+
+/**
+ * @brief Replaces the log at 'path' with an empty one starting at
+ *        'base_sequence', atomically, and opens it for appending.
+ */
+static Result create_log(const char *path, u64 base_sequence, int *fd)
+{
+    char *temporary = join_path(path, ".tmp");
+    if(!temporary)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate log path");
+
+    Wal_File_Header header = {WAL_MAGIC, base_sequence, WAL_VERSION, 0};
+    header.checksum = file_header_checksum(&header);
+
+    Result result = RESULT_SUCCESS;
+    int new_fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(new_fd < 0)
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to create log file");
+    if(result_is_success(result))
+        result = write_all(new_fd, (const byte *)&header, sizeof(header));
+    if(result_is_success(result) && fdatasync(new_fd) != 0)
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to sync log file");
+    if(result_is_success(result) && rename(temporary, path) != 0)
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to rename log file");
+    if(result_is_success(result))
+        result = sync_directory(path);
+
+    if(result_is_success(result))
+        *fd = new_fd;
+    else if(new_fd >= 0)
+    {
+        close(new_fd);
+        unlink(temporary);
+    }
+    ds_free(temporary);
+    return result;
+}
+
+/* ============================================================================
+ *  RECOVERY
+ * ============================================================================
+ */
+
+/**
+ * @brief Whether an intact record with a sequence number of at least
+ *        `sequence` starts anywhere in data[offset, size).
+ */
+static bool has_later_record(const byte *data, usize size, usize offset,
+                             u64 sequence)
+{
+    for(; size - offset >= sizeof(Wal_Record_Header); offset++)
+    {
+        Wal_Record_Header record;
+        ds_memcpy(&record, data + offset, sizeof(record));
+        if(record.sequence >= sequence &&
+           record.sequence - sequence < size - offset &&
+           record.size <= size - offset - sizeof(record) &&
+           record.checksum ==
+               record_checksum(&record, data + offset + sizeof(record)))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Whether a record that does not check out at `offset` can be the
+ *        torn tail left by a crash while appending.
+ *
+ * It cannot if an intact later record follows it, or if its size fits in
+ * the file and anything but zeros (preallocated space) comes after it:
+ * the log was then damaged in the middle.
+ */
+static bool is_torn_tail(const byte *data, usize size, usize offset,
+                         const Wal_Record_Header *record, u64 sequence)
+{
+    if(has_later_record(data, size, offset + 1, sequence + 1))
+        return false;
+
+    usize remaining = size - offset - sizeof(*record);
+    if(record->size > remaining)
+        return true;
+    for(usize i = offset + sizeof(*record) + (usize)record->size; i < size;
+        i++)
+        if(data[i] != 0)
+            return false;
+    return true;
+}
+
+/**
+ * @brief Replays the intact records of a mapped log.
+ *
+ * @param end  Receives the offset just past the last intact record.
+ * @param next Receives the sequence number of the next record.
+ */
+static Result replay_records(const byte *data, usize size, u64 after_sequence,
+                             wal_replay_fn replay, ptr context, usize *end,
+                             u64 *next)
+{
+    Wal_File_Header header;
+    ds_memcpy(&header, data, sizeof(header));
+    if(header.magic != WAL_MAGIC || header.version != WAL_VERSION ||
+       header.checksum != file_header_checksum(&header))
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA, "Log header is invalid");
+    if(header.base_sequence == 0 || header.base_sequence > after_sequence + 1)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Log does not continue the snapshot");
+
+    usize offset = sizeof(header);
+    u64 sequence = header.base_sequence;
+    while(size - offset >= sizeof(Wal_Record_Header))
+    {
+        // A crash while appending leaves a partial record (or zeros) at the
+        // tail, which ends the log; a bad record with data after it does
+        // not come from a crash.
+        Wal_Record_Header record;
+        ds_memcpy(&record, data + offset, sizeof(record));
+        const byte *payload = data + offset + sizeof(record);
+        if(record.sequence != sequence ||
+           record.size > size - offset - sizeof(record) ||
+           record.checksum != record_checksum(&record, payload))
+        {
+            if(!is_torn_tail(data, size, offset, &record, sequence))
+                return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                    "Log record is corrupted before the tail");
+            break;
+        }
+
+        if(sequence > after_sequence && replay)
+            CHECK_RESULT(
+                replay(context, record.type, payload, (usize)record.size));
+        offset += sizeof(record) + (usize)record.size;
+        sequence++;
+    }
+
+    if(sequence <= after_sequence)
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                            "Log ends before the snapshot");
+    *end = offset;
+    *next = sequence;
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Replays an existing log and cuts off its torn tail.
+ */
+static Result recover_log(int fd, u64 after_sequence, wal_replay_fn replay,
+                          ptr context, u64 *next)
+{
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to stat log file");
+    usize size = (usize)info.st_size;
+    if(size < sizeof(Wal_File_Header))
+        return RESULT_ERROR(DS_ERROR_CORRUPTED_DATA, "Log file is truncated");
+
+    ptr data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to map log file");
+
+    usize end = 0;
+    Result result = replay_records((const byte *)data, size, after_sequence,
+                                   replay, context, &end, next);
+    munmap(data, size);
+
+    if(result_is_success(result) && end < size &&
+       (ftruncate(fd, (off_t)end) != 0 || fdatasync(fd) != 0))
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to truncate log tail");
+    if(result_is_success(result) && lseek(fd, (off_t)end, SEEK_SET) < 0)
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to seek log file");
+    return result;
+}
+
+/**
+ * @brief Opens or creates the log and replays it.
+ */
+Result wal_open(Wal *wal, const char *path, u64 after_sequence,
+                wal_replay_fn replay, ptr context, Wal_Options options)
+{
+    DS_ASSERT(wal != NULL && path != NULL, "Arguments must not be NULL");
+    *wal = (Wal){0};
+    wal->fd = -1;
+    wal->options = options;
+
+    wal->path = join_path(path, "");
+    if(!wal->path)
+        return RESULT_ERROR(DS_ERROR_MEMORY_ALLOCATION,
+                            "Failed to allocate log path");
+
+    Result result = RESULT_SUCCESS;
+    u64 next = after_sequence + 1;
+    wal->fd = open(path, O_RDWR);
+    if(wal->fd >= 0)
+        result = recover_log(wal->fd, after_sequence, replay, context, &next);
+    else if(errno == ENOENT)
+        result = create_log(path, next, &wal->fd);
+    else
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to open log file");
+
+    if(result_is_error(result))
+    {
+        if(wal->fd >= 0)
+            close(wal->fd);
+        ds_free(wal->path);
+        *wal = (Wal){0};
+        wal->fd = -1;
+        return result;
+    }
+
+    wal->next_sequence = next;
+    wal->durable_sequence = next;
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_cond_init(&wal->flushed, NULL);
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Makes every appended record durable and closes the log.
+ */
+Result wal_close(Wal *wal)
+{
+    if(!wal || !wal->path)
+        return RESULT_SUCCESS;
+
+    Result result = RESULT_SUCCESS;
+    if(wal->next_sequence > wal->durable_sequence)
+        result = wal_commit(wal, wal->next_sequence - 1);
+    if(close(wal->fd) != 0 && result_is_success(result))
+        result = RESULT_ERROR(DS_ERROR_IO, "Failed to close log file");
+
+    pthread_mutex_destroy(&wal->lock);
+    pthread_cond_destroy(&wal->flushed);
+    ds_free(wal->pending.data);
+    ds_free(wal->writing.data);
+    ds_free(wal->path);
+    *wal = (Wal){0};
+    wal->fd = -1;
+    return result;
+}
+
+/* ============================================================================
+ *  GROUP COMMIT
+ * ============================================================================
+ */
+
+/**
+ * @brief Writes a group of records and makes them durable.
+ */
+static Result write_group(Wal *wal, const byteArray *group)
+{
+    CHECK_RESULT(write_all(wal->fd, group->data, group->size));
+    if(!(wal->options.flags & WAL_NO_SYNC) && fdatasync(wal->fd) != 0)
+        return RESULT_ERROR(DS_ERROR_IO, "Failed to sync log");
+    return RESULT_SUCCESS;
+}
+
+/**
+ * @brief Writes every buffered record as one group. Called with the lock
+ *        held and no other flush running; the lock is released while
+ *        writing so that new records keep accumulating for the next group.
+ */
+static Result flush_group(Wal *wal)
+{
+    wal->flushing = true;
+    if(wal->options.commit_delay_us > 0)
+    {
+        struct timespec delay = {0, (long)wal->options.commit_delay_us * 1000};
+        pthread_mutex_unlock(&wal->lock);
+        nanosleep(&delay, NULL);
+        pthread_mutex_lock(&wal->lock);
+    }
+
+    byteArray group = wal->pending;
+    wal->pending = wal->writing;
+    wal->writing = group;
+    u64 target = wal->next_sequence;
+    pthread_mutex_unlock(&wal->lock);
+
+    Result result = write_group(wal, &group);
+
+    pthread_mutex_lock(&wal->lock);
+    wal->writing.size = 0;
+    wal->flushing = false;
+    if(result_is_success(result))
+    {
+        wal->durable_sequence = target;
+        wal->syncs++;
+    }
+    else
+        wal->failed = true;
+    pthread_cond_broadcast(&wal->flushed);
+    return result;
+}
+
+/**
+ * @brief Buffers one record.
+ */
+Result wal_append(Wal *wal, u32 type, cptr payload, usize size, u64 *sequence)
+{
+    DS_ASSERT(wal != NULL && wal->path != NULL, "Log must be open");
+    DS_ASSERT(payload != NULL || size == 0, "Payload must not be NULL");
+
+    Wal_Record_Header header = {0, type, 0, size};
+    pthread_mutex_lock(&wal->lock);
+    Result result = RESULT_SUCCESS;
+    if(wal->failed)
+        result = RESULT_ERROR(DS_ERROR_IO, "Log failed earlier");
+    if(result_is_success(result))
+        result = ARRAY_RESERVE(&wal->pending,
+                               wal->pending.size + sizeof(header) + size);
+    if(result_is_success(result))
+    {
+        header.sequence = wal->next_sequence++;
+        header.checksum = record_checksum(&header, (const byte *)payload);
+        byte *target = wal->pending.data + wal->pending.size;
+        ds_memcpy(target, &header, sizeof(header));
+        if(size > 0)
+            ds_memcpy(target + sizeof(header), payload, size);
+        wal->pending.size += sizeof(header) + size;
+        if(sequence)
+            *sequence = header.sequence;
+    }
+    pthread_mutex_unlock(&wal->lock);
+    return result;
+}
+
+/**
+ * @brief Waits until a record is durable, flushing a group if needed.
+ */
+Result wal_commit(Wal *wal, u64 sequence)
+{
+    DS_ASSERT(wal != NULL && wal->path != NULL, "Log must be open");
+
+    pthread_mutex_lock(&wal->lock);
+    Result result = RESULT_SUCCESS;
+    if(sequence >= wal->next_sequence)
+        result = RESULT_ERROR(DS_ERROR_INVALID_ARGUMENT,
+                              "Record has not been appended");
+    while(result_is_success(result) && wal->durable_sequence <= sequence)
+    {
+        if(wal->failed)
+            result = RESULT_ERROR(DS_ERROR_IO, "Log failed earlier");
+        else if(wal->flushing)
+            pthread_cond_wait(&wal->flushed, &wal->lock);
+        else
+            result = flush_group(wal);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    return result;
+}
+
+/**
+ * @brief Appends a record and waits until it is durable.
+ */
+Result wal_write(Wal *wal, u32 type, cptr payload, usize size)
+{
+    u64 sequence = 0;
+    CHECK_RESULT(wal_append(wal, type, payload, size, &sequence));
+    return wal_commit(wal, sequence);
+}
+
+/* ============================================================================
+ *  CHECKPOINTS
+ * ============================================================================
+ */
+
+/**
+ * @brief Saves the container through 'save' and resets the log.
+ */
+Result wal_checkpoint(Wal *wal, wal_checkpoint_fn save, ptr context)
+{
+    DS_ASSERT(wal != NULL && wal->path != NULL, "Log must be open");
+    DS_ASSERT(save != NULL, "Save function must not be NULL");
+
+    u64 span = trace_begin();
+
+    // The lock is held throughout, so no record can slip in between the
+    // last one made durable and the new log.
+    pthread_mutex_lock(&wal->lock);
+    while(wal->flushing)
+        pthread_cond_wait(&wal->flushed, &wal->lock);
+
+    Result result = RESULT_SUCCESS;
+    if(wal->failed)
+        result = RESULT_ERROR(DS_ERROR_IO, "Log failed earlier");
+    if(result_is_success(result) && wal->pending.size > 0)
+    {
+        result = write_group(wal, &wal->pending);
+        wal->pending.size = 0;
+        if(result_is_success(result))
+        {
+            wal->durable_sequence = wal->next_sequence;
+            wal->syncs++;
+        }
+        else
+            wal->failed = true;
+    }
+
+    u64 last = wal->next_sequence - 1;
+    if(result_is_success(result))
+        result = save(context, last);
+
+    int fd = -1;
+    if(result_is_success(result))
+        result = create_log(wal->path, last + 1, &fd);
+    if(result_is_success(result))
+    {
+        close(wal->fd);
+        wal->fd = fd;
+    }
+    pthread_cond_broadcast(&wal->flushed);
+    pthread_mutex_unlock(&wal->lock);
+    trace_end("wal_checkpoint", span, last);
+    return result;
+}
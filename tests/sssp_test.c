@@ -0,0 +1,82 @@
+#include "../include/memory.h"
+#include "../include/parallel.h"
+#include "../include/sssp.h"
+#include <stdio.h>
+
+// ============================================================================
+// Regression checks of csr_sssp() against csr_dijkstra(). See the Makefile
+// ("make check").
+// ============================================================================
+
+/**
+ * @brief Chain length: enough edges to take the delta-stepping path.
+ */
+#define CHAIN_EDGES (SSSP_SERIAL_EDGES + 4464)
+
+/**
+ * @brief Builds the chain 0 -> 1 -> ... with every edge weighing `weight`.
+ */
+static Result build_chain(CSR_Graph *graph, f64 weight)
+{
+    Edge_List edges = {0};
+    Result result = ARRAY_RESERVE(&edges.sources, CHAIN_EDGES);
+    if(result_is_success(result))
+        result = ARRAY_RESERVE(&edges.targets, CHAIN_EDGES);
+    if(result_is_success(result))
+        result = ARRAY_RESERVE(&edges.weights, CHAIN_EDGES);
+    if(result_is_success(result))
+    {
+        for(u32 i = 0; i < CHAIN_EDGES; i++)
+        {
+            edges.sources.data[i] = i;
+            edges.targets.data[i] = i + 1;
+            edges.weights.data[i] = weight;
+        }
+        edges.sources.size = edges.targets.size = edges.weights.size =
+            CHAIN_EDGES;
+        result = csr_graph_build(graph, CHAIN_EDGES + 1, &edges,
+                                 CSR_BUILD_DEFAULT);
+    }
+
+    ds_free(edges.sources.data);
+    ds_free(edges.targets.data);
+    ds_free(edges.weights.data);
+    return result;
+}
+
+/**
+ * @brief Runs both searches on a chain and compares the distances.
+ */
+static Result check_chain(const char *name, f64 weight, f64 delta)
+{
+    CSR_Graph graph = {0};
+    f64Array expected = {0}, actual = {0};
+    Result result = build_chain(&graph, weight);
+    if(result_is_success(result))
+        result = csr_dijkstra(&graph, 0, &expected, NULL);
+    if(result_is_success(result))
+        result = csr_sssp(&graph, 0, delta, &actual, NULL);
+
+    for(usize v = 0; result_is_success(result) && v < expected.size; v++)
+        if(actual.data[v] != expected.data[v])
+            result = RESULT_ERROR(DS_ERROR_CORRUPTED_DATA,
+                                  "Distances differ from Dijkstra");
+
+    printf("%-40s %s\n", name, result_is_success(result) ? "ok" : "FAILED");
+    csr_graph_destroy(&graph);
+    ds_free(expected.data);
+    ds_free(actual.data);
+    return result;
+}
+
+int main(void)
+{
+    ds_parallel_set_thread_count(4);
+
+    bool passed = true;
+    passed &= result_is_success(check_chain("sssp/chain/unit", 1.0, 1.0));
+    passed &= result_is_success(check_chain("sssp/chain/mean", 3.0, 0.0));
+    // Delta far below the spacing of doubles around the distances.
+    passed &= result_is_success(check_chain("sssp/chain/heavy", 1e17, 1.0));
+    return passed ? 0 : 1;
+}